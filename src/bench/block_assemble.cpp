@@ -8,6 +8,7 @@
 #include <consensus/merkle.h>
 #include <consensus/validation.h>
 #include <miner.h>
+#include <names/snapshot.h>
 #include <policy/policy.h>
 #include <pow.h>
 #include <scheduler.h>
@@ -116,6 +117,10 @@ static void AssembleBlock(benchmark::State& state)
     thread_group.join_all();
     GetMainSignals().FlushBackgroundCallbacks();
     GetMainSignals().UnregisterBackgroundSignalScheduler();
+    {
+        LOCK(::cs_main);
+        ResetNameStateSnapshot();
+    }
 }
 
 BENCHMARK(AssembleBlock, 700);
@@ -0,0 +1,83 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <script/names.h>
+#include <txmempool.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+static const size_t NUM_NAMES = 500;
+
+static CTransactionRef NameTx(const CScript& script)
+{
+    CMutableTransaction tx;
+    tx.SetNamecoin();
+    tx.vout.emplace_back(COIN, script);
+    return MakeTransactionRef(tx);
+}
+
+// Non-name child spending the name output, so that conflicts have descendants.
+static CTransactionRef ChildTx(const CTransactionRef& parent)
+{
+    CMutableTransaction tx;
+    tx.vin.emplace_back(COutPoint(parent->GetHash(), 0));
+    tx.vout.emplace_back(COIN, CScript() << OP_TRUE);
+    return MakeTransactionRef(tx);
+}
+
+static void AddTx(const CTransactionRef& tx, CTxMemPool& pool) EXCLUSIVE_LOCKS_REQUIRED(pool.cs)
+{
+    LockPoints lp;
+    pool.addUnchecked(CTxMemPoolEntry(tx, 1000, 0, 1, false, 4, lp));
+}
+
+// A reorg over a mempool full of pending name registrations and updates, each
+// with a child: the connected block registers half of the names pending
+// registration and expires all names pending update, and disconnecting a block
+// unexpires the other half of the registered names. Every pending name
+// operation ends up removed as a conflict.
+static void NameMempoolReorg(benchmark::State& state)
+{
+    const CScript addr = CScript() << OP_TRUE;
+    const valtype value(10, 'v');
+    const valtype rand(20, 'r');
+    const valtype otherRand(20, 's');
+
+    std::vector<CTransactionRef> pending;
+    std::vector<CTransactionRef> block;
+    std::set<valtype> expired;
+    std::set<valtype> unexpired;
+    for (size_t i = 0; i < NUM_NAMES; ++i) {
+        const std::string str = "d/name-" + std::to_string(i);
+        const valtype reg(str.begin(), str.end());
+        const valtype upd(str.rbegin(), str.rend());
+
+        pending.push_back(NameTx(CNameScript::buildNameFirstupdate(addr, reg, value, rand)));
+        pending.push_back(ChildTx(pending.back()));
+        pending.push_back(NameTx(CNameScript::buildNameUpdate(addr, upd, value)));
+        pending.push_back(ChildTx(pending.back()));
+
+        if (i % 2 == 0)
+            block.push_back(NameTx(CNameScript::buildNameFirstupdate(addr, reg, value, otherRand)));
+        else
+            unexpired.insert(reg);
+        expired.insert(upd);
+    }
+
+    CTxMemPool pool;
+    LOCK(pool.cs);
+    while (state.KeepRunning()) {
+        for (const auto& tx : pending)
+            AddTx(tx, pool);
+
+        pool.removeForBlock(block, 2, expired);
+        pool.removeUnexpireConflicts(unexpired);
+        assert(pool.size() == 0);
+    }
+}
+
+BENCHMARK(NameMempoolReorg, 50);
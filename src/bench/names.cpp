@@ -0,0 +1,237 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <arith_uint256.h>
+#include <bench/bench.h>
+#include <chainparams.h>
+#include <coins.h>
+#include <consensus/validation.h>
+#include <names/common.h>
+#include <names/main.h>
+#include <script/names.h>
+#include <tinyformat.h>
+#include <txdb.h>
+#include <undo.h>
+
+#include <cassert>
+#include <memory>
+#include <set>
+#include <vector>
+
+// Height at which the names of the synthetic databases were last updated.
+// On regtest they expire 30 blocks later.
+static const unsigned NAME_HEIGHT = 1000;
+static const unsigned NAME_EXPIRY_HEIGHT = NAME_HEIGHT + 30;
+// Number of name operations in one synthetic block.
+static const size_t BLOCK_NAMES = 1000;
+
+static valtype BenchName(size_t i)
+{
+    const std::string str = strprintf("d/bench-%08u", i);
+    return valtype(str.begin(), str.end());
+}
+
+static COutPoint BenchOutPoint(size_t i)
+{
+    return COutPoint(ArithToUint256(arith_uint256(i + 1)), 0);
+}
+
+static CScript BenchAddress()
+{
+    return CScript() << OP_TRUE;
+}
+
+/**
+ * In-memory chainstate with a given number of names, all last updated at
+ * NAME_HEIGHT, together with the coins of their last updates.
+ */
+static std::unique_ptr<CCoinsViewDB> NameBenchDB(size_t numNames)
+{
+    SelectParams(CBaseChainParams::REGTEST);
+    std::unique_ptr<CCoinsViewDB> db(new CCoinsViewDB(1 << 23, true));
+
+    const valtype value(40, 'v');
+    CCoinsViewCache cache(db.get());
+    for (size_t i = 0; i < numNames; ++i) {
+        const valtype name = BenchName(i);
+        const CScript script = CNameScript::buildNameUpdate(BenchAddress(), name, value);
+        const COutPoint out = BenchOutPoint(i);
+        cache.AddCoin(out, Coin(CTxOut(COIN, script), NAME_HEIGHT, false), false);
+
+        CNameData data;
+        data.fromScript(NAME_HEIGHT, out, CNameScript(script));
+        cache.SetName(name, data, false);
+
+        // Keep the cache of the initial load small.
+        if (i % 100000 == 99999) {
+            bool flushed = cache.Flush();
+            assert(flushed);
+        }
+    }
+    cache.SetBestBlock(BenchOutPoint(numNames).hash);
+    bool flushed = cache.Flush();
+    assert(flushed);
+
+    return db;
+}
+
+// Update transaction of name i, spending the coin of its last update.
+static CTransactionRef NameUpdateTx(size_t i, const valtype& value)
+{
+    CMutableTransaction tx;
+    tx.SetNamecoin();
+    tx.vin.emplace_back(BenchOutPoint(i));
+    tx.vout.emplace_back(COIN, CNameScript::buildNameUpdate(BenchAddress(), BenchName(i), value));
+    return MakeTransactionRef(tx);
+}
+
+static void NameCheckTransaction(benchmark::State& state)
+{
+    const auto db = NameBenchDB(BLOCK_NAMES);
+    CCoinsViewCache view(db.get());
+
+    std::vector<CTransactionRef> txs;
+    for (size_t i = 0; i < BLOCK_NAMES; ++i)
+        txs.push_back(NameUpdateTx(i, valtype(40, 'w')));
+
+    while (state.KeepRunning()) {
+        for (const auto& tx : txs) {
+            CValidationState valState;
+            bool ok = CheckNameTransaction(*tx, NAME_HEIGHT + 1, view, valState, 0);
+            assert(ok);
+        }
+    }
+}
+
+template <size_t DB_NAMES>
+static void NameApplyTransactions(benchmark::State& state)
+{
+    const auto db = NameBenchDB(DB_NAMES);
+
+    std::vector<CTransactionRef> txs;
+    for (size_t i = 0; i < BLOCK_NAMES; ++i)
+        txs.push_back(NameUpdateTx(i * (DB_NAMES / BLOCK_NAMES), valtype(40, 'w')));
+
+    while (state.KeepRunning()) {
+        CCoinsViewCache view(db.get());
+        CBlockUndo undo;
+        for (const auto& tx : txs)
+            ApplyNameTransaction(*tx, NAME_HEIGHT + 1, view, undo);
+    }
+}
+
+// All names of the database expire in one block, which is then disconnected.
+template <size_t DB_NAMES>
+static void NameExpireUnexpire(benchmark::State& state)
+{
+    const auto db = NameBenchDB(DB_NAMES);
+
+    while (state.KeepRunning()) {
+        CCoinsViewCache view(db.get());
+        CBlockUndo undo;
+        std::set<valtype> names;
+        bool ok = ExpireNames(NAME_EXPIRY_HEIGHT, view, undo, names);
+        assert(ok && names.size() == DB_NAMES);
+        ok = UnexpireNames(NAME_EXPIRY_HEIGHT, undo, view, names);
+        assert(ok && names.size() == DB_NAMES);
+    }
+}
+
+// Write the name changes of a block through CCoinsViewDB::BatchWrite.
+template <size_t DB_NAMES>
+static void NameCacheFlush(benchmark::State& state)
+{
+    const auto db = NameBenchDB(DB_NAMES);
+
+    const valtype value(40, 'w');
+    unsigned height = NAME_HEIGHT;
+    while (state.KeepRunning()) {
+        CCoinsViewCache view(db.get());
+        ++height;
+        for (size_t i = 0; i < BLOCK_NAMES; ++i) {
+            const size_t idx = i * (DB_NAMES / BLOCK_NAMES);
+            CNameData data;
+            data.fromScript(height, BenchOutPoint(idx),
+                            CNameScript(CNameScript::buildNameUpdate(BenchAddress(), BenchName(idx), value)));
+            view.SetName(BenchName(idx), data, false);
+        }
+        bool flushed = view.Flush();
+        assert(flushed);
+    }
+}
+
+// Iterate all names of the database through a cache holding the changes of a
+// block, so that the cached changes are merged into the database iteration.
+template <size_t DB_NAMES>
+static void NameIterate(benchmark::State& state)
+{
+    const auto db = NameBenchDB(DB_NAMES);
+
+    CCoinsViewCache view(db.get());
+    const valtype value(40, 'w');
+    for (size_t i = 0; i < BLOCK_NAMES; ++i) {
+        const size_t idx = i * (DB_NAMES / BLOCK_NAMES);
+        if (i % 2 == 0) {
+            view.DeleteName(BenchName(idx));
+            continue;
+        }
+        CNameData data;
+        data.fromScript(NAME_HEIGHT + 1, BenchOutPoint(idx),
+                        CNameScript(CNameScript::buildNameUpdate(BenchAddress(), BenchName(idx), value)));
+        view.SetName(BenchName(idx), data, false);
+    }
+
+    while (state.KeepRunning()) {
+        std::unique_ptr<CNameIterator> iter(view.IterateNames());
+        iter->seek(valtype());
+        size_t count = 0;
+        valtype name;
+        CNameData data;
+        while (iter->next(name, data))
+            ++count;
+        assert(count == DB_NAMES - BLOCK_NAMES / 2);
+    }
+}
+
+// The prefix scan that name_scan and name_filter use for anchored queries.
+// The prefix matches 100 names, independently of the database size.
+template <size_t DB_NAMES>
+static void NameScanPrefix(benchmark::State& state)
+{
+    const auto db = NameBenchDB(DB_NAMES);
+    const std::string prefixStr = "d/bench-000001";
+    const valtype prefix(prefixStr.begin(), prefixStr.end());
+
+    while (state.KeepRunning()) {
+        CNamePrefixIterator iter(db->IterateNames(), prefix);
+        iter.seek(valtype());
+        size_t count = 0;
+        valtype name;
+        CNameData data;
+        while (iter.next(name, data))
+            ++count;
+        assert(count == 100);
+    }
+}
+
+static void NameApplyTransactions10k(benchmark::State& state) { NameApplyTransactions<10000>(state); }
+static void NameApplyTransactions100k(benchmark::State& state) { NameApplyTransactions<100000>(state); }
+static void NameExpireUnexpire10k(benchmark::State& state) { NameExpireUnexpire<10000>(state); }
+static void NameCacheFlush10k(benchmark::State& state) { NameCacheFlush<10000>(state); }
+static void NameCacheFlush100k(benchmark::State& state) { NameCacheFlush<100000>(state); }
+static void NameIterate10k(benchmark::State& state) { NameIterate<10000>(state); }
+static void NameIterate100k(benchmark::State& state) { NameIterate<100000>(state); }
+static void NameScanPrefix10k(benchmark::State& state) { NameScanPrefix<10000>(state); }
+static void NameScanPrefix100k(benchmark::State& state) { NameScanPrefix<100000>(state); }
+
+BENCHMARK(NameCheckTransaction, 100);
+BENCHMARK(NameApplyTransactions10k, 100);
+BENCHMARK(NameApplyTransactions100k, 100);
+BENCHMARK(NameExpireUnexpire10k, 10);
+BENCHMARK(NameCacheFlush10k, 100);
+BENCHMARK(NameCacheFlush100k, 100);
+BENCHMARK(NameIterate10k, 20);
+BENCHMARK(NameIterate100k, 2);
+BENCHMARK(NameScanPrefix10k, 1000);
+BENCHMARK(NameScanPrefix100k, 1000);
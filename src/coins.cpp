@@ -12,7 +12,10 @@ uint256 CCoinsView::GetBestBlock() const { return uint256(); }
 std::vector<uint256> CCoinsView::GetHeadBlocks() const { return std::vector<uint256>(); }
 bool CCoinsView::GetName(const valtype &name, CNameData &data) const { return false; }
 bool CCoinsView::GetNameHistory(const valtype &name, CNameHistory &data) const { return false; }
+bool CCoinsView::GetNameHistoryInfo(const valtype &name, CNameHistoryInfo &info) const { return false; }
+bool CCoinsView::GetNameHistoryEntry(const valtype &name, uint32_t idx, CNameData &data) const { return false; }
 bool CCoinsView::GetNamesForHeight(unsigned nHeight, std::set<valtype>& names) const { return false; }
+bool CCoinsView::GetNamesForHeights(unsigned nFromHeight, unsigned nToHeight, std::set<CNameCache::ExpireEntry>& entries) const { return false; }
 CNameIterator* CCoinsView::IterateNames() const { assert (false); }
 bool CCoinsView::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, const CNameCache &names) { return false; }
 CCoinsViewCursor *CCoinsView::Cursor() const { return nullptr; }
@@ -31,7 +34,10 @@ uint256 CCoinsViewBacked::GetBestBlock() const { return base->GetBestBlock(); }
 std::vector<uint256> CCoinsViewBacked::GetHeadBlocks() const { return base->GetHeadBlocks(); }
 bool CCoinsViewBacked::GetName(const valtype &name, CNameData &data) const { return base->GetName(name, data); }
 bool CCoinsViewBacked::GetNameHistory(const valtype &name, CNameHistory &data) const { return base->GetNameHistory(name, data); }
+bool CCoinsViewBacked::GetNameHistoryInfo(const valtype &name, CNameHistoryInfo &info) const { return base->GetNameHistoryInfo(name, info); }
+bool CCoinsViewBacked::GetNameHistoryEntry(const valtype &name, uint32_t idx, CNameData &data) const { return base->GetNameHistoryEntry(name, idx, data); }
 bool CCoinsViewBacked::GetNamesForHeight(unsigned nHeight, std::set<valtype>& names) const { return base->GetNamesForHeight(nHeight, names); }
+bool CCoinsViewBacked::GetNamesForHeights(unsigned nFromHeight, unsigned nToHeight, std::set<CNameCache::ExpireEntry>& entries) const { return base->GetNamesForHeights(nFromHeight, nToHeight, entries); }
 CNameIterator* CCoinsViewBacked::IterateNames() const { return base->IterateNames(); }
 void CCoinsViewBacked::SetBackend(CCoinsView &viewIn) { base = &viewIn; }
 bool CCoinsViewBacked::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, const CNameCache &names) { return base->BatchWrite(mapCoins, hashBlock, names); }
@@ -44,7 +50,7 @@ SaltedOutpointHasher::SaltedOutpointHasher() : k0(GetRand(std::numeric_limits<ui
 CCoinsViewCache::CCoinsViewCache(CCoinsView *baseIn) : CCoinsViewBacked(baseIn), cachedCoinsUsage(0) {}
 
 size_t CCoinsViewCache::DynamicMemoryUsage() const {
-    return memusage::DynamicUsage(cacheCoins) + cachedCoinsUsage;
+    return memusage::DynamicUsage(cacheCoins) + cachedCoinsUsage + cacheNames.DynamicMemoryUsage();
 }
 
 CCoinsMap::iterator CCoinsViewCache::FetchCoin(const COutPoint &outpoint) const {
@@ -166,13 +172,47 @@ bool CCoinsViewCache::GetName(const valtype &name, CNameData& data) const {
 }
 
 bool CCoinsViewCache::GetNameHistory(const valtype &name, CNameHistory& data) const {
-    if (cacheNames.getHistory(name, data))
+    CNameHistoryInfo info;
+    if (!GetNameHistoryInfo(name, info) || info.empty())
+        return false;
+
+    /* Read the entries of the base view and apply the cached changes
+       on top of them.  */
+    std::map<uint32_t, CNameData> entries;
+    CNameHistory baseHistory;
+    if (base->GetNameHistory(name, baseHistory)) {
+        uint32_t idx = baseHistory.getEnd() - baseHistory.getData().size();
+        for (const auto& entry : baseHistory.getData())
+            entries.emplace(idx++, entry);
+    }
+    cacheNames.updateHistory(name, entries);
+
+    std::vector<CNameData> stored;
+    stored.reserve(info.nStored);
+    for (uint32_t idx = info.first(); idx < info.nEnd; ++idx) {
+        const auto it = entries.find(idx);
+        assert(it != entries.end());
+        stored.push_back(it->second);
+    }
+
+    data = CNameHistory(info.nEnd, std::move(stored));
+    return true;
+}
+
+bool CCoinsViewCache::GetNameHistoryInfo(const valtype &name, CNameHistoryInfo& info) const {
+    if (cacheNames.getHistoryInfo(name, info))
         return true;
 
-    /* Note: This does not attempt to cache backend queries.  The cache
-       only keeps track of changes!  */
+    return base->GetNameHistoryInfo(name, info);
+}
+
+bool CCoinsViewCache::GetNameHistoryEntry(const valtype &name, uint32_t idx, CNameData& data) const {
+    if (cacheNames.isHistoryEntryErased(name, idx))
+        return false;
+    if (cacheNames.getHistoryEntry(name, idx, data))
+        return true;
 
-    return base->GetNameHistory(name, data);
+    return base->GetNameHistoryEntry(name, idx, data);
 }
 
 bool CCoinsViewCache::GetNamesForHeight(unsigned nHeight, std::set<valtype>& names) const {
@@ -186,6 +226,14 @@ bool CCoinsViewCache::GetNamesForHeight(unsigned nHeight, std::set<valtype>& nam
     return true;
 }
 
+bool CCoinsViewCache::GetNamesForHeights(unsigned nFromHeight, unsigned nToHeight, std::set<CNameCache::ExpireEntry>& entries) const {
+    if (!base->GetNamesForHeights(nFromHeight, nToHeight, entries))
+        return false;
+
+    cacheNames.updateNamesForHeights(nFromHeight, nToHeight, entries);
+    return true;
+}
+
 CNameIterator* CCoinsViewCache::IterateNames() const {
     return cacheNames.iterateNames(base->IterateNames());
 }
@@ -208,20 +256,40 @@ void CCoinsViewCache::SetName(const valtype &name, const CNameData& data, bool u
            for the name history.  */
         if (fNameHistory)
         {
-            CNameHistory history;
-            if (!GetNameHistory(name, history))
-            {
-                /* Ensure that the history stack is indeed (still) empty
-                   and was not modified by the failing GetNameHistory call.  */
-                assert(history.empty());
-            }
+            CNameHistoryInfo info;
+            if (!GetNameHistoryInfo(name, info))
+                assert(info.empty());
 
             if (undo)
-                history.pop(data);
+            {
+                /* The top entry may have been pruned already, then there
+                   is nothing to check against.  */
+                assert(!info.empty());
+                if (info.nStored > 0)
+                {
+                    CNameData top;
+                    assert(GetNameHistoryEntry(name, info.nEnd - 1, top));
+                    assert(top == data);
+                    cacheNames.eraseHistoryEntry(name, info.nEnd - 1);
+                    --info.nStored;
+                }
+                --info.nEnd;
+            }
             else
-                history.push(oldData);
+            {
+                cacheNames.writeHistoryEntry(name, info.nEnd, oldData);
+                ++info.nEnd;
+                ++info.nStored;
+
+                /* Prune the oldest entries beyond the configured depth.  */
+                while (nNameHistoryDepth > 0 && info.nStored > nNameHistoryDepth)
+                {
+                    cacheNames.eraseHistoryEntry(name, info.first());
+                    --info.nStored;
+                }
+            }
 
-            cacheNames.setHistory(name, history);
+            cacheNames.setHistoryInfo(name, info);
         }
     } else
         assert (!undo);
@@ -240,8 +308,8 @@ void CCoinsViewCache::DeleteName(const valtype &name) {
     if (fNameHistory)
     {
         /* When deleting a name, the history should already be clean.  */
-        CNameHistory history;
-        assert (!GetNameHistory(name, history) || history.empty());
+        CNameHistoryInfo info;
+        assert (!GetNameHistoryInfo(name, info) || info.empty());
     }
 
     cacheNames.remove(name);
@@ -170,9 +170,18 @@ public:
     // Get a name's history (if it exists)
     virtual bool GetNameHistory(const valtype& name, CNameHistory& data) const;
 
+    // Get which history entries of a name exist (if it has history)
+    virtual bool GetNameHistoryInfo(const valtype& name, CNameHistoryInfo& info) const;
+
+    // Get a single entry of a name's history (if it is stored)
+    virtual bool GetNameHistoryEntry(const valtype& name, uint32_t idx, CNameData& data) const;
+
     // Query for names that were updated at the given height
     virtual bool GetNamesForHeight(unsigned nHeight, std::set<valtype>& names) const;
 
+    // Query for names that were updated at heights in [nFromHeight, nToHeight]
+    virtual bool GetNamesForHeights(unsigned nFromHeight, unsigned nToHeight, std::set<CNameCache::ExpireEntry>& entries) const;
+
     // Get a name iterator.
     virtual CNameIterator* IterateNames() const;
 
@@ -208,7 +217,10 @@ public:
     std::vector<uint256> GetHeadBlocks() const override;
     bool GetName(const valtype& name, CNameData& data) const override;
     bool GetNameHistory(const valtype& name, CNameHistory& data) const override;
+    bool GetNameHistoryInfo(const valtype& name, CNameHistoryInfo& info) const override;
+    bool GetNameHistoryEntry(const valtype& name, uint32_t idx, CNameData& data) const override;
     bool GetNamesForHeight(unsigned nHeight, std::set<valtype>& names) const override;
+    bool GetNamesForHeights(unsigned nFromHeight, unsigned nToHeight, std::set<CNameCache::ExpireEntry>& entries) const override;
     CNameIterator* IterateNames() const override;
     void SetBackend(CCoinsView &viewIn);
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, const CNameCache &names) override;
@@ -230,7 +242,6 @@ protected:
     mutable CCoinsMap cacheCoins;
 
     /* Cached dynamic memory usage for the inner Coin objects. */
-    /* TODO: Sum up also name cache usage.  */
     mutable size_t cachedCoinsUsage;
 
     /** Name changes cache.  */
@@ -251,7 +262,10 @@ public:
     void SetBestBlock(const uint256 &hashBlock);
     bool GetName(const valtype &name, CNameData &data) const override;
     bool GetNameHistory(const valtype &name, CNameHistory &data) const override;
+    bool GetNameHistoryInfo(const valtype &name, CNameHistoryInfo &info) const override;
+    bool GetNameHistoryEntry(const valtype &name, uint32_t idx, CNameData &data) const override;
     bool GetNamesForHeight(unsigned nHeight, std::set<valtype>& names) const override;
+    bool GetNamesForHeights(unsigned nFromHeight, unsigned nToHeight, std::set<CNameCache::ExpireEntry>& entries) const override;
     CNameIterator* IterateNames() const override;
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, const CNameCache &names) override;
     CCoinsViewCursor* Cursor() const override {
@@ -261,6 +275,7 @@ public:
     /* Changes to the name database.  */
     void SetName(const valtype &name, const CNameData &data, bool undo);
     void DeleteName(const valtype &name);
+    const CNameCache& GetNameChanges() const { return cacheNames; }
 
     /**
      * Check if we have the given utxo already loaded in this cache.
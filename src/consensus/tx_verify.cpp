@@ -282,7 +282,7 @@ bool Consensus::CheckTxInputs(const CTransaction& tx, CValidationState& state, c
         if (nValueIn < value_out)
         {
             //LogPrintf("nValueIn < value_out\n");
-            correctBetTx=modulo::ver_1::txGetBetVerify(nSpendHeight, tx, nValueIn, value_out, betFee);
+            correctBetTx=modulo::ver_1::txGetBetVerify(nSpendHeight, inputs, tx, nValueIn, value_out, betFee);
             if(!correctBetTx)
             {
                 return state.DoS(100, false, REJECT_INVALID, "bad-txns-in-belowout", false,
@@ -319,7 +319,7 @@ bool Consensus::CheckTxInputs(const CTransaction& tx, CValidationState& state, c
             return state.DoS(100, false, REJECT_INVALID, "bad-getbetformat", false, "not all inputs are getbets");
         }
         else {
-            if(modulo::ver_1::txGetBetVerify(nSpendHeight, tx, nValueIn, value_out, betFee))
+            if(modulo::ver_1::txGetBetVerify(nSpendHeight, inputs, tx, nValueIn, value_out, betFee))
             {
                 correctBetTx = true;
                 txfee_aux=betFee;
@@ -6,6 +6,7 @@
 #include <iomanip>
 
 #include <data/datautils.h>
+#include <rpc/server.h>
 
 static unsigned char hexval(unsigned char c)
 {
@@ -100,15 +101,15 @@ std::string double2str(double val)
     return strs.str();
 }
 
-std::string computeChange(const UniValue& inputs, double fee)
+CAmount computeChange(const UniValue& inputs, CAmount fee)
 {
-    double amount=0.0;
+    CAmount amount=0;
     for(size_t i=0; i<inputs.size(); ++i)
     {
-        amount+=inputs[i][std::string("amount")].get_real();
+        amount+=AmountFromValue(inputs[i][std::string("amount")]);
     }
 
-    return double2str(amount-fee);
+    return amount-fee;
 }
 
 void reverseEndianess(std::string& str)
@@ -126,3 +127,55 @@ void reverseEndianess(std::string& str)
 	}
 	str.swap(tmp);
 }
+
+bool getOpReturnData(const CScript& script, Span<const unsigned char>& data)
+{
+    data=Span<const unsigned char>();
+
+    CScript::const_iterator pc=script.begin();
+    opcodetype opcode;
+    if(!script.GetOp(pc, opcode) || opcode!=OP_RETURN)
+    {
+        return false;
+    }
+
+    const size_t pushPos=pc-script.begin();
+    if(!script.GetOp(pc, opcode) || opcode>OP_PUSHDATA4 || pc!=script.end())
+    {
+        return false;
+    }
+
+    size_t headerSize=1;
+    if(opcode==OP_PUSHDATA1)
+    {
+        headerSize=2;
+    }
+    else if(opcode==OP_PUSHDATA2)
+    {
+        headerSize=3;
+    }
+    else if(opcode==OP_PUSHDATA4)
+    {
+        headerSize=5;
+    }
+
+    const unsigned char* payload=script.data()+pushPos+headerSize;
+    data=Span<const unsigned char>(payload, script.data()+script.size());
+    return true;
+}
+
+bool getOpReturnData(const CTransaction& tx, Span<const unsigned char>& data, size_t& idx)
+{
+    data=Span<const unsigned char>();
+    idx=0;
+    for(size_t i=0;i<tx.vout.size();++i)
+    {
+        const CScript& script=tx.vout[i].scriptPubKey;
+        if(!script.empty() && script[0]==OP_RETURN)
+        {
+            idx=i;
+            return getOpReturnData(script, data);
+        }
+    }
+    return false;
+}
@@ -10,16 +10,26 @@
 #include <algorithm>
 #include <iomanip>
 
+#include <amount.h>
+#include <primitives/transaction.h>
+#include <script/script.h>
+#include <span.h>
 #include <univalue.h>
 
 void hex2ascii(const std::string& in, std::string& out);
 std::string byte2str(const unsigned char* binaryData, size_t size);
 void hex2bin(std::vector<char>& binaryData, const std::string& hexstr);
 void hex2bin(std::vector<unsigned char>& binaryData, const std::string& hexstr);
-std::string computeChange(const UniValue& inputs, double fee);
+//sum of the amounts of listunspent-style inputs less the fee
+CAmount computeChange(const UniValue& inputs, CAmount fee);
 std::string double2str(double val);
 void reverseEndianess(std::string& str);
 
+//payload of a script consisting of OP_RETURN and exactly one push, points into the script
+bool getOpReturnData(const CScript& script, Span<const unsigned char>& data);
+//payload of the first OP_RETURN output, idx is set to its position
+bool getOpReturnData(const CTransaction& tx, Span<const unsigned char>& data, size_t& idx);
+
 template<typename T, typename Q>
 void type2array(T in, std::vector<Q>& array)
 {
@@ -0,0 +1,123 @@
+// Copyright (c) 2018 Slawek Mozdzonek
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <data/documentproof.h>
+
+#include <crypto/common.h>
+#include <hash.h>
+
+static const unsigned char leafTag=0x00;
+static const unsigned char nodeTag=0x01;
+
+uint256 documentLeafHash(const uint256& document)
+{
+    uint256 hash;
+    CHash256().Write(&leafTag, 1).Write(document.begin(), document.size()).Finalize(hash.begin());
+    return hash;
+}
+
+uint256 documentNodeHash(const uint256& left, const uint256& right)
+{
+    uint256 hash;
+    CHash256().Write(&nodeTag, 1).Write(left.begin(), left.size()).Write(right.begin(), right.size()).Finalize(hash.begin());
+    return hash;
+}
+
+uint256 computeDocumentsRoot(const std::vector<uint256>& documents, std::vector<std::vector<uint256>>* branches)
+{
+    if(documents.empty())
+    {
+        return uint256();
+    }
+
+    std::vector<uint256> level;
+    level.reserve(documents.size());
+    for(const uint256& document : documents)
+    {
+        level.push_back(documentLeafHash(document));
+    }
+    if(branches)
+    {
+        branches->assign(documents.size(), std::vector<uint256>());
+    }
+
+    for(size_t depth=0;level.size()>1;++depth)
+    {
+        if(branches)
+        {
+            for(size_t leaf=0;leaf<branches->size();++leaf)
+            {
+                const size_t sibling=(leaf >> depth)^1;
+                if(sibling<level.size())
+                {
+                    (*branches)[leaf].push_back(level[sibling]);
+                }
+            }
+        }
+
+        std::vector<uint256> next;
+        next.reserve((level.size()+1)/2);
+        for(size_t pos=0;pos+1<level.size();pos+=2)
+        {
+            next.push_back(documentNodeHash(level[pos], level[pos+1]));
+        }
+        //the last node of an odd level is moved up unchanged
+        if(level.size()&1)
+        {
+            next.push_back(level.back());
+        }
+        level.swap(next);
+    }
+    return level[0];
+}
+
+bool computeDocumentsRootFromBranch(const uint256& document, const std::vector<uint256>& branch, uint32_t index, uint32_t count, uint256& root)
+{
+    if(index>=count)
+    {
+        return false;
+    }
+
+    uint256 hash=documentLeafHash(document);
+    size_t used=0;
+    for(uint32_t size=count;size>1;size=(size+1)/2)
+    {
+        if((index^1)<size)
+        {
+            if(used==branch.size())
+            {
+                return false;
+            }
+            const uint256& sibling=branch[used++];
+            hash=(index&1) ? documentNodeHash(sibling, hash) : documentNodeHash(hash, sibling);
+        }
+        index>>=1;
+    }
+    if(used!=branch.size())
+    {
+        return false;
+    }
+
+    root=hash;
+    return true;
+}
+
+std::vector<unsigned char> serializeDocumentsCommitment(const uint256& root, uint32_t count)
+{
+    std::vector<unsigned char> data(root.begin(), root.end());
+    data.resize(documentsCommitmentSize);
+    WriteLE32(data.data()+root.size(), count);
+    return data;
+}
+
+bool parseDocumentsCommitment(Span<const unsigned char> data, uint256& root, uint32_t& count)
+{
+    if(data.size()!=static_cast<std::ptrdiff_t>(documentsCommitmentSize))
+    {
+        return false;
+    }
+    std::copy(data.begin(), data.begin()+root.size(), root.begin());
+    count=ReadLE32(data.data()+root.size());
+    return count>0;
+}
@@ -0,0 +1,35 @@
+// Copyright (c) 2018 Slawek Mozdzonek
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DOCUMENTPROOF_H
+#define DOCUMENTPROOF_H
+
+#include <span.h>
+#include <uint256.h>
+
+#include <stdint.h>
+#include <vector>
+
+//size of the data stored by storesignatures: the root followed by the number of documents
+static constexpr size_t documentsCommitmentSize=32+sizeof(uint32_t);
+
+/**
+ * Merkle tree over document hashes committed by storesignatures. Unlike the
+ * block Merkle tree, leaves and inner nodes are hashed with different tags
+ * and the last node of an odd level is moved up instead of being paired with
+ * itself, so a pair of inner hashes can not pass for a document and every
+ * (index, branch) proof belongs to exactly one leaf of a tree of known size.
+ */
+uint256 documentLeafHash(const uint256& document);
+uint256 documentNodeHash(const uint256& left, const uint256& right);
+
+//root of the tree over the documents, branches (if not null) gets the proof of each document
+uint256 computeDocumentsRoot(const std::vector<uint256>& documents, std::vector<std::vector<uint256>>* branches=nullptr);
+//false if the index is not below count or the branch does not match the shape of the tree
+bool computeDocumentsRootFromBranch(const uint256& document, const std::vector<uint256>& branch, uint32_t index, uint32_t count, uint256& root);
+
+std::vector<unsigned char> serializeDocumentsCommitment(const uint256& root, uint32_t count);
+bool parseDocumentsCommitment(Span<const unsigned char> data, uint256& root, uint32_t& count);
+
+#endif
@@ -10,9 +10,7 @@
 #include <wallet/coincontrol.h>
 #include "processunspent.h"
 
-ProcessUnspent::ProcessUnspent(CWallet* const pwallet, const std::vector<std::string>& addresses, bool include_unsafe, 
-                               int nMinDepth, int nMaxDepth, CAmount nMinimumAmount, CAmount nMaximumAmount,
-                               CAmount nMinimumSumAmount, uint64_t nMaximumCount) : wallet(pwallet)
+static std::set<CTxDestination> parseDestinations(const std::vector<std::string>& addresses)
 {
     std::set<CTxDestination> destinations;
     for (unsigned int idx = 0; idx < addresses.size(); idx++)
@@ -27,105 +25,166 @@ ProcessUnspent::ProcessUnspent(CWallet* const pwallet, const std::vector<std::st
             throw std::runtime_error(std::string("Invalid parameter, duplicated address: ") + addresses[idx]);
         }
     }
+    return destinations;
+}
+
+static bool isToDestination(const COutput& out, const std::set<CTxDestination>& destinations)
+{
+    CTxDestination address;
+    return ExtractDestination(out.tx->tx->vout[out.i].scriptPubKey, address) && destinations.count(address);
+}
+
+ProcessUnspent::ProcessUnspent(CWallet* const pwallet, const std::vector<std::string>& addresses, bool include_unsafe, 
+                               int nMinDepth, int nMaxDepth, CAmount nMinimumAmount, CAmount nMaximumAmount,
+                               CAmount nMinimumSumAmount, uint64_t nMaximumCount) : wallet(pwallet)
+{
+    const std::set<CTxDestination> destinations=parseDestinations(addresses);
 
     // Make sure the results are valid at least up to the most recent block
     pwallet->BlockUntilSyncedToCurrentChain();
 
-    std::vector<COutput> vecOutputs;
     LOCK2(cs_main, pwallet->cs_wallet);
 
-    pwallet->AvailableCoins(vecOutputs, !include_unsafe, nullptr, nMinimumAmount, nMaximumAmount, nMinimumSumAmount, nMaximumCount, nMinDepth, nMaxDepth);
-    for (const COutput& out : vecOutputs)
+    pwallet->AvailableCoins(outputs, !include_unsafe, nullptr, nMinimumAmount, nMaximumAmount, nMinimumSumAmount, nMaximumCount, nMinDepth, nMaxDepth);
+    if (destinations.size())
     {
-        CTxDestination address;
-        const CScript& scriptPubKey = out.tx->tx->vout[out.i].scriptPubKey;
-        bool fValidAddress = ExtractDestination(scriptPubKey, address);
-
-        if (destinations.size() && (!fValidAddress || !destinations.count(address)))
+        outputs.erase(std::remove_if(outputs.begin(), outputs.end(),
+        [&destinations](const COutput& out)
         {
-            continue;
-        }
+            return !isToDestination(out, destinations);
+        }), outputs.end());
+    }
+    std::stable_sort(outputs.begin(), outputs.end(),
+    [](const COutput& a, const COutput& b)
+    {
+        return a.nDepth > b.nDepth;
+    });
+}
 
-        UniValue entry(UniValue::VOBJ);
-        entry.pushKV("txid", out.tx->GetHash().GetHex());
-        entry.pushKV("vout", out.i);
+ProcessUnspent::~ProcessUnspent() {}
 
-        if (fValidAddress) 
-        {
-            entry.pushKV("address", EncodeDestination(address));
+UniValue unspentToJSON(const CWallet& wallet, const COutput& out)
+{
+    AssertLockHeld(wallet.cs_wallet);
 
-            if (pwallet->mapAddressBook.count(address)) 
-            {
-                entry.pushKV("account", pwallet->mapAddressBook[address].name);
-            }
+    CTxDestination address;
+    const CScript& scriptPubKey = out.tx->tx->vout[out.i].scriptPubKey;
+    bool fValidAddress = ExtractDestination(scriptPubKey, address);
+
+    UniValue entry(UniValue::VOBJ);
+    entry.pushKV("txid", out.tx->GetHash().GetHex());
+    entry.pushKV("vout", out.i);
 
-            if (scriptPubKey.IsPayToScriptHash(true))
+    if (fValidAddress) 
+    {
+        entry.pushKV("address", EncodeDestination(address));
+
+        auto it = wallet.mapAddressBook.find(address);
+        if (it != wallet.mapAddressBook.end()) 
+        {
+            entry.pushKV("account", it->second.name);
+        }
+
+        if (scriptPubKey.IsPayToScriptHash(true))
+        {
+            const CScriptID& hash = boost::get<CScriptID>(address);
+            CScript redeemScript;
+            if (wallet.GetCScript(hash, redeemScript)) 
             {
-                const CScriptID& hash = boost::get<CScriptID>(address);
-                CScript redeemScript;
-                if (pwallet->GetCScript(hash, redeemScript)) 
-                {
-                    entry.pushKV("redeemScript", HexStr(redeemScript.begin(), redeemScript.end()));
-                }
+                entry.pushKV("redeemScript", HexStr(redeemScript.begin(), redeemScript.end()));
             }
         }
-
-        entry.pushKV("scriptPubKey", HexStr(scriptPubKey.begin(), scriptPubKey.end()));
-        entry.pushKV("amount", ValueFromAmount(out.tx->tx->vout[out.i].nValue));
-        entry.pushKV("confirmations", out.nDepth);
-        entry.pushKV("spendable", out.fSpendable);
-        entry.pushKV("solvable", out.fSolvable);
-        entry.pushKV("safe", out.fSafe);
-        entryArray.push_back(entry);
     }
-    std::sort(entryArray.begin(), entryArray.end(),
-    [](const UniValue& a, const UniValue& b)
-    {
-        return a["confirmations"].get_int()> b["confirmations"].get_int();
-    });
-}
 
-ProcessUnspent::~ProcessUnspent() {}
+    entry.pushKV("scriptPubKey", HexStr(scriptPubKey.begin(), scriptPubKey.end()));
+    entry.pushKV("amount", ValueFromAmount(out.tx->tx->vout[out.i].nValue));
+    entry.pushKV("confirmations", out.nDepth);
+    entry.pushKV("spendable", out.fSpendable);
+    entry.pushKV("solvable", out.fSolvable);
+    entry.pushKV("safe", out.fSafe);
+    return entry;
+}
 
-bool ProcessUnspent::getUtxForAmount(UniValue& utx, const CFeeRate& feeRate, size_t dataSize, double amount, double& fee)
+bool ProcessUnspent::getUtxForAmount(std::vector<COutput>& selected, const CFeeRate& feeRate, size_t dataSize, CAmount amount, CAmount& fee) const
 {
-    bool isEnoughAmount=false;
-    double amountAvailable=0.0;
-    
-    fee=static_cast<double>(feeRate.GetFee(dataSize))/COIN;
+    CAmount amountAvailable=0;
 
-    size_t size=entryArray.size();
-    for(size_t i=0;i<size;++i)
+    selected.clear();
+    fee=feeRate.GetFee(dataSize);
+    for(const COutput& out : outputs)
     {
-        double requiredAmount=amount+fee;
-        amountAvailable+=entryArray[i][std::string("amount")].get_real();
-        utx.push_back(entryArray[i]);
-        if(amountAvailable>=requiredAmount)
+        amountAvailable+=out.tx->tx->vout[out.i].nValue;
+        selected.push_back(out);
+        if(amountAvailable>=amount+fee)
         {
-            isEnoughAmount=true;
-            break;
+            return true;
         }
 
         //we must increase transaction size by adding another input, therefore fee is increased as well
         constexpr size_t txInputSize=145;
         dataSize+=txInputSize;
-        fee=static_cast<double>(feeRate.GetFee(dataSize))/COIN;
+        fee=feeRate.GetFee(dataSize);
+    }
+
+    selected.clear();
+    return false;
+}
+
+bool ProcessUnspent::getUtxForAmount(UniValue& utx, const CFeeRate& feeRate, size_t dataSize, CAmount amount, CAmount& fee) const
+{
+    std::vector<COutput> selected;
+    if(!getUtxForAmount(selected, feeRate, dataSize, amount, fee))
+    {
+        return false;
+    }
+
+    LOCK(wallet->cs_wallet);
+    for(const COutput& out : selected)
+    {
+        utx.push_back(unspentToJSON(*wallet, out));
     }
-    if(!isEnoughAmount)
+    return true;
+}
+
+UniValue getUnspentPage(CWallet* const pwallet, const std::vector<std::string>& addresses, int nMinDepth, int nMaxDepth,
+                        const COutPoint* after, size_t count, COutPoint& last)
+{
+    const std::set<CTxDestination> destinations=parseDestinations(addresses);
+    UniValue page(UniValue::VARR);
+
+    pwallet->BlockUntilSyncedToCurrentChain();
+
+    LOCK2(cs_main, pwallet->cs_wallet);
+
+    //outputs to other addresses are left out, so walk on until the page is full
+    std::vector<COutput> outputs;
+    while(page.size()<count)
     {
-        utx.clear();
+        pwallet->AvailableCoins(outputs, false, nullptr, 0, MAX_MONEY, MAX_MONEY, count-page.size(), nMinDepth, nMaxDepth, after);
+        if(outputs.empty())
+        {
+            break;
+        }
+        for(const COutput& out : outputs)
+        {
+            if(destinations.empty() || isToDestination(out, destinations))
+            {
+                page.push_back(unspentToJSON(*pwallet, out));
+            }
+        }
+        last=COutPoint(outputs.back().tx->GetHash(), outputs.back().i);
+        after=&last;
     }
-    
-    return isEnoughAmount;
+    return page;
 }
 
-double computeFee(const CWallet& wallet, size_t dataSize)
+CAmount computeFee(const CWallet& wallet, size_t dataSize)
 {
     CCoinControl coin_control;
     coin_control.m_signal_bip125_rbf=true;
     FeeCalculation feeCalc;
     CFeeRate nFeeRateNeeded = GetMinimumFeeRate(wallet, coin_control, ::mempool, ::feeEstimator, &feeCalc);
-    return static_cast<double>(nFeeRateNeeded.GetFee(dataSize))/COIN;
+    return nFeeRateNeeded.GetFee(dataSize);
 }
 
 std::string getChangeAddress(CWallet* const pwallet, OutputType output_type)
@@ -15,14 +15,32 @@ public:
                     int nMinDepth = 0, int nMaxDepth = 9999999, CAmount nMinimumAmount = 0, CAmount nMaximumAmount = MAX_MONEY,
                     CAmount nMinimumSumAmount = MAX_MONEY, uint64_t nMaximumCount = 0);
     ~ProcessUnspent();
-    bool getUtxForAmount(UniValue& utx, const CFeeRate& feeRate, size_t dataSize, double amount, double& fee);
+
+    //selects the oldest outputs covering amount plus the fee of a transaction growing with each input
+    bool getUtxForAmount(std::vector<COutput>& selected, const CFeeRate& feeRate, size_t dataSize, CAmount amount, CAmount& fee) const;
+    //same as above, with only the selected outputs converted to listunspent-style entries
+    bool getUtxForAmount(UniValue& utx, const CFeeRate& feeRate, size_t dataSize, CAmount amount, CAmount& fee) const;
+
+    size_t size() const { return outputs.size(); }
+    const std::vector<COutput>& getOutputs() const { return outputs; }
 
 private:
     CWallet* const wallet;
-    std::vector<UniValue> entryArray;
+    //ordered by confirmations, descending
+    std::vector<COutput> outputs;
 };
 
-double computeFee(const CWallet& wallet, size_t dataSize);
+//listunspent-style entry of an output, cs_wallet must be held
+UniValue unspentToJSON(const CWallet& wallet, const COutput& out);
+
+//up to count listunspent-style entries of the available outputs following after (from the first one if null),
+//last is set to the last output looked at, where the next page starts; the (txid, vout) order of the pages does
+//not change when outputs are spent or confirmed, and the wallet is only walked up to the end of the page
+UniValue getUnspentPage(CWallet* const pwallet, const std::vector<std::string>& addresses, int nMinDepth, int nMaxDepth,
+                        const COutPoint* after, size_t count, COutPoint& last);
+
+//fee of dataSize bytes at the wallet's minimum fee rate
+CAmount computeFee(const CWallet& wallet, size_t dataSize);
 std::string getChangeAddress(CWallet* const pwallet, OutputType type=OutputType::P2SH_SEGWIT);
 
 #endif
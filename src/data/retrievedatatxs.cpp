@@ -85,38 +85,10 @@ RetrieveDataTxs::RetrieveDataTxs(const std::string& txid, CWallet* const pwallet
 
 RetrieveDataTxs::~RetrieveDataTxs() {}
 
-std::vector<char> RetrieveDataTxs::getTxData()
+Span<const unsigned char> RetrieveDataTxs::getTxData() const
 {
-    std::vector<char> retHex;
-    for(size_t i=0;i<tx->vout.size();++i)
-    {
-        CScript::const_iterator it_beg=tx->vout[i].scriptPubKey.begin();
-        CScript::const_iterator it_end=tx->vout[i].scriptPubKey.end();
-        int order = *(it_beg+1);
-        if(*it_beg==OP_RETURN)
-        {
-            if(order<=0x4b)
-            {
-                retHex=std::vector<char>(it_beg+2, it_end);
-            }
-            else if(order==0x4c)
-            {
-                retHex=std::vector<char>(it_beg+3, it_end);
-            }
-            else if(order==0x4d)
-            {
-                retHex=std::vector<char>(it_beg+4, it_end);
-            }
-            else if(order==0x4e)
-            {
-                retHex=std::vector<char>(it_beg+6, it_end);
-            }
-            else
-            {
-                return retHex;
-            }
-            return retHex;
-        }
-    }
-    return retHex;
+    Span<const unsigned char> data;
+    size_t idx;
+    getOpReturnData(*tx, data, idx);
+    return data;
 }
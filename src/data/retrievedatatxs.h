@@ -6,6 +6,7 @@
 #define RETRIEVEDATATXS_H
 
 #include <wallet/wallet.h>
+#include <span.h>
 #include <univalue.h>
 
 class RetrieveDataTxs
@@ -13,7 +14,8 @@ class RetrieveDataTxs
 public:
     RetrieveDataTxs(const std::string& txid, CWallet* const pwallet=nullptr, const std::string& blockHash = "");
     ~RetrieveDataTxs();
-    std::vector<char> getTxData();
+    //OP_RETURN payload, valid as long as this object lives
+    Span<const unsigned char> getTxData() const;
 
 private:
     CTransactionRef tx;
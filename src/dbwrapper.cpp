@@ -233,6 +233,23 @@ bool CDBWrapper::IsEmpty()
     return !(it->Valid());
 }
 
+CDBSnapshot::CDBSnapshot(const CDBWrapper &parentIn) : parent(parentIn), readoptions(parentIn.readoptions)
+{
+    readoptions.snapshot = parent.pdb->GetSnapshot();
+}
+
+CDBSnapshot::~CDBSnapshot()
+{
+    parent.pdb->ReleaseSnapshot(readoptions.snapshot);
+}
+
+CDBIterator *CDBSnapshot::NewIterator() const
+{
+    leveldb::ReadOptions iteroptions = parent.iteroptions;
+    iteroptions.snapshot = readoptions.snapshot;
+    return new CDBIterator(parent, parent.pdb->NewIterator(iteroptions));
+}
+
 CDBIterator::~CDBIterator() { delete piter; }
 bool CDBIterator::Valid() const { return piter->Valid(); }
 void CDBIterator::SeekToFirst() { piter->SeekToFirst(); }
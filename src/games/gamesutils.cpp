@@ -3,6 +3,8 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <core_io.h>
+#include <index/bettxindex.h>
+#include <index/txindex.h>
 #include <key_io.h>
 #include <logging.h>
 #include <policy/policy.h>
@@ -31,46 +33,112 @@ void ArgumentOperation::setArgument(unsigned int argument_)
     argument=argument_;
 };
 
-UniValue findTx(const std::string& txid)
+static bool findIndexedTx(const uint256& hash, CTransactionRef& tx, uint256& hash_block)
+{
+    if (g_txindex) {
+        return g_txindex->FindTx(hash, hash_block, tx);
+    }
+    if (g_bettxindex) {
+        return g_bettxindex->FindTx(hash, hash_block, tx);
+    }
+    return false;
+}
+
+static bool isInActiveChain(const uint256& hash_block)
 {
     LOCK(cs_main);
+    const CBlockIndex* blockindex = LookupBlockIndex(hash_block);
+    return blockindex && chainActive.Contains(blockindex);
+}
+
+static void checkNotGenesisCoinbase(const uint256& hash)
+{
+    if (hash == Params().GenesisBlock().hashMerkleRoot)
+    {
+        // Special exception for the genesis block coinbase transaction
+        throw std::runtime_error(std::string("The genesis block coinbase is not considered an ordinary transaction and cannot be retrieved"));
+    }
+}
 
-    bool in_active_chain = true;
+static UniValue foundTxToJSON(const CTransaction& tx, const uint256& hash_block)
+{
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("in_active_chain", true);
+    TxToJSON(tx, hash_block, result);
+    result.pushKV("blockhash", hash_block.ToString());
+    return result;
+}
+
+UniValue findTx(const std::string& txid)
+{
     uint256 hash = ParseHashV(txid, "parameter 1");
-    CBlockIndex* blockindex = nullptr;
+    checkNotGenesisCoinbase(hash);
+
     CTransactionRef tx;
     uint256 hash_block;
-    UniValue result(UniValue::VOBJ);
+    bool found = findIndexedTx(hash, tx, hash_block) && isInActiveChain(hash_block);
 
-    int i;
-    for(i=chainActive.Height();i>=0;--i)
+    // no index or index still syncing, scan the active chain from the tip;
+    // cs_main is only taken to look up each block, not while reading it
+    int height;
     {
-        blockindex = chainActive[i];
-
-        if (hash == Params().GenesisBlock().hashMerkleRoot)
+        LOCK(cs_main);
+        height = chainActive.Height();
+    }
+    for(;!found && height>=0;--height)
+    {
+        const CBlockIndex* blockindex;
         {
-            // Special exception for the genesis block coinbase transaction
-            throw std::runtime_error(std::string("The genesis block coinbase is not considered an ordinary transaction and cannot be retrieved"));
+            LOCK(cs_main);
+            blockindex = chainActive[height];
         }
-
-        if (GetTransaction(hash, tx, Params().GetConsensus(), hash_block, true, blockindex)) 
+        CBlock block;
+        if (!blockindex || !ReadBlockFromDisk(block, blockindex, Params().GetConsensus()))
+        {
+            continue;
+        }
+        for (const CTransactionRef& blockTx : block.vtx)
         {
-            if(blockindex)
+            if (blockTx->GetHash() == hash)
             {
-                result.pushKV("in_active_chain", in_active_chain);
+                tx = blockTx;
+                hash_block = blockindex->GetBlockHash();
+                found = true;
+                break;
             }
-            TxToJSON(*tx, hash_block, result);
-            result.pushKV("blockhash", hash_block.ToString());
-            break;
         }
     }
 
-    if(i<0)
+    if(!found)
     {
         throw std::runtime_error(std::string("Transaction not in blockchain"));
     }
 
-    return result;
+    return foundTxToJSON(*tx, hash_block);
+}
+
+UniValue findTxInBlock(const uint256& hash, int height)
+{
+    checkNotGenesisCoinbase(hash);
+
+    const CBlockIndex* blockindex;
+    {
+        LOCK(cs_main);
+        blockindex = chainActive[height];
+    }
+    CBlock block;
+    if (blockindex && ReadBlockFromDisk(block, blockindex, Params().GetConsensus()))
+    {
+        for (const CTransactionRef& blockTx : block.vtx)
+        {
+            if (blockTx->GetHash() == hash)
+            {
+                return foundTxToJSON(*blockTx, blockindex->GetBlockHash());
+            }
+        }
+    }
+
+    throw std::runtime_error(std::string("Transaction not in blockchain"));
 }
 
 CKeyID getTxKeyID(const CTransaction& tx, int inputIdx)
@@ -86,7 +154,11 @@ CKeyID getTxKeyID(const CTransaction& tx, int inputIdx)
 
 CScript createScriptPubkey(const CTransaction& prevTx)
 {
-    const CKeyID keyID = getTxKeyID(prevTx);
+    return createScriptPubkey(getTxKeyID(prevTx));
+}
+
+CScript createScriptPubkey(const CKeyID& keyID)
+{
     return CScript() << OP_DUP << OP_HASH160 << ToByteVector(keyID) << OP_EQUALVERIFY << OP_CHECKSIG;
 }
 
@@ -98,53 +170,13 @@ std::string getBetType(const CTransaction& tx)
 
 std::string getBetType(const CTransaction& tx, size_t& idx)
 {
-    idx=0;
-    for(size_t i=0;i<tx.vout.size();++i)
+    Span<const unsigned char> data;
+    if(!getOpReturnData(tx, data, idx))
     {
-        CScript::const_iterator it_beg=tx.vout[i].scriptPubKey.begin();
-        CScript::const_iterator it_end=tx.vout[i].scriptPubKey.end();
-        std::string hexStr;
-        int order = *(it_beg+1);
-        unsigned int length = 0;
-        if(*it_beg==OP_RETURN)
-        {
-            if(order<=0x4b)
-            {
-                hexStr=std::string(it_beg+2, it_end);
-                memcpy((char*)&length, std::string(it_beg+1, it_beg+2).c_str(), 1);
-            }
-            else if(order==0x4c)
-            {
-                hexStr=std::string(it_beg+3, it_end);
-                memcpy((char*)&length, std::string(it_beg+2, it_beg+3).c_str(), 1);
-            }
-            else if(order==0x4d)
-            {
-                hexStr=std::string(it_beg+4, it_end);
-                memcpy((char*)&length, std::string(it_beg+2, it_beg+4).c_str(), 2);
-            }
-            else if(order==0x4e)
-            {
-                hexStr=std::string(it_beg+6, it_end);
-                memcpy((char*)&length, std::string(it_beg+2, it_beg+6).c_str(), 4);
-            }
-            else
-            {
-                LogPrintf("getBetType length is too-large\n");
-                return std::string("");
-            }
-            //LogPrintf("getBetType: %s\n", hexStr);
-            idx=i;
-            if (hexStr.length() != length)
-            {
-                LogPrintf("%s ERROR: length difference %u, script: %s\n", length, hexStr.c_str());
-                return std::string("");
-            }
-            return hexStr;
-        }
+        LogPrintf("getBetType no well-formed op-return\n");
+        return std::string("");
     }
-    LogPrintf("getBetType no op-return\n");
-    return std::string("");
+    return std::string(data.begin(), data.end());
 }
 
 unsigned int blockHashStr2Int(const std::string& hashStr)
@@ -158,6 +190,14 @@ unsigned int blockHashStr2Int(const std::string& hashStr)
     return hash;
 }
 
+//same value as blockHashStr2Int(hash.ToString()) without the hex round trip
+unsigned int blockHash2Int(const uint256& hash)
+{
+    unsigned int result;
+    memcpy(&result, hash.begin(), sizeof(result));
+    return result;
+}
+
 unsigned int getArgumentFromBetType(std::string& betType, unsigned int max_limit)
 {
     size_t pos_=betType.find("_");
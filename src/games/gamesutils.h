@@ -8,9 +8,14 @@
 #include <consensus/params.h>
 #include <univalue.h>
 #include <outputtype.h>
+#include <uint256.h>
 #include <limits>
 
+//for RPC callers: looks the transaction up in -txindex or -bettxindex, scans the active chain if neither is synced
 UniValue findTx(const std::string& txid);
+//for consensus code: reads the block of the active chain at height only, so the result
+//does not depend on the optional indexes; height is the one of the coin spending from the transaction
+UniValue findTxInBlock(const uint256& hash, int height);
 
 class ArgumentOperation
 {
@@ -26,10 +31,12 @@ protected:
 
 CKeyID getTxKeyID(const CTransaction& tx, int inputIdx=0);
 CScript createScriptPubkey(const CTransaction& prevTx);
+CScript createScriptPubkey(const CKeyID& keyID);
 
 std::string getBetType(const CTransaction& tx, size_t& idx);
 std::string getBetType(const CTransaction& tx);
 unsigned int blockHashStr2Int(const std::string& hashStr);
+unsigned int blockHash2Int(const uint256& hash);
 CAmount applyFee(CMutableTransaction& tx, int64_t nTxWeight, int64_t sigOpCost);
 unsigned int getArgumentFromBetType(std::string& betType, unsigned int max_limit = std::numeric_limits<unsigned int>::max());
 
@@ -0,0 +1,323 @@
+// Copyright (c) 2018 Slawek Mozdzonek
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <games/modulo/modulobet.h>
+#include <games/modulo/moduloutils.h>
+#include <games/gamesutils.h>
+#include <sync.h>
+
+#include <cstring>
+#include <deque>
+#include <map>
+#include <stdexcept>
+
+namespace modulo
+{
+
+    namespace
+    {
+
+        struct BetKindInfo
+        {
+            BetKind kind;
+            const char* lower;
+            const char* upper;
+            int numbers;        //winning numbers covered by one bet
+            const int* table;   //rows of the roulette table, each of "numbers" entries
+            int rows;           //0 for bets without an index
+        };
+
+        const int ROULETTE_RANGE=36;
+
+        const BetKindInfo betKinds[]=
+        {
+            {BetKind::STRAIGHT, "straight_", "STRAIGHT_", 1, nullptr, ROULETTE_RANGE},
+            {BetKind::SPLIT, "split_", "SPLIT_", 2, &split[0][0], splitBetsNum},
+            {BetKind::STREET, "street_", "STREET_", 3, &street[0][0], streetBetsNum},
+            {BetKind::CORNER, "corner_", "CORNER_", 4, &corner[0][0], cornerBetsNum},
+            {BetKind::LINE, "line_", "LINE_", 6, &line[0][0], lineBetsNum},
+            {BetKind::COLUMN, "column_", "COLUMN_", 12, &column[0][0], columnBetsNum},
+            {BetKind::DOZEN, "dozen_", "DOZEN_", 12, &dozen[0][0], dozenBetsNum},
+            {BetKind::LOW, "low", "LOW", 18, low, 0},
+            {BetKind::HIGH, "high", "HIGH", 18, high, 0},
+            {BetKind::EVEN, "even", "EVEN", 18, even, 0},
+            {BetKind::ODD, "odd", "ODD", 18, odd, 0},
+            {BetKind::RED, "red", "RED", 18, red, 0},
+            {BetKind::BLACK, "black", "BLACK", 18, black, 0}
+        };
+
+        const size_t betKindsNum=sizeof(betKinds)/sizeof(betKinds[0]);
+        const size_t maxBetRows=splitBetsNum;
+
+        const BetKindInfo* getBetKindInfo(BetKind kind)
+        {
+            for(size_t i=0;i<betKindsNum;++i)
+            {
+                if(betKinds[i].kind==kind)
+                {
+                    return &betKinds[i];
+                }
+            }
+            return nullptr;
+        }
+
+        /** Winning numbers of every roulette bet as a bit mask, bit n set for number n. */
+        class RouletteMasks
+        {
+        public:
+            RouletteMasks()
+            {
+                for(size_t i=0;i<betKindsNum;++i)
+                {
+                    const BetKindInfo& info=betKinds[i];
+                    for(int row=0;row<=info.rows;++row)
+                    {
+                        uint64_t mask=0;
+                        if(info.table==nullptr)
+                        {
+                            mask=(uint64_t)1 << row;
+                        }
+                        else if(info.rows==0 || row>0)
+                        {
+                            const int* numbers=info.table+(info.rows==0 ? 0 : (row-1)*info.numbers);
+                            for(int n=0;n<info.numbers;++n)
+                            {
+                                mask|=(uint64_t)1 << numbers[n];
+                            }
+                        }
+                        masks[i][row]=mask;
+                    }
+                }
+            }
+
+            uint64_t get(const BetKindInfo* info, int index) const
+            {
+                return masks[info-betKinds][index];
+            }
+
+        private:
+            uint64_t masks[betKindsNum][maxBetRows+1]={};
+        };
+
+        const RouletteMasks rouletteMasks;
+
+        int parseNumber(const std::string& str)
+        {
+            try
+            {
+                return std::stoi(str);
+            }
+            catch(...)
+            {
+                return 0;
+            }
+        }
+
+        CCriticalSection cs_parsedBets;
+        std::map<uint256, ParsedBetRef> mapParsedBets GUARDED_BY(cs_parsedBets);
+        std::deque<uint256> parsedBetsOrder GUARDED_BY(cs_parsedBets);
+
+    }
+
+    Leg parseBetLeg(const std::string& type, CAmount amount)
+    {
+        Leg leg{BetKind::UNKNOWN, 0, false, amount};
+
+        if(type.find_first_not_of("0123456789")==std::string::npos)
+        {
+            leg.kind=BetKind::LOTTERY;
+            leg.index=parseNumber(type);
+            leg.zeroSuffix=(leg.index==0);
+            return leg;
+        }
+
+        for(size_t i=0;i<betKindsNum;++i)
+        {
+            const BetKindInfo& info=betKinds[i];
+            const size_t prefixLen=strlen(info.lower);
+            if(type.compare(0, prefixLen, info.lower)==0 || type.compare(0, prefixLen, info.upper)==0)
+            {
+                leg.kind=info.kind;
+                if(info.rows>0)
+                {
+                    leg.index=parseNumber(type.substr(prefixLen));
+                }
+                break;
+            }
+        }
+
+        size_t pos_=type.find_last_of("_");
+        if(pos_!=std::string::npos && pos_<type.length()-1)
+        {
+            leg.zeroSuffix=(parseNumber(type.substr(pos_+1))==0);
+        }
+
+        return leg;
+    }
+
+    ParsedBet parseBet(const CTransaction& tx)
+    {
+        ParsedBet bet;
+
+        std::string betType=getBetType(tx, bet.opReturnIdx);
+        if(betType.empty())
+        {
+            bet.status=ParsedBet::EMPTY_PAYLOAD;
+            return bet;
+        }
+
+        try
+        {
+            bet.argument=getArgumentFromBetType(betType);
+        }
+        catch(...)
+        {
+            bet.status=ParsedBet::BAD_ARGUMENT;
+            bet.argument=0;
+            return bet;
+        }
+
+        //example bet: 00000024_black@200000000+red@100000000
+        size_t pos=0;
+        while(true)
+        {
+            const size_t typePos=betType.find('@', pos);
+            if(typePos==std::string::npos)
+            {
+                bet.status=ParsedBet::MISSING_AT;
+                break;
+            }
+
+            const size_t amountPos=betType.find('+', typePos+1);
+            CAmount amount;
+            try
+            {
+                amount=std::stoll(betType.substr(typePos+1, amountPos==std::string::npos ? std::string::npos : amountPos-typePos-1));
+            }
+            catch(...)
+            {
+                bet.status=ParsedBet::BAD_AMOUNT;
+                break;
+            }
+
+            bet.legs.push_back(parseBetLeg(betType.substr(pos, typePos-pos), amount));
+
+            if(amountPos==std::string::npos)
+            {
+                bet.status=ParsedBet::OK;
+                break;
+            }
+            pos=amountPos+1;
+        }
+
+        return bet;
+    }
+
+    ParsedBetRef getParsedBet(const CTransaction& tx)
+    {
+        const uint256& txid=tx.GetHash();
+        {
+            LOCK(cs_parsedBets);
+            auto it=mapParsedBets.find(txid);
+            if(it!=mapParsedBets.end())
+            {
+                return it->second;
+            }
+        }
+
+        ParsedBetRef bet=std::make_shared<const ParsedBet>(parseBet(tx));
+
+        LOCK(cs_parsedBets);
+        if(mapParsedBets.emplace(txid, bet).second)
+        {
+            parsedBetsOrder.push_back(txid);
+            if(parsedBetsOrder.size()>MAX_PARSED_BETS_CACHE)
+            {
+                mapParsedBets.erase(parsedBetsOrder.front());
+                parsedBetsOrder.pop_front();
+            }
+        }
+        return bet;
+    }
+
+    int getBetReward(const Leg& leg, unsigned int modulo)
+    {
+        if(leg.kind==BetKind::LOTTERY || leg.kind==BetKind::STRAIGHT)
+        {
+            return modulo;
+        }
+
+        const BetKindInfo* info=getBetKindInfo(leg.kind);
+        if(info==nullptr || modulo!=ROULETTE_RANGE)
+        {
+            return 0;
+        }
+        return modulo/info->numbers;
+    }
+
+    bool isBetWinning(const Leg& leg, unsigned int maxArgument, unsigned int argument)
+    {
+        if(leg.kind==BetKind::LOTTERY)
+        {
+            if(leg.index<1 || static_cast<unsigned int>(leg.index)>maxArgument)
+            {
+                throw std::runtime_error(std::string("isBetWinning argument failed: ")+std::to_string(argument)+std::string(" maxArgument: ")+std::to_string(maxArgument)+std::string(" betNum: ")+std::to_string(leg.index));
+            }
+            return static_cast<unsigned int>(leg.index)==argument;
+        }
+
+        const BetKindInfo* info=getBetKindInfo(leg.kind);
+        if(info==nullptr || maxArgument!=ROULETTE_RANGE)
+        {
+            return false;
+        }
+
+        if(info->rows>0 && (leg.index<1 || leg.index>info->rows))
+        {
+            throw std::runtime_error(std::string("isBetWinning argument failed: ")+std::to_string(argument)+std::string(" maxArgument: 36")+std::string(" betNum: ")+std::to_string(leg.index));
+        }
+
+        if(argument>=64)
+        {
+            return false;
+        }
+        return (rouletteMasks.get(info, leg.index) >> argument) & 1;
+    }
+
+    std::vector<unsigned int> getWinningArguments(const Leg& leg, unsigned int maxArgument)
+    {
+        std::vector<unsigned int> arguments;
+        if(leg.kind==BetKind::LOTTERY)
+        {
+            if(leg.index<1 || static_cast<unsigned int>(leg.index)>maxArgument)
+            {
+                throw std::runtime_error(std::string("getWinningArguments failed: maxArgument: ")+std::to_string(maxArgument)+std::string(" betNum: ")+std::to_string(leg.index));
+            }
+            arguments.push_back(leg.index);
+            return arguments;
+        }
+
+        const BetKindInfo* info=getBetKindInfo(leg.kind);
+        if(info==nullptr || maxArgument!=ROULETTE_RANGE)
+        {
+            return arguments;
+        }
+
+        if(info->rows>0 && (leg.index<1 || leg.index>info->rows))
+        {
+            throw std::runtime_error(std::string("getWinningArguments failed: maxArgument: 36")+std::string(" betNum: ")+std::to_string(leg.index));
+        }
+
+        const uint64_t mask=rouletteMasks.get(info, leg.index);
+        for(unsigned int argument=1;argument<=ROULETTE_RANGE;++argument)
+        {
+            if((mask >> argument) & 1)
+            {
+                arguments.push_back(argument);
+            }
+        }
+        return arguments;
+    }
+
+}
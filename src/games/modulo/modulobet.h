@@ -0,0 +1,88 @@
+// Copyright (c) 2018 Slawek Mozdzonek
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef MODULOBET_H
+#define MODULOBET_H
+
+#include <amount.h>
+#include <primitives/transaction.h>
+
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace modulo
+{
+
+    enum class BetKind : uint8_t
+    {
+        UNKNOWN,
+        LOTTERY,
+        STRAIGHT,
+        SPLIT,
+        STREET,
+        CORNER,
+        LINE,
+        COLUMN,
+        DOZEN,
+        LOW,
+        HIGH,
+        EVEN,
+        ODD,
+        RED,
+        BLACK
+    };
+
+    /** One "<type>@<amount>" element of a makebet OP_RETURN payload. */
+    struct Leg
+    {
+        BetKind kind;
+        //lottery/straight number or 1-based row of the roulette table, 0 if it could not be parsed
+        int index;
+        //number after the last '_' of the bet type is zero or could not be parsed
+        bool zeroSuffix;
+        CAmount amount;
+    };
+
+    /**
+     * Makebet OP_RETURN payload "<hex argument>_<leg>+<leg>+..." parsed once.
+     * Parsing stops at the first malformed leg; legs preceding it are kept so
+     * that every consumer can reproduce its own error handling in order.
+     */
+    struct ParsedBet
+    {
+        enum Status
+        {
+            OK,
+            EMPTY_PAYLOAD,  //no OP_RETURN or malformed push
+            BAD_ARGUMENT,   //"<hex argument>_" prefix missing or zero
+            MISSING_AT,     //leg without '@'
+            BAD_AMOUNT      //leg amount is not a number
+        };
+
+        Status status=EMPTY_PAYLOAD;
+        size_t opReturnIdx=0;
+        unsigned int argument=0;
+        std::vector<Leg> legs;
+    };
+
+    typedef std::shared_ptr<const ParsedBet> ParsedBetRef;
+
+    static const size_t MAX_PARSED_BETS_CACHE=50000;
+
+    Leg parseBetLeg(const std::string& type, CAmount amount=0);
+    ParsedBet parseBet(const CTransaction& tx);
+    //parseBet() result cached by txid
+    ParsedBetRef getParsedBet(const CTransaction& tx);
+
+    int getBetReward(const Leg& leg, unsigned int modulo);
+    //throws std::runtime_error on a bet number outside of its table
+    bool isBetWinning(const Leg& leg, unsigned int maxArgument, unsigned int argument);
+    //outcomes of ModuloOperation for which isBetWinning() is true, in ascending order
+    std::vector<unsigned int> getWinningArguments(const Leg& leg, unsigned int maxArgument);
+
+}
+
+#endif
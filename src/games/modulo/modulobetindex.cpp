@@ -0,0 +1,172 @@
+// Copyright (c) 2018 Slawek Mozdzonek
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <games/modulo/modulobetindex.h>
+#include <games/modulo/moduloverify.h>
+#include <games/gamesutils.h>
+#include <util.h>
+#include <validation.h>
+
+#include <algorithm>
+
+namespace modulo
+{
+
+    namespace ver_2
+    {
+
+        WinningBetsIndex g_winningBets;
+
+        bool MakeBetCheck::operator()()
+        {
+            try {
+                MakeBetWinningProcess makeBetWinningProcess(*tx, hash);
+                if (makeBetWinningProcess.isMakeBetWinning()) {
+                    result->payoff = makeBetWinningProcess.getMakeBetPayoff();
+                    result->keyID = getTxKeyID(*tx);
+                }
+            }
+            catch (const std::exception& e) {
+                //a makebet that can not be evaluated does not win
+                LogPrintf("%s: could not evaluate makebet %s: %s\n", __func__, tx->GetHash().ToString(), e.what());
+                result->payoff = 0;
+            }
+            result->evaluated = true;
+            return true;
+        }
+
+        void MakeBetCheck::swap(MakeBetCheck& check)
+        {
+            std::swap(tx, check.tx);
+            std::swap(hash, check.hash);
+            std::swap(result, check.result);
+        }
+
+        std::vector<MakeBetCheck> makeBetChecks(const CBlock& block, const uint256& hash, std::vector<MakeBetResult>& results)
+        {
+            //size results first, checks keep pointers into it
+            results.assign(std::count_if(block.vtx.begin(), block.vtx.end(), [](const CTransactionRef& tx) { return isMakeBetTx(*tx); }), MakeBetResult());
+
+            std::vector<MakeBetCheck> checks;
+            checks.reserve(results.size());
+            for (const CTransactionRef& tx : block.vtx) {
+                if (isMakeBetTx(*tx)) {
+                    checks.emplace_back(*tx, hash, results[checks.size()]);
+                }
+            }
+            return checks;
+        }
+
+        WinningBetsRef reduceWinningBets(const CBlock& block, const std::vector<MakeBetResult>& results)
+        {
+            std::shared_ptr<WinningBets> bets = std::make_shared<WinningBets>();
+            uint32_t makeBetIdx = 0;
+            for (const CTransactionRef& txRef : block.vtx) {
+                const CTransaction& tx = *txRef;
+                if (!isMakeBetTx(tx)) {
+                    continue;
+                }
+
+                const MakeBetResult& result = results.at(makeBetIdx);
+                if (!result.evaluated) {
+                    throw std::runtime_error(strprintf("makebet %s not evaluated", tx.GetHash().ToString()));
+                }
+                if (result.payoff > 0) {
+                    bets->push_back(MakeBetData{tx.GetHash(), makeBetIdx, tx.vout[0], result.payoff, result.keyID});
+                }
+                ++makeBetIdx;
+            }
+            return bets;
+        }
+
+        WinningBetsRef computeWinningBets(const CBlock& block, const uint256& hash)
+        {
+            std::vector<MakeBetResult> results;
+            for (MakeBetCheck& check : makeBetChecks(block, hash, results)) {
+                check();
+            }
+            return reduceWinningBets(block, results);
+        }
+
+        void WinningBetsIndex::add(const uint256& hash, const WinningBetsRef& bets)
+        {
+            LOCK(cs);
+            if (blocks.emplace(hash, bets).second) {
+                order.push_back(hash);
+                if (order.size() > MAX_BLOCKS) {
+                    blocks.erase(order.front());
+                    order.pop_front();
+                }
+            }
+        }
+
+        void WinningBetsIndex::connectBlock(const CBlock& block, const uint256& hash, const std::vector<MakeBetResult>& results)
+        {
+            try {
+                add(hash, reduceWinningBets(block, results));
+            }
+            catch (const std::exception& e) {
+                //leave the block out, getWinningBets() falls back to the block on disk
+                LogPrintf("%s: could not evaluate makebets of block %s: %s\n", __func__, hash.ToString(), e.what());
+            }
+        }
+
+        void WinningBetsIndex::disconnectBlock(const uint256& hash)
+        {
+            LOCK(cs);
+            if (blocks.erase(hash)) {
+                order.erase(std::find(order.begin(), order.end(), hash));
+            }
+        }
+
+        WinningBetsRef WinningBetsIndex::getWinningBets(const CBlockIndex* pindex, const Consensus::Params& params)
+        {
+            if (pindex == nullptr) {
+                return nullptr;
+            }
+
+            const uint256 hash = pindex->GetBlockHash();
+            {
+                LOCK(cs);
+                const auto it = blocks.find(hash);
+                if (it != blocks.end()) {
+                    return it->second;
+                }
+            }
+
+            CBlock block;
+            if (!ReadBlockFromDisk(block, pindex, params)) {
+                return nullptr;
+            }
+
+            //the getbet of the next block is verified and mined against this one, keep it
+            const WinningBetsRef bets = computeWinningBets(block, hash);
+            add(hash, bets);
+            return bets;
+        }
+
+        WinningBetsRef WinningBetsIndex::getWinningBets(const CBlock& block, const uint256& hash)
+        {
+            {
+                LOCK(cs);
+                const auto it = blocks.find(hash);
+                if (it != blocks.end()) {
+                    return it->second;
+                }
+            }
+
+            //not added, a reader lagging behind the tip must not evict the blocks validation needs
+            return computeWinningBets(block, hash);
+        }
+
+        void WinningBetsIndex::clear()
+        {
+            LOCK(cs);
+            blocks.clear();
+            order.clear();
+        }
+
+    }
+
+}
@@ -0,0 +1,115 @@
+// Copyright (c) 2018 Slawek Mozdzonek
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef MODULOBETINDEX_H
+#define MODULOBETINDEX_H
+
+#include <amount.h>
+#include <consensus/params.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <pubkey.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+class CBlockIndex;
+
+namespace modulo
+{
+
+    namespace ver_2
+    {
+
+        struct MakeBetData
+        {
+            uint256 hash;       //makebet txid
+            uint32_t idx;       //position of the makebet among makebets of its block
+            CTxOut out;
+            CAmount payoff;
+            CKeyID keyID;
+        };
+
+        typedef std::vector<MakeBetData> WinningBets;
+        typedef std::shared_ptr<const WinningBets> WinningBetsRef;
+
+        struct MakeBetResult
+        {
+            bool evaluated = false;     //false until the check of the bet has run
+            CAmount payoff = 0;         //zero for a losing bet
+            CKeyID keyID;
+        };
+
+        /**
+         * Evaluation of one makebet against the hash of its block, queued on
+         * a CCheckQueue. Each check writes its own result slot, so results do
+         * not depend on which worker ran which check. A makebet that can not
+         * be evaluated is taken as losing, so the check always returns true
+         * and never fails the block.
+         */
+        class MakeBetCheck
+        {
+        public:
+            MakeBetCheck() : tx(nullptr), result(nullptr) {}
+            MakeBetCheck(const CTransaction& tx_, const uint256& hash_, MakeBetResult& result_) :
+                tx(&tx_), hash(hash_), result(&result_) {}
+
+            bool operator()();
+            void swap(MakeBetCheck& check);
+
+        private:
+            const CTransaction* tx;
+            uint256 hash;
+            MakeBetResult* result;
+        };
+
+        //checks evaluating the makebets of a block, results has one slot per makebet in block order
+        std::vector<MakeBetCheck> makeBetChecks(const CBlock& block, const uint256& hash, std::vector<MakeBetResult>& results);
+        //winning makebets in block order, throws if the check of a makebet has not run
+        WinningBetsRef reduceWinningBets(const CBlock& block, const std::vector<MakeBetResult>& results);
+
+        //winning makebets of a block, evaluated against the hash of that block
+        WinningBetsRef computeWinningBets(const CBlock& block, const uint256& hash);
+
+        /**
+         * Winning makebets of recently connected blocks keyed by block hash.
+         * A getbet of block N pays the makebets of block N-1, so keeping the
+         * result of the evaluation done while connecting N-1 saves reading
+         * that block from disk again when N is verified or mined. Entries are
+         * keyed by hash, hence stay valid across reorganizations; blocks not
+         * in the index are read from disk and added on demand when looked up
+         * by CBlockIndex, and only evaluated when looked up by block.
+         */
+        class WinningBetsIndex
+        {
+        public:
+            static const size_t MAX_BLOCKS=64;
+
+            //results of makeBetChecks() run while the block was connected
+            void connectBlock(const CBlock& block, const uint256& hash, const std::vector<MakeBetResult>& results);
+            void disconnectBlock(const uint256& hash);
+            WinningBetsRef getWinningBets(const CBlockIndex* pindex, const Consensus::Params& params);
+            //for readers of connected blocks, a miss is evaluated without being added
+            WinningBetsRef getWinningBets(const CBlock& block, const uint256& hash);
+            void clear();
+
+        private:
+            void add(const uint256& hash, const WinningBetsRef& bets);
+
+            CCriticalSection cs;
+            std::map<uint256, WinningBetsRef> blocks GUARDED_BY(cs);
+            std::deque<uint256> order GUARDED_BY(cs);
+        };
+
+        extern WinningBetsIndex g_winningBets;
+
+    }
+
+}
+
+#endif
@@ -0,0 +1,210 @@
+// Copyright (c) 2018 Slawek Mozdzonek
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <games/modulo/modulobettracker.h>
+#include <games/modulo/modulobetindex.h>
+#include <games/modulo/moduloverify.h>
+#include <games/gamesutils.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <util.h>
+
+#include <map>
+
+namespace modulo
+{
+
+    namespace ver_2
+    {
+
+        static const char DB_BET = 'b';
+        static const char DB_BET_KEY = 'k';
+
+        std::unique_ptr<BetTracker> g_betTracker;
+
+        boost::signals2::signal<void (const uint256& makeBetHash, const BetStatus& status)> BetTracker::NotifyBetStatus;
+
+        /** Access to the bet tracker database (indexes/bettracker/) */
+        class BetTracker::DB : public BaseIndex::DB
+        {
+        public:
+            explicit DB(size_t cacheSize, bool memory = false, bool wipe = false) :
+                BaseIndex::DB(GetDataDir() / "indexes" / "bettracker", cacheSize, memory, wipe)
+            {}
+        };
+
+        std::string BetStatus::getStateName() const
+        {
+            switch (state) {
+            case LOST: return "lost";
+            case WON: return "won";
+            case PAID: return "paid";
+            }
+            return "unknown";
+        }
+
+        //key paying for the makebet, the same getTxKeyID() credits a winning bet to
+        static CKeyID getBettor(const CTransaction& tx)
+        {
+            const CTxIn& in = tx.vin[0];
+            if (in.scriptWitness.IsNull() ? in.scriptSig.size() < 33 : in.scriptWitness.stack.size() < 2) {
+                return CKeyID();
+            }
+            return getTxKeyID(tx);
+        }
+
+        BetTracker::BetTracker(size_t cacheSize, bool memory, bool wipe) :
+            db(MakeUnique<BetTracker::DB>(cacheSize, memory, wipe))
+        {}
+
+        BetTracker::~BetTracker() {}
+
+        BaseIndex::DB& BetTracker::GetDB() const { return *db; }
+
+        bool BetTracker::getBetStatus(const uint256& makeBetHash, BetStatus& status) const
+        {
+            return db->Read(std::make_pair(DB_BET, makeBetHash), status);
+        }
+
+        std::vector<std::pair<uint256, BetStatus>> BetTracker::listBets(const CKeyID& keyID, size_t count, size_t skip) const
+        {
+            std::vector<std::pair<uint256, BetStatus>> bets;
+            std::unique_ptr<CDBIterator> cursor(db->NewIterator());
+            if (keyID.IsNull()) {
+                for (cursor->Seek(std::make_pair(DB_BET, uint256())); cursor->Valid() && bets.size() < count; cursor->Next()) {
+                    std::pair<char, uint256> key;
+                    if (!cursor->GetKey(key) || key.first != DB_BET) {
+                        break;
+                    }
+                    if (skip) {
+                        --skip;
+                        continue;
+                    }
+                    BetStatus status;
+                    if (cursor->GetValue(status)) {
+                        bets.emplace_back(key.second, status);
+                    }
+                }
+                return bets;
+            }
+
+            for (cursor->Seek(std::make_pair(DB_BET_KEY, std::make_pair(keyID, uint256()))); cursor->Valid() && bets.size() < count; cursor->Next()) {
+                std::pair<char, std::pair<CKeyID, uint256>> key;
+                if (!cursor->GetKey(key) || key.first != DB_BET_KEY || key.second.first != keyID) {
+                    break;
+                }
+                if (skip) {
+                    --skip;
+                    continue;
+                }
+                BetStatus status;
+                if (db->Read(std::make_pair(DB_BET, key.second.second), status)) {
+                    bets.emplace_back(key.second.second, status);
+                }
+            }
+            return bets;
+        }
+
+        bool BetTracker::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+        {
+            if (pindex->nHeight < Params().GetConsensus().GamesVersion2) {
+                return true;
+            }
+
+            std::vector<std::pair<uint256, BetStatus>> changes;
+            try {
+                //kept from connecting the block, evaluated again for blocks replayed when catching up
+                const WinningBetsRef winningBets = g_winningBets.getWinningBets(block, pindex->GetBlockHash());
+                std::map<uint256, const MakeBetData*> won;
+                for (const MakeBetData& makeBetData : *winningBets) {
+                    won[makeBetData.hash] = &makeBetData;
+                }
+
+                LOCK(cs);
+                CDBBatch batch(*db);
+                for (const CTransactionRef& tx : block.vtx) {
+                    if (isMakeBetTx(*tx)) {
+                        BetStatus status;
+                        status.blockHash = pindex->GetBlockHash();
+                        status.height = pindex->nHeight;
+                        status.amount = tx->vout[0].nValue;
+                        const auto it = won.find(tx->GetHash());
+                        if (it != won.end()) {
+                            status.state = BetStatus::WON;
+                            status.payoff = it->second->payoff;
+                            status.keyID = it->second->keyID;
+                        }
+                        else {
+                            status.keyID = getBettor(*tx);
+                        }
+                        batch.Write(std::make_pair(DB_BET, tx->GetHash()), status);
+                        batch.Write(std::make_pair(DB_BET_KEY, std::make_pair(status.keyID, tx->GetHash())), '\0');
+                        changes.emplace_back(tx->GetHash(), status);
+                    }
+                    else if (isGetBetTx(*tx)) {
+                        for (const CTxIn& in : tx->vin) {
+                            BetStatus status;
+                            if (db->Read(std::make_pair(DB_BET, in.prevout.hash), status)) {
+                                status.state = BetStatus::PAID;
+                                status.getbetHash = tx->GetHash();
+                                batch.Write(std::make_pair(DB_BET, in.prevout.hash), status);
+                                changes.emplace_back(in.prevout.hash, status);
+                            }
+                        }
+                    }
+                }
+                if (!db->WriteBatch(batch)) {
+                    return error("%s: could not write bets of block %s", __func__, pindex->GetBlockHash().ToString());
+                }
+            }
+            catch (const std::exception& e) {
+                return error("%s: could not track bets of block %s: %s", __func__, pindex->GetBlockHash().ToString(), e.what());
+            }
+
+            for (const auto& change : changes) {
+                NotifyBetStatus(change.first, change.second);
+            }
+            return true;
+        }
+
+        void BetTracker::BlockDisconnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindexDelete, const std::vector<CTransactionRef>& vNameConflicts)
+        {
+            std::vector<std::pair<uint256, BetStatus>> changes;
+            {
+                LOCK(cs);
+                //makebets of the block go back to the mempool, payouts back to won
+                CDBBatch batch(*db);
+                for (const CTransactionRef& tx : block->vtx) {
+                    BetStatus status;
+                    if (isMakeBetTx(*tx)) {
+                        if (db->Read(std::make_pair(DB_BET, tx->GetHash()), status)) {
+                            batch.Erase(std::make_pair(DB_BET, tx->GetHash()));
+                            batch.Erase(std::make_pair(DB_BET_KEY, std::make_pair(status.keyID, tx->GetHash())));
+                        }
+                    }
+                    else if (isGetBetTx(*tx)) {
+                        for (const CTxIn& in : tx->vin) {
+                            if (db->Read(std::make_pair(DB_BET, in.prevout.hash), status) && status.getbetHash == tx->GetHash()) {
+                                status.state = BetStatus::WON;
+                                status.getbetHash.SetNull();
+                                batch.Write(std::make_pair(DB_BET, in.prevout.hash), status);
+                                changes.emplace_back(in.prevout.hash, status);
+                            }
+                        }
+                    }
+                }
+                if (!db->WriteBatch(batch)) {
+                    LogPrintf("%s: could not erase bets of block %s\n", __func__, pindexDelete->GetBlockHash().ToString());
+                    return;
+                }
+            }
+
+            for (const auto& change : changes) {
+                NotifyBetStatus(change.first, change.second);
+            }
+        }
+
+    }
+
+}
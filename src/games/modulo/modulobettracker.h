@@ -0,0 +1,111 @@
+// Copyright (c) 2018 Slawek Mozdzonek
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef MODULOBETTRACKER_H
+#define MODULOBETTRACKER_H
+
+#include <amount.h>
+#include <index/base.h>
+#include <pubkey.h>
+#include <serialize.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <boost/signals2/signal.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+static const bool DEFAULT_BETTRACKER = false;
+
+namespace modulo
+{
+
+    namespace ver_2
+    {
+
+        struct BetStatus
+        {
+            enum State : uint8_t
+            {
+                LOST = 0,
+                WON = 1,        //won, waiting for the getbet of the next block
+                PAID = 2,       //won and paid by getbetHash
+            };
+
+            uint8_t state;
+            uint256 blockHash;  //block of the makebet, its hash draws the result
+            int height;
+            CAmount amount;
+            CAmount payoff;
+            CKeyID keyID;       //bettor, the payoff goes to this key
+            uint256 getbetHash;
+
+            BetStatus() : state(LOST), height(0), amount(0), payoff(0) {}
+
+            ADD_SERIALIZE_METHODS;
+
+            template <typename Stream, typename Operation>
+            inline void SerializationOp(Stream& s, Operation ser_action) {
+                READWRITE(state);
+                READWRITE(blockHash);
+                READWRITE(height);
+                READWRITE(amount);
+                READWRITE(payoff);
+                READWRITE(keyID);
+                READWRITE(getbetHash);
+            }
+
+            std::string getStateName() const;
+        };
+
+        /**
+         * Settlement status of makebets, indexed block by block. A makebet is
+         * settled by the hash of its own block and paid by the getbet of the
+         * next one, so both events are recorded once per block instead of
+         * being recomputed by every client polling for results. Like the other
+         * indexes it stores the locator of the last block written and catches
+         * up from there when started, which covers blocks connected before
+         * -bettracker was set and writes lost in an unclean shutdown.
+         * Changes are announced through NotifyBetStatus (published on ZMQ).
+         */
+        class BetTracker final : public BaseIndex
+        {
+        protected:
+            class DB;
+
+        private:
+            const std::unique_ptr<DB> db;
+            //blocks connected while catching up and disconnected ones both update statuses
+            CCriticalSection cs;
+
+        protected:
+            bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+            void BlockDisconnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindexDelete, const std::vector<CTransactionRef>& vNameConflicts) override;
+
+            BaseIndex::DB& GetDB() const override;
+
+            const char* GetName() const override { return "bettracker"; }
+
+        public:
+            explicit BetTracker(size_t cacheSize, bool memory = false, bool wipe = false);
+            ~BetTracker() override;
+
+            bool getBetStatus(const uint256& makeBetHash, BetStatus& status) const;
+            //bets of a key (all bets when keyID is null), at most count of them after skipping skip
+            std::vector<std::pair<uint256, BetStatus>> listBets(const CKeyID& keyID, size_t count, size_t skip) const;
+
+            //static so that listeners can connect before the tracker is started
+            static boost::signals2::signal<void (const uint256& makeBetHash, const BetStatus& status)> NotifyBetStatus;
+        };
+
+        //null unless -bettracker is set
+        extern std::unique_ptr<BetTracker> g_betTracker;
+
+    }
+
+}
+
+#endif
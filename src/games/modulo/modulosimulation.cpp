@@ -0,0 +1,208 @@
+// Copyright (c) 2018 Slawek Mozdzonek
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <games/modulo/modulosimulation.h>
+#include <games/modulo/modulobet.h>
+#include <games/modulo/modulotxs.h>
+#include <games/modulo/moduloverify.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace modulo
+{
+
+    namespace ver_2
+    {
+
+        CAmount PayoutDistribution::getMaxPayout() const
+        {
+            CAmount maxPayout=0;
+            for(const auto& payout : payouts)
+            {
+                maxPayout=std::max(maxPayout, payout.second);
+            }
+            return maxPayout;
+        }
+
+        CAmount PayoutDistribution::getExpectedPayout() const
+        {
+            if(argument==0)
+            {
+                return 0;
+            }
+            //the sum of the payouts of all outcomes may be out of the range of CAmount
+            CAmount expected=0, remainder=0;
+            for(const auto& payout : payouts)
+            {
+                expected+=payout.second/argument;
+                remainder+=payout.second%argument;
+                expected+=remainder/argument;
+                remainder%=argument;
+            }
+            return expected;
+        }
+
+        std::map<CAmount, uint64_t> PayoutDistribution::getHistogram() const
+        {
+            std::map<CAmount, uint64_t> histogram;
+            if(payouts.size()<argument)
+            {
+                histogram[0]=argument-payouts.size();
+            }
+            for(const auto& payout : payouts)
+            {
+                ++histogram[payout.second];
+            }
+            return histogram;
+        }
+
+        bool BetSimulation::addBet(const CTransaction& tx, std::string& error)
+        {
+            if(isFull())
+            {
+                error="too many bets to simulate";
+                return false;
+            }
+            if(!isMakeBetTx(tx))
+            {
+                error="not a makebet transaction";
+                return false;
+            }
+
+            const ParsedBetRef bet=getParsedBet(tx);
+            if(bet->status!=ParsedBet::OK)
+            {
+                error="incorrect bet type";
+                return false;
+            }
+            const unsigned int argument=bet->argument;
+            if(argument==0 || argument>static_cast<unsigned int>(MAX_REWARD))
+            {
+                error="incorrect OP_RETURN argument";
+                return false;
+            }
+
+            //check all legs first, an invalid bet leaves the simulation unchanged
+            std::vector<std::vector<unsigned int>> winningArguments;
+            std::vector<CAmount> legPayouts;
+            CAmount rewardSum=0;
+            for(const Leg& leg : bet->legs)
+            {
+                const int reward=getBetReward(leg, argument);
+                if(reward<=0 || reward>MAX_REWARD)
+                {
+                    error="unknown bet type";
+                    return false;
+                }
+                if(leg.amount<=0 || leg.zeroSuffix)
+                {
+                    error="bet amount or number below limit";
+                    return false;
+                }
+                if(leg.amount>(MAX_PAYOFF-rewardSum)/reward)
+                {
+                    error="potential reward higher than admissible limit";
+                    return false;
+                }
+                try
+                {
+                    winningArguments.push_back(getWinningArguments(leg, argument));
+                }
+                catch(const std::runtime_error& e)
+                {
+                    error=e.what();
+                    return false;
+                }
+                legPayouts.push_back(leg.amount*reward);
+                rewardSum+=legPayouts.back();
+            }
+
+            ArgumentBets& bets=betsByArgument[argument];
+            for(size_t i=0;i<bet->legs.size();++i)
+            {
+                for(const unsigned int outcome : winningArguments[i])
+                {
+                    if(!bets.dense.empty())
+                    {
+                        bets.dense[outcome-1]+=legPayouts[i];
+                    }
+                    else
+                    {
+                        bets.sparse.emplace_back(outcome, legPayouts[i]);
+                    }
+                }
+                ++bets.bets;
+                bets.betsSum+=bet->legs[i].amount;
+            }
+            //the memory of an argument follows its winning outcomes, not the argument itself
+            if(bets.dense.empty() && bets.sparse.size()>=argument/2)
+            {
+                bets.dense.resize(argument);
+                for(const auto& payout : bets.sparse)
+                {
+                    bets.dense[payout.first-1]+=payout.second;
+                }
+                std::vector<std::pair<unsigned int, CAmount>>().swap(bets.sparse);
+            }
+            ++txCount;
+            return true;
+        }
+
+        size_t BetSimulation::size() const
+        {
+            return txCount;
+        }
+
+        bool BetSimulation::isFull() const
+        {
+            return txCount>=MAX_SIMULATED_BETS;
+        }
+
+        std::vector<PayoutDistribution> BetSimulation::getDistributions() const
+        {
+            std::vector<PayoutDistribution> distributions;
+            for(const auto& entry : betsByArgument)
+            {
+                const ArgumentBets& bets=entry.second;
+                PayoutDistribution distribution;
+                distribution.argument=entry.first;
+                distribution.bets=bets.bets;
+                distribution.betsSum=bets.betsSum;
+
+                if(!bets.dense.empty())
+                {
+                    for(size_t i=0;i<bets.dense.size();++i)
+                    {
+                        if(bets.dense[i]>0)
+                        {
+                            distribution.payouts.emplace_back(i+1, bets.dense[i]);
+                        }
+                    }
+                }
+                else
+                {
+                    //merge the payouts of the bets winning on the same outcome
+                    std::vector<std::pair<unsigned int, CAmount>> sparse=bets.sparse;
+                    std::sort(sparse.begin(), sparse.end());
+                    for(const auto& payout : sparse)
+                    {
+                        if(!distribution.payouts.empty() && distribution.payouts.back().first==payout.first)
+                        {
+                            distribution.payouts.back().second+=payout.second;
+                        }
+                        else
+                        {
+                            distribution.payouts.push_back(payout);
+                        }
+                    }
+                }
+                distributions.push_back(std::move(distribution));
+            }
+            return distributions;
+        }
+
+    }
+
+}
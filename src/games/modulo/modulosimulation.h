@@ -0,0 +1,84 @@
+// Copyright (c) 2018 Slawek Mozdzonek
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef MODULOSIMULATION_H
+#define MODULOSIMULATION_H
+
+#include <amount.h>
+#include <primitives/transaction.h>
+
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace modulo
+{
+
+    namespace ver_2
+    {
+
+        //keeps the payout sums of all bets below the range of CAmount
+        static const size_t MAX_SIMULATED_BETS=10000;
+
+        /** Payouts of the bets of one modulo argument for every outcome 1..argument of ModuloOperation. */
+        struct PayoutDistribution
+        {
+            unsigned int argument=0;
+            size_t bets=0;          //bets (legs) of all makebets of the argument
+            CAmount betsSum=0;
+            //outcomes paying anything with their payout, in ascending order; all other outcomes pay nothing
+            std::vector<std::pair<unsigned int, CAmount>> payouts;
+
+            CAmount getMaxPayout() const;
+            //payout averaged over all outcomes, each of them taken as equally likely
+            CAmount getExpectedPayout() const;
+            //number of outcomes of each payout, including the outcomes paying nothing
+            std::map<CAmount, uint64_t> getHistogram() const;
+        };
+
+        /**
+         * Payout distribution of a set of makebets over all block hashes. The
+         * bets are parsed once and the winning outcomes of every bet are added
+         * to per outcome payout arrays of its argument, instead of evaluating
+         * isWinning for every bet and outcome.
+         *
+         * The outcomes of different arguments are drawn from the same block
+         * hash, so only the distribution of each argument is exact; summed
+         * over the arguments, the expected payout is exact and the maximum is
+         * an upper bound.
+         */
+        class BetSimulation
+        {
+        public:
+            //adds the bets of a makebet, false with the reason if it is not a valid one
+            bool addBet(const CTransaction& tx, std::string& error);
+            size_t size() const;
+            //true once MAX_SIMULATED_BETS makebets were added, further ones are refused
+            bool isFull() const;
+
+            //distributions of the bets added so far, in ascending order of their argument
+            std::vector<PayoutDistribution> getDistributions() const;
+
+        private:
+            struct ArgumentBets
+            {
+                size_t bets=0;
+                CAmount betsSum=0;
+                //(outcome, payout) of every winning outcome of every bet, until there are argument/2 of them
+                std::vector<std::pair<unsigned int, CAmount>> sparse;
+                //then payout by outcome-1, so it is never larger than the sparse entries it replaces
+                std::vector<CAmount> dense;
+            };
+
+            std::map<unsigned int, ArgumentBets> betsByArgument;
+            size_t txCount=0;
+        };
+
+    }
+
+}
+
+#endif
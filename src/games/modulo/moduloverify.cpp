@@ -8,6 +8,8 @@
 #include <games/gamestxs.h>
 #include <games/gamesverify.h>
 #include <games/modulo/moduloverify.h>
+#include <games/modulo/modulobet.h>
+#include <games/modulo/modulobetindex.h>
 #include <games/modulo/modulotxs.h>
 #include <games/modulo/moduloutils.h>
 
@@ -16,252 +18,12 @@ namespace modulo
 
     int GetModuloReward::operator()(const std::string& betType, unsigned int modulo)
     {
-        if(betType.find("straight_")==0 || betType.find("STRAIGHT_")==0 || (betType.find_first_not_of( "0123456789" ) == std::string::npos))
-        {
-            return modulo;
-        }
-        else if((betType.find("split_")==0 || betType.find("SPLIT_")==0) && modulo==36)
-        {
-            return modulo/2;
-        }
-        else if((betType.find("street_")==0 || betType.find("STREET_")==0) && modulo==36)
-        {
-            return modulo/3;
-        }
-        else if((betType.find("corner_")==0 || betType.find("CORNER_")==0) && modulo==36)
-        {
-            return modulo/4;
-        }
-        else if((betType.find("line_")==0 || betType.find("LINE_")==0) && modulo==36)
-        {
-            return modulo/6;
-        }
-        else if((betType.find("column_")==0 || betType.find("COLUMN_")==0) && modulo==36)
-        {
-            return modulo/12;
-        }
-        else if((betType.find("dozen_")==0 || betType.find("DOZEN_")==0) && modulo==36)
-        {
-            return modulo/12;
-        }
-        else if((betType.find("low")==0 || betType.find("LOW")==0) && modulo==36)
-        {
-            return modulo/18;
-        }
-        else if((betType.find("high")==0 || betType.find("HIGH")==0) && modulo==36)
-        {
-            return modulo/18;
-        }
-        else if((betType.find("even")==0 || betType.find("EVEN")==0) && modulo==36)
-        {
-            return modulo/18;
-        }
-        else if((betType.find("odd")==0 || betType.find("ODD")==0) && modulo==36)
-        {
-            return modulo/18;
-        }
-        else if((betType.find("red")==0 || betType.find("RED")==0) && modulo==36)
-        {
-            return modulo/18;
-        }
-        else if((betType.find("black")==0 || betType.find("BLACK")==0) && modulo==36)
-        {
-            return modulo/18;
-        }
-        return 0;
+        return getBetReward(parseBetLeg(betType), modulo);
     }
 
     bool VerifyMakeModuloBetTx::isWinning(const std::string& betType, unsigned int maxArgument, unsigned int argument)
     {
-        int* bet;
-        int len=1;
-        if(betType.find_first_not_of( "0123456789" ) == std::string::npos)
-        {
-            int betNum;
-            try
-            {
-                betNum=std::stoi(betType);
-            }
-            catch(...)
-            {
-                throw std::runtime_error(std::string("VerifyMakeModuloBetTx::isWinning argument failed: ")+std::to_string(argument)+std::string(" betNum: ")+std::to_string(betNum));
-            }
-            if(betNum<1 || betNum>maxArgument)
-            {
-                throw std::runtime_error(std::string("VerifyMakeModuloBetTx::isWinning argument failed: ")+std::to_string(argument)+std::string(" maxArgument: ")+std::to_string(maxArgument)+std::string(" betNum: ")+std::to_string(betNum));
-            }
-            straight = betNum;
-            bet = const_cast<int* >(&straight);
-            len = 1;
-        }
-        else if((betType.find("straight_")==0 || betType.find("STRAIGHT_")==0) && maxArgument==36)
-        {
-            int betNum;
-            try
-            {
-                betNum=std::stoi(betType.substr(std::string("straight_").length()));
-            }
-            catch(...)
-            {
-                throw std::runtime_error(std::string("VerifyMakeModuloBetTx::isWinning argument failed: ")+std::to_string(argument)+std::string(" betNum: ")+std::to_string(betNum));
-            }
-            if(betNum<1 || betNum>36)
-            {
-                throw std::runtime_error(std::string("VerifyMakeModuloBetTx::isWinning argument failed: ")+std::to_string(argument)+std::string(" maxArgument: 36")+std::string(" betNum: ")+std::to_string(betNum));
-            }
-            straight = betNum;
-            bet = const_cast<int* >(&straight);
-            len = 1;
-        }
-        else if((betType.find("split_")==0 || betType.find("SPLIT_")==0) && maxArgument==36)
-        {
-            int betNum;
-            try
-            {
-                betNum=std::stoi(betType.substr(std::string("split_").length()));
-            }
-            catch(...)
-            {
-                throw std::runtime_error(std::string("VerifyMakeModuloBetTx::isWinning argument failed: ")+std::to_string(argument)+std::string(" betNum: ")+std::to_string(betNum));
-            }
-            if(betNum<1 || betNum>57)
-            {
-                throw std::runtime_error(std::string("VerifyMakeModuloBetTx::isWinning argument failed: ")+std::to_string(argument)+std::string(" maxArgument: 36")+std::string(" betNum: ")+std::to_string(betNum));
-            }
-            bet = const_cast<int* >(split[betNum-1]);
-            len = 2;
-        }
-        else if((betType.find("street_")==0 || betType.find("STREET_")==0) && maxArgument==36)
-        {
-            int betNum;
-            try
-            {
-                betNum=std::stoi(betType.substr(std::string("street_").length()));
-            }
-            catch(...)
-            {
-                throw std::runtime_error(std::string("VerifyMakeModuloBetTx::isWinning argument failed: ")+std::to_string(argument)+std::string(" betNum: ")+std::to_string(betNum));
-            }        
-            if(betNum<1 || betNum>12)
-            {
-                throw std::runtime_error(std::string("VerifyMakeModuloBetTx::isWinning argument failed: ")+std::to_string(argument)+std::string(" maxArgument: 36")+std::string(" betNum: ")+std::to_string(betNum));
-            }
-            bet = const_cast<int* >(street[betNum-1]);
-            len = 3;
-        }
-        else if((betType.find("corner_")==0 || betType.find("CORNER_")==0) && maxArgument==36)
-        {
-            int betNum;
-            try
-            {
-                betNum=std::stoi(betType.substr(std::string("corner_").length()));
-            }
-            catch(...)
-            {
-                throw std::runtime_error(std::string("VerifyMakeModuloBetTx::isWinning argument failed: ")+std::to_string(argument)+std::string(" betNum: ")+std::to_string(betNum));
-            }
-            if(betNum<1 || betNum>22)
-            {
-                throw std::runtime_error(std::string("VerifyMakeModuloBetTx::isWinning argument failed: ")+std::to_string(argument)+std::string(" maxArgument: 36")+std::string(" betNum: ")+std::to_string(betNum));
-            }
-            bet = const_cast<int* >(corner[betNum-1]);
-            len = 4;
-        }
-        else if((betType.find("line_")==0 || betType.find("LINE_")==0) && maxArgument==36)
-        {
-            int betNum;
-            try
-            {
-                betNum=std::stoi(betType.substr(std::string("line_").length()));
-            }
-            catch(...)
-            {
-                throw std::runtime_error(std::string("VerifyMakeModuloBetTx::isWinning argument failed: ")+std::to_string(argument)+std::string(" betNum: ")+std::to_string(betNum));
-            }
-            if(betNum<1 || betNum>11)
-            {
-                throw std::runtime_error(std::string("VerifyMakeModuloBetTx::isWinning argument failed: ")+std::to_string(argument)+std::string(" maxArgument: 36")+std::string(" betNum: ")+std::to_string(betNum));
-            }
-            bet = const_cast<int* >(line[betNum-1]);
-            len = 6;
-        }
-        else if((betType.find("column_")==0 || betType.find("COLUMN_")==0) && maxArgument==36)
-        {
-            int betNum;
-            try
-            {
-                betNum=std::stoi(betType.substr(std::string("column_").length()));
-            }
-            catch(...)
-            {
-                throw std::runtime_error(std::string("VerifyMakeModuloBetTx::isWinning argument failed: ")+std::to_string(argument)+std::string(" betNum: ")+std::to_string(betNum));
-            }
-            if(betNum<1 || betNum>3)
-            {
-                throw std::runtime_error(std::string("VerifyMakeModuloBetTx::isWinning argument failed: ")+std::to_string(argument)+std::string(" maxArgument: 36")+std::string(" betNum: ")+std::to_string(betNum));
-            }
-            bet = const_cast<int* >(column[betNum-1]);
-            len = 12;
-        }
-        else if((betType.find("dozen_")==0 || betType.find("DOZEN_")==0) && maxArgument==36)
-        {
-            int betNum;
-            try
-            {
-                betNum=std::stoi(betType.substr(std::string("dozen_").length()));
-            }
-            catch(...)
-            {
-                throw std::runtime_error(std::string("VerifyMakeModuloBetTx::isWinning argument failed: ")+std::to_string(argument)+std::string(" betNum: ")+std::to_string(betNum));
-            }
-            if(betNum<1 || betNum>3)
-            {
-                throw std::runtime_error(std::string("VerifyMakeModuloBetTx::isWinning argument failed: ")+std::to_string(argument)+std::string(" maxArgument: 36")+std::string(" betNum: ")+std::to_string(betNum));
-            }
-            bet = const_cast<int* >(dozen[betNum-1]);
-            len = 12;
-        }
-        else if((betType.find("low")==0 || betType.find("LOW")==0) && maxArgument==36)
-        {
-            bet = const_cast<int* >(low);
-            len = 18;
-        }
-        else if((betType.find("high")==0 || betType.find("HIGH")==0) && maxArgument==36)
-        {
-            bet = const_cast<int* >(high);
-            len = 18;
-        }
-        else if((betType.find("even")==0 || betType.find("EVEN")==0) && maxArgument==36)
-        {
-            bet = const_cast<int* >(even);
-            len = 18;
-        }
-        else if((betType.find("odd")==0 || betType.find("ODD")==0) && maxArgument==36)
-        {
-            bet = const_cast<int* >(odd);
-            len = 18;
-        }
-        else if((betType.find("red")==0 || betType.find("RED")==0) && maxArgument==36)
-        {
-            bet = const_cast<int* >(red);
-            len = 18;
-        }
-        else if((betType.find("black")==0 || betType.find("BLACK")==0) && maxArgument==36)
-        {
-            bet = const_cast<int* >(black);
-            len = 18;
-        }
-        else
-        {
-            return false;
-        }
-
-        int *item = std::find(bet, bet+len, argument);
-        if (item != bet+len) 
-        {
-            return true;
-        }
-        return false;
+        return isBetWinning(parseBetLeg(betType), maxArgument, argument);
     }
 
     bool CompareModuloBet2Vector::operator()(int nSpendHeight, const std::string& betTypePattern, const std::vector<int>& betNumbers)
@@ -319,8 +81,7 @@ namespace modulo
                                              block(block_), argumentOperation(argumentOperation_), getReward(getReward_), verifyMakeBetTx(verifyMakeBetTx_), makeBetIndicator(makeBetIndicator_), maxPayoff(maxPayoff_)
         {
             blockSubsidy=GetBlockSubsidy(chainActive.Height(), params);
-            uint256 hash=block.GetHash();
-            blockHash=blockHashStr2Int(hash.ToString());
+            blockHash=blockHash2Int(block.GetHash());
         }
 
         unsigned int VerifyBlockReward::getArgument(std::string& betType)
@@ -561,13 +322,13 @@ namespace modulo
             return true;
         }
 
-        static bool txGetBetVerify(int nSpendHeight, const CTransaction& tx, CAmount in, CAmount out, CAmount& fee, ArgumentOperation* operation, GetReward* getReward, CompareBet2Vector* compareBet2Vector, int32_t indicator, CAmount maxPayoff, int32_t maxReward)
+        static bool txGetBetVerify(int nSpendHeight, int nPrevHeight, const CTransaction& tx, CAmount in, CAmount out, CAmount& fee, ArgumentOperation* operation, GetReward* getReward, CompareBet2Vector* compareBet2Vector, int32_t indicator, CAmount maxPayoff, int32_t maxReward)
         {
             fee=0;
             UniValue txPrev(UniValue::VOBJ);
             try
             {
-                txPrev=findTx(tx.vin[0].prevout.hash.GetHex());
+                txPrev=findTxInBlock(tx.vin[0].prevout.hash, nPrevHeight);
             }
             catch(...)
             {
@@ -884,14 +645,15 @@ namespace modulo
             return true;
         }
 
-        bool txGetBetVerify(int nSpendHeight, const CTransaction& tx, CAmount in, CAmount out, CAmount& fee)
+        bool txGetBetVerify(int nSpendHeight, const CCoinsViewCache& inputs, const CTransaction& tx, CAmount in, CAmount out, CAmount& fee)
         {
             try
             {
                 ModuloOperation moduloOperation;
                 GetModuloReward getModuloReward;
                 CompareModuloBet2Vector compareModulobet2Vector;
-                return txGetBetVerify(nSpendHeight, tx, in, out, fee, &moduloOperation, &getModuloReward, &compareModulobet2Vector, MAKE_MODULO_GAME_INDICATOR, MAX_PAYOFF, MAX_REWARD);
+                const int nPrevHeight = inputs.AccessCoin(tx.vin[0].prevout).nHeight;
+                return txGetBetVerify(nSpendHeight, nPrevHeight, tx, in, out, fee, &moduloOperation, &getModuloReward, &compareModulobet2Vector, MAKE_MODULO_GAME_INDICATOR, MAX_PAYOFF, MAX_REWARD);
             }
             catch(...)
             {
@@ -973,67 +735,49 @@ namespace modulo
         {
             try{
                 //example bet: 00000024_black@200000000+red@100000000
-                size_t idx;
-                std::string betType = getBetType(m_tx, idx);
-                if (betType.empty()) {
+                const ParsedBetRef bet = getParsedBet(m_tx);
+                if (bet->status == ParsedBet::EMPTY_PAYLOAD) {
                     throw std::runtime_error("Improper bet type");
                 }
-                //LogPrintf("betType = %s\n", betType.c_str());
 
-                if(idx) {
-                    throw std::runtime_error(strprintf("Bet type idx is not zero: %d\n", idx));
+                if(bet->opReturnIdx) {
+                    throw std::runtime_error(strprintf("Bet type idx is not zero: %d\n", bet->opReturnIdx));
                 }
 
-                const unsigned argument = getArgumentFromBetType(betType);
-                //LogPrintf("argument = %u\n", argument);
-
-                const std::string blockhashStr = m_hash.ToString();
-                //LogPrintf("blockhashStr = %s\n", blockhashStr.c_str());
+                if (bet->status == ParsedBet::BAD_ARGUMENT) {
+                    throw std::runtime_error("Improper bet argument");
+                }
+                const unsigned argument = bet->argument;
 
-                const unsigned int blockhashTmp = blockHashStr2Int(blockhashStr);
-                //LogPrintf("blockhashTmp = %u\n", blockhashTmp);
+                const unsigned int blockhashTmp = blockHash2Int(m_hash);
 
                 ModuloOperation moduloOperation;
                 moduloOperation.setArgument(argument);
                 const unsigned argumentResult = moduloOperation(blockhashTmp);
-                //LogPrintf("argumenteResult = %u\n", argumentResult);
 
-                while (true) {
-                    const size_t typePos = betType.find("@");
-                    if (typePos == std::string::npos) {
-                        throw std::runtime_error("Improper bet type");
-                    }
-
-                    const std::string type = betType.substr(0, typePos);
-                    betType = betType.substr(typePos+1);
-
-                    const size_t amountPos = betType.find("+");
-                    const std::string amountStr = betType.substr(0, amountPos);
-
-                    CAmount amount = std::stoll(amountStr);
-                    if (amount<=0) {
+                for (const Leg& leg : bet->legs) {
+                    if (leg.amount<=0) {
                         throw std::runtime_error("Improper bet amount");
                     }
 
-                    if (VerifyMakeModuloBetTx().isWinning(type, argument, argumentResult)) {
-                        const unsigned reward = GetModuloReward()(type, argument);
-                        //LogPrintf("reward = %u\n", reward);
+                    if (isBetWinning(leg, argument, argumentResult)) {
+                        const unsigned reward = getBetReward(leg, argument);
 
-                        const CAmount wonAmount = reward*amount;
+                        const CAmount wonAmount = reward*leg.amount;
                         if (wonAmount>MAX_CAMOUNT-m_payoff) {
                             throw std::runtime_error("Improper bet amount");
                         }
                         m_payoff += wonAmount;
-                        //LogPrintf("%s is winning\n", type.c_str());
                     }
+                }
 
-                    if (amountPos == std::string::npos) {
-                        break;
-                    }
-                    betType = betType.substr(amountPos+1);
+                if (bet->status == ParsedBet::MISSING_AT) {
+                    throw std::runtime_error("Improper bet type");
+                }
+                if (bet->status == ParsedBet::BAD_AMOUNT) {
+                    throw std::runtime_error("Improper bet amount");
                 }
 
-                //LogPrintf("m_payoff = %d\n", m_payoff);
                 if (m_payoff <= 0) {
                     return false;
                 }
@@ -1066,35 +810,17 @@ namespace modulo
 
         bool txGetBetVerify(const uint256& hashPrevBlock, const CBlock& currentBlock, const Consensus::Params& params, CAmount& fee)
         {
-            struct MakeBetData {
-                CTxOut out;
-                CAmount payoff;
-                CKeyID keyID;
-            };
-
-            std::map<uint256, MakeBetData> prevBlockWinningBets;
-            const CBlockIndex* pindexPrev = LookupBlockIndex(hashPrevBlock);
-            CBlock prevBlock;
-
-            if (ReadBlockFromDisk(prevBlock, pindexPrev, params)) {
-                for (unsigned int i = 0; i < prevBlock.vtx.size(); i++) {
-                    const CTransaction& tx = *(prevBlock.vtx[i]);
-
-                    if (modulo::ver_2::isMakeBetTx(tx)) {
-                        MakeBetWinningProcess makeBetWinningProcess(tx, hashPrevBlock);
-                        if (makeBetWinningProcess.isMakeBetWinning()) {
-                            const CAmount payoff = makeBetWinningProcess.getMakeBetPayoff();
-                            const CKeyID keyID = getTxKeyID(tx);
-                            prevBlockWinningBets[tx.GetHash()] = MakeBetData{tx.vout[0], payoff, keyID};
-                        }
-                    }
-                }
-            }
-            else {
+            const WinningBetsRef winningBets = g_winningBets.getWinningBets(LookupBlockIndex(hashPrevBlock), params);
+            if (winningBets == nullptr) {
                 LogPrintf("Error: could not read previous block: %s\n", hashPrevBlock.ToString().c_str());
                 return false;
             }
 
+            std::map<uint256, const MakeBetData*> prevBlockWinningBets;
+            for (const MakeBetData& makeBetData : *winningBets) {
+                prevBlockWinningBets[makeBetData.hash] = &makeBetData;
+            }
+
             CTransactionRef getBet;
             for (const CTransactionRef& tx: currentBlock.vtx) {
                 if (modulo::ver_2::isGetBetTx(*tx)) {
@@ -1133,7 +859,7 @@ namespace modulo
                     return false;
                 }
 
-                MakeBetData& makeBetData = iter->second;
+                const MakeBetData& makeBetData = *iter->second;
                 const int NoFeeGetBetOffset = 121;
                 if (chainActive.Height() > params.GamesVersion2 + NoFeeGetBetOffset) {
                     if (makeBetData.payoff != output.nValue) {
@@ -1173,41 +899,24 @@ namespace modulo
             return true;
         }
 
-        bool is_lottery(const std::string& betStr)
-        {
-            return betStr.find_first_not_of("0123456789") == std::string::npos;
-        }
-
-        bool checkBetNumberLimit(int mod_argument, const std::string& bet_type)
+        bool checkBetNumberLimit(int mod_argument, const Leg& leg)
         {
-            if (is_lottery(bet_type))
+            if (leg.kind == BetKind::LOTTERY)
             {
-                unsigned int betAmount = 0;
-                try {
-                    betAmount = std::stoi(bet_type);
-                } catch (...) {}
-                if (betAmount == 0)
+                if (leg.zeroSuffix)
                 {
-                    LogPrintf("%s:ERROR bet amount below limit %u\n", __func__, betAmount);
+                    LogPrintf("%s:ERROR bet amount below limit %u\n", __func__, leg.index);
                     return false;
                 }
-                if ((int)betAmount > mod_argument)
+                if (leg.index > mod_argument)
                 {
-                    LogPrintf("%s:ERROR bet amount: %u above game limit %u\n", __func__, betAmount, mod_argument);
+                    LogPrintf("%s:ERROR bet amount: %u above game limit %u\n", __func__, leg.index, mod_argument);
                     return false;
                 }
-            } else
+            } else if (leg.zeroSuffix)
             {
-                size_t pos_ = bet_type.find_last_of("_");
-                if (pos_ != std::string::npos && pos_ < bet_type.length()-1)
-                {
-                    unsigned int betAmount = std::stoi(bet_type.substr(pos_+1, std::string::npos));
-                    if (betAmount == 0)
-                    {
-                        LogPrintf("%s:ERROR bet amount below limit %u\n", __func__, betAmount);
-                        return false;
-                    }
-                }
+                LogPrintf("%s:ERROR bet amount below limit\n", __func__);
+                return false;
             }
             return true;
         }
@@ -1232,46 +941,37 @@ namespace modulo
                     LogPrintf("modulo_ver_2::txMakeBetVerify: tx.size incorrect: %d\n", tx.vout.size());
                     return false;
                 }
-                
-                size_t opReturnIdx;
-                std::string betType = getBetType(tx, opReturnIdx);
-                if(betType.empty())
+
+                const ParsedBetRef bet = getParsedBet(tx);
+                if(bet->status == ParsedBet::EMPTY_PAYLOAD)
                 {
                     LogPrintf("modulo_ver_2::txMakeBetVerify: betType is empty\n");
                     return false;
                 }
-                
-                if(opReturnIdx)
+
+                if(bet->opReturnIdx)
                 {
                     LogPrintf("modulo_ver_2::txMakeBetVerify: opReturnIdx is not zero\n");
                     return false;
                 }
 
-                unsigned int argument = getArgumentFromBetType(betType, MAX_REWARD);
+                if(bet->status == ParsedBet::BAD_ARGUMENT || bet->argument > static_cast<unsigned int>(MAX_REWARD))
+                {
+                    LogPrintf("modulo_ver_2::txMakeBetVerify: incorrect OP_RETURN argument\n");
+                    return false;
+                }
+                unsigned int argument = bet->argument;
 
                 // check does reward of each single bet is not over limit
                 CAmount amountSum = 0;
-                while (true)
+                for (const Leg& leg : bet->legs)
                 {
-                    const size_t typePos = betType.find("@");
-                    if (typePos == std::string::npos)
-                    {
-                        LogPrintf("%s: Incorrect bet type: %s\n", __func__, betType.c_str());
-                        return false;
-                    }
-
-                    const std::string type = betType.substr(0, typePos);
-                    betType = betType.substr(typePos + 1);
-
-                    const size_t amountPos = betType.find("+");
-                    const std::string amountStr = betType.substr(0, amountPos);
-                    CAmount amount = std::stoll(amountStr);
-                    const unsigned reward = GetModuloReward()(type, argument);
-                    amountSum += amount;
+                    const unsigned reward = getBetReward(leg, argument);
+                    amountSum += leg.amount;
 
                     if (reward == 0)
                     {
-                        LogPrintf("%s:ERROR unknown bet type %s\n", __func__, betType.c_str());
+                        LogPrintf("%s:ERROR unknown bet type\n", __func__);
                         return false;
                     }
 
@@ -1281,25 +981,24 @@ namespace modulo
                         return false;
                     }
 
-                    if (amount == 0)
+                    if (leg.amount == 0)
                     {
-                        LogPrintf("%s:ERROR amount below limit %u\n", __func__, amount);
+                        LogPrintf("%s:ERROR amount below limit %u\n", __func__, leg.amount);
                         return false;
                     }
 
-                    if (!checkBetNumberLimit(argument, type))
+                    if (!checkBetNumberLimit(argument, leg))
                     {
                         return false;
                     }
+                }
 
-                    if (amountPos == std::string::npos)
-                    {
-                        break;
-                    }
-
-                    betType = betType.substr(amountPos + 1);
+                if (bet->status != ParsedBet::OK)
+                {
+                    LogPrintf("%s: Incorrect bet type\n", __func__);
+                    return false;
                 }
-                
+
                 if (amountSum != tx.vout[0].nValue)
                 {
                     LogPrintf("%s:ERROR amount mismatch between script: %d and nValue: %d\n", __func__, amountSum, tx.vout[0].nValue);
@@ -1332,6 +1031,22 @@ namespace modulo
             }
         };
 
+        //sum of all potential wins in block should be less than MAX_PAYOFF and sum of all bets not higher than 90% of block subsidy
+        static bool isPotentialRewardWithinLimit(CAmount rewardSum, CAmount betsSum, CAmount blockSubsidy)
+        {
+            if (rewardSum > MAX_PAYOFF)
+            {
+                LogPrintf("%s: ERROR potential:%ld max:%ld\n", __func__, rewardSum, MAX_PAYOFF);
+                return false;
+            }
+            if (betsSum > ((9*blockSubsidy)/10))
+            {
+                LogPrintf("%s:ERROR Sum of all bets: %d higher than 90%% of blockSubsidy: %d\n", __func__, betsSum, blockSubsidy);
+                return false;
+            }
+            return true;
+        }
+
         bool checkBetsPotentialReward(CAmount &rewardSum, CAmount &betsSum, const CTransaction& txn)
         {
             if (isMakeBetTx(txn))
@@ -1354,6 +1069,37 @@ namespace modulo
             return true;
         };
 
+        bool getBetsPotentialReward(CAmount &rewardSum, CAmount &betsSum, const CTransaction& txn)
+        {
+            if (isMakeBetTx(txn))
+            {
+                try
+                {
+                    CBlock block;
+                    VerifyMakeModuloBetTx verifyMakeModuloBetTx;
+                    ModuloOperation moduloOperation;
+                    GetModuloReward getModuloReward;
+                    VerifyBlockReward verifyBlockReward(Params().GetConsensus(), block, &moduloOperation, &getModuloReward, &verifyMakeModuloBetTx);
+                    return verifyBlockReward.addPotentialReward(rewardSum, betsSum, txn);
+                }
+                catch(...)
+                {
+                    LogPrintf("modulo::getBetsPotentialReward exception occured\n");
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool isBetsPotentialRewardWithinLimit(CAmount rewardSum, CAmount betsSum, int height, const Consensus::Params& params)
+        {
+            if (height < params.GamesVersion2)
+            {
+                return true;
+            }
+            return isPotentialRewardWithinLimit(rewardSum, betsSum, GetBlockSubsidy(height, params));
+        }
+
         CAmount getSumOfTxnBets(const CTransaction& txn)
         {
             try
@@ -1384,8 +1130,7 @@ namespace modulo
                                              block(block_), argumentOperation(argumentOperation_), getReward(getReward_), verifyMakeBetTx(verifyMakeBetTx_)
         {
             blockSubsidy=GetBlockSubsidy(chainActive.Height(), params);
-            uint256 hash=block.GetHash();
-            blockHash=blockHashStr2Int(hash.ToString());
+            blockHash=blockHash2Int(block.GetHash());
         }
 
         bool VerifyBlockReward::isBetPayoffExceeded()
@@ -1404,49 +1149,45 @@ namespace modulo
                 {
                     if(isMakeBetTx(*tx))
                     {
-                        std::string betType=getBetType(*tx);
-                        if(betType.empty())
+                        const ParsedBetRef bet=getParsedBet(*tx);
+                        if(bet->status==ParsedBet::EMPTY_PAYLOAD)
                         {
                             LogPrintf("isBetPayoffExceeded: empty betType\n");
                             continue;
                         }
+                        if(bet->status==ParsedBet::BAD_ARGUMENT)
+                        {
+                            LogPrintf("isBetPayoffExceeded: argumentOperation failed\n");
+                            continue;
+                        }
 
-                        unsigned int argument=getArgumentFromBetType(betType);
+                        unsigned int argument=bet->argument;
                         ModuloOperation moduloOperation;
                         moduloOperation.setArgument(argument);
                         argumentResult = moduloOperation(blockHash);
 
-                        while (true)
+                        for (const Leg& leg : bet->legs)
                         {
-                            const size_t typePos = betType.find("@");
-                            if (typePos == std::string::npos)
-                            {
-                                LogPrintf("%s: Incorrect bet type: %s\n", __func__, betType.c_str());
-                                return true;
-                            }
-
-                            const std::string type = betType.substr(0, typePos);
-                            betType = betType.substr(typePos + 1);
-
-                            const size_t amountPos = betType.find("+");
-                            const std::string amountStr = betType.substr(0, amountPos);
-                            CAmount amount = std::stoll(amountStr);
-                            const unsigned reward = GetModuloReward()(type, argument);
+                            const unsigned reward = getBetReward(leg, argument);
 
                             CAmount payoff{};
-                            if (verifyMakeBetTx->isWinning(type, argument, argumentResult))
+                            if (isBetWinning(leg, argument, argumentResult))
                             {
-                                payoff = amount * reward;
+                                payoff = leg.amount * reward;
                                 payoffAcc += payoff;
                             }
-                            inAcc += amount;
-
-                            if (amountPos == std::string::npos)
-                            {
-                                break;
-                            }
+                            inAcc += leg.amount;
+                        }
 
-                            betType = betType.substr(amountPos + 1);
+                        if (bet->status == ParsedBet::MISSING_AT)
+                        {
+                            LogPrintf("%s: Incorrect bet type\n", __func__);
+                            return true;
+                        }
+                        if (bet->status == ParsedBet::BAD_AMOUNT)
+                        {
+                            LogPrintf("isBetPayoffExceeded: argumentOperation failed\n");
+                            continue;
                         }
                     }
                 }
@@ -1479,61 +1220,50 @@ namespace modulo
                 return true;
             }
 
-            std::string betType = getBetType(txn);
-            if (betType.empty())
+            if (!addPotentialReward(rewardSum, betsSum, txn))
             {
-                LogPrintf("%s: Bet type empty\n", __func__);
                 return false;
             }
-            unsigned int argument = getArgumentFromBetType(betType);
-
-            while (true)
-            {
-                const size_t typePos = betType.find("@");
-                if (typePos == std::string::npos)
-                {
-                    LogPrintf("%s: Incorrect bet type: %s\n", __func__, betType.c_str());
-                    return false;
-                }
 
-                const std::string type = betType.substr(0, typePos);
-                betType = betType.substr(typePos + 1);
+            return isPotentialRewardWithinLimit(rewardSum, betsSum, blockSubsidy);
+        }
 
-                const size_t amountPos = betType.find("+");
-                const std::string amountStr = betType.substr(0, amountPos);
+        bool VerifyBlockReward::addPotentialReward(CAmount &rewardSum, CAmount &betsSum, const CTransaction &txn)
+        {
+            const ParsedBetRef bet = getParsedBet(txn);
+            if (bet->status == ParsedBet::EMPTY_PAYLOAD)
+            {
+                LogPrintf("%s: Bet type empty\n", __func__);
+                return false;
+            }
+            if (bet->status == ParsedBet::BAD_ARGUMENT)
+            {
+                throw std::runtime_error("VerifyBlockReward::addPotentialReward() incorrect OP_RETURN argument");
+            }
+            unsigned int argument = bet->argument;
 
-                CAmount amount = std::stoll(amountStr);
-                const unsigned reward = GetModuloReward()(type, argument);
+            for (const Leg& leg : bet->legs)
+            {
+                const unsigned reward = getBetReward(leg, argument);
                 if (reward > MAX_REWARD)
                 {
                     LogPrintf("%s: ERROR potential reward of one bet %ld higher than admissible limit: %ld\n", __func__, reward, MAX_REWARD);
                     return false;
                 }
 
-                CAmount payoff = reward * amount;
-                betsSum += amount;
+                CAmount payoff = reward * leg.amount;
+                betsSum += leg.amount;
                 rewardSum += payoff;
-
-                if (amountPos == std::string::npos)
-                {
-                    break;
-                }
-
-                betType = betType.substr(amountPos + 1);
-
             }
 
-            // sum of all potential wins in block should be less than MAX_PAYOFF
-            if (rewardSum > MAX_PAYOFF)
+            if (bet->status == ParsedBet::MISSING_AT)
             {
-                LogPrintf("%s: ERROR potential:%ld max:%ld\n", __func__, rewardSum, MAX_PAYOFF);
+                LogPrintf("%s: Incorrect bet type\n", __func__);
                 return false;
             }
-            // sum of all bets higher than 90% of block subsidy
-            if (betsSum > ((9*blockSubsidy)/10))
+            if (bet->status == ParsedBet::BAD_AMOUNT)
             {
-                LogPrintf("%s:ERROR Sum of all bets: %d higher than 90%% of blockSubsidy: %d\n", __func__, betsSum, blockSubsidy);
-                return false;
+                throw std::invalid_argument("VerifyBlockReward::addPotentialReward() incorrect bet amount");
             }
 
             return true;
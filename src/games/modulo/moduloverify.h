@@ -7,6 +7,8 @@
 
 #include <games/gamesverify.h>
 
+class CCoinsViewCache;
+
 namespace modulo
 {
 
@@ -55,7 +57,8 @@ namespace modulo
         
         bool isMakeBetTx(const CTransaction& tx);
         bool isInputBet(const CTxIn& input);
-        bool txGetBetVerify(int nSpendHeight, const CTransaction& tx, CAmount in, CAmount out, CAmount& fee);
+        //the makebet spent by tx is read from the block of the coin it creates in inputs
+        bool txGetBetVerify(int nSpendHeight, const CCoinsViewCache& inputs, const CTransaction& tx, CAmount in, CAmount out, CAmount& fee);
         bool isBetPayoffExceeded(const Consensus::Params& params, const CBlock& block);
         bool txMakeBetVerify(const CTransaction& tx);
     };
@@ -69,6 +72,8 @@ namespace modulo
                               GetReward* getReward, VerifyMakeBetTx* verifyMakeBetTx);
             bool isBetPayoffExceeded();
             bool checkPotentialRewardLimit(CAmount &rewardSum, CAmount &betsSum, const CTransaction& txn);
+            //adds the bets and potential rewards of a makebet to the sums, without checking the block limits
+            bool addPotentialReward(CAmount &rewardSum, CAmount &betsSum, const CTransaction& txn);
             CAmount getSumOfTxnBets(const CTransaction& txn);
         private:
             const CBlock& block;
@@ -99,6 +104,10 @@ namespace modulo
         bool txMakeBetVerify(const CTransaction& tx);
         bool isBetPayoffExceeded(const Consensus::Params& params, const CBlock& block);
         bool checkBetsPotentialReward(CAmount& rewardSum, CAmount &betsSum, const CTransaction& txn);
+        //like checkBetsPotentialReward, without the block limits, which isBetsPotentialRewardWithinLimit checks
+        //for the sums of a block on top of the given height
+        bool getBetsPotentialReward(CAmount& rewardSum, CAmount &betsSum, const CTransaction& txn);
+        bool isBetsPotentialRewardWithinLimit(CAmount rewardSum, CAmount betsSum, int height, const Consensus::Params& params);
         CAmount getSumOfTxnBets(const CTransaction& txn);
     };
     
@@ -0,0 +1,84 @@
+// Copyright (c) 2018 Slawek Mozdzonek
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/bettxindex.h>
+#include <index/disktxpos.h>
+#include <games/gamesverify.h>
+#include <util.h>
+
+constexpr char DB_BETTXINDEX = 't';
+
+std::unique_ptr<BetTxIndex> g_bettxindex;
+
+/** Access to the bettxindex database (indexes/bettxindex/) */
+class BetTxIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Read the disk location of the transaction data with the given hash. Returns false if the
+    /// transaction hash is not indexed.
+    bool ReadTxPos(const uint256& txid, CDiskTxPos& pos) const;
+
+    /// Write a batch of transaction positions to the DB.
+    bool WriteTxs(const std::vector<std::pair<uint256, CDiskTxPos>>& v_pos);
+};
+
+BetTxIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "bettxindex", n_cache_size, f_memory, f_wipe)
+{}
+
+bool BetTxIndex::DB::ReadTxPos(const uint256 &txid, CDiskTxPos& pos) const
+{
+    return Read(std::make_pair(DB_BETTXINDEX, txid), pos);
+}
+
+bool BetTxIndex::DB::WriteTxs(const std::vector<std::pair<uint256, CDiskTxPos>>& v_pos)
+{
+    CDBBatch batch(*this);
+    for (const auto& tuple : v_pos) {
+        batch.Write(std::make_pair(DB_BETTXINDEX, tuple.first), tuple.second);
+    }
+    return WriteBatch(batch);
+}
+
+BetTxIndex::BetTxIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<BetTxIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+BetTxIndex::~BetTxIndex() {}
+
+bool BetTxIndex::IsIndexed(const CTransaction& tx)
+{
+    if (tx.IsCoinBase()) {
+        return false;
+    }
+    return isBetTx(tx, MAKE_MODULO_GAME_INDICATOR) || isBetTx(tx, MAKE_MODULO_NEW_GAME_INDICATOR) ||
+        isBetTx(tx, GET_MODULO_NEW_GAME_INDICATOR);
+}
+
+bool BetTxIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    CDiskTxPos pos(pindex->GetBlockPos(), GetSizeOfCompactSize(block.vtx.size()));
+    std::vector<std::pair<uint256, CDiskTxPos>> vPos;
+    for (const auto& tx : block.vtx) {
+        if (IsIndexed(*tx)) {
+            vPos.emplace_back(tx->GetHash(), pos);
+        }
+        pos.nTxOffset += ::GetSerializeSize(*tx, CLIENT_VERSION);
+    }
+    return vPos.empty() || m_db->WriteTxs(vPos);
+}
+
+BaseIndex::DB& BetTxIndex::GetDB() const { return *m_db; }
+
+bool BetTxIndex::FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const
+{
+    CDiskTxPos postx;
+    if (!m_db->ReadTxPos(tx_hash, postx)) {
+        return false;
+    }
+
+    return ReadTxFromDisk(postx, tx_hash, block_hash, tx);
+}
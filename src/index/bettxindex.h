@@ -0,0 +1,57 @@
+// Copyright (c) 2018 Slawek Mozdzonek
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_BETTXINDEX_H
+#define BITCOIN_INDEX_BETTXINDEX_H
+
+#include <chain.h>
+#include <index/base.h>
+
+static const bool DEFAULT_BETTXINDEX = true;
+
+/**
+ * BetTxIndex is a lightweight alternative to TxIndex for nodes running
+ * without -txindex. It records the filesystem location of game (makebet,
+ * getbet) transactions only, which is what findTx callers look up. It is
+ * never used by consensus code, whose result must not depend on whether an
+ * index has caught up with the chain.
+ */
+class BetTxIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "bettxindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit BetTxIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~BetTxIndex() override;
+
+    /// Look up a game transaction by hash.
+    ///
+    /// @param[in]   tx_hash  The hash of the transaction to be returned.
+    /// @param[out]  block_hash  The hash of the block the transaction is found in.
+    /// @param[out]  tx  The transaction itself.
+    /// @return  true if transaction is found, false otherwise
+    bool FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const;
+
+    /// Whether a transaction is recorded by this index.
+    static bool IsIndexed(const CTransaction& tx);
+};
+
+/// The global game transaction index, used by findTx. May be null.
+extern std::unique_ptr<BetTxIndex> g_bettxindex;
+
+#endif // BITCOIN_INDEX_BETTXINDEX_H
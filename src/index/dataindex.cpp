@@ -0,0 +1,105 @@
+// Copyright (c) 2018 Slawek Mozdzonek
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/dataindex.h>
+#include <data/datautils.h>
+#include <data/documentproof.h>
+#include <hash.h>
+#include <util.h>
+
+constexpr char DB_DATAINDEX = 'd';
+
+std::unique_ptr<DataIndex> g_dataindex;
+
+/** Access to the dataindex database (indexes/dataindex/) */
+class DataIndex::DB : public BaseIndex::DB
+{
+public:
+    typedef std::pair<char, std::pair<uint256, uint256>> Key;     // data hash, txid
+    typedef std::pair<int, uint256> Value;                          // height, block hash
+
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    bool ReadCommitments(const uint256& data_hash, std::vector<DataCommitment>& commitments) const;
+
+    bool WriteCommitments(const std::vector<std::pair<uint256, DataCommitment>>& commitments);
+};
+
+DataIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "dataindex", n_cache_size, f_memory, f_wipe)
+{}
+
+bool DataIndex::DB::ReadCommitments(const uint256& data_hash, std::vector<DataCommitment>& commitments) const
+{
+    std::unique_ptr<CDBIterator> cursor(const_cast<DataIndex::DB*>(this)->NewIterator());
+    for (cursor->Seek(Key(DB_DATAINDEX, std::make_pair(data_hash, uint256()))); cursor->Valid(); cursor->Next()) {
+        Key key;
+        Value value;
+        if (!cursor->GetKey(key) || key.first != DB_DATAINDEX || key.second.first != data_hash) {
+            break;
+        }
+        if (!cursor->GetValue(value)) {
+            return error("%s: cannot read value of %s", __func__, key.second.second.ToString());
+        }
+        commitments.push_back(DataCommitment{key.second.second, value.first, value.second});
+    }
+    return true;
+}
+
+bool DataIndex::DB::WriteCommitments(const std::vector<std::pair<uint256, DataCommitment>>& commitments)
+{
+    CDBBatch batch(*this);
+    for (const auto& entry : commitments) {
+        const DataCommitment& commitment = entry.second;
+        batch.Write(Key(DB_DATAINDEX, std::make_pair(entry.first, commitment.txid)),
+                    Value(commitment.height, commitment.block_hash));
+    }
+    return WriteBatch(batch);
+}
+
+DataIndex::DataIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<DataIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+DataIndex::~DataIndex() {}
+
+bool DataIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    std::vector<std::pair<uint256, DataCommitment>> commitments;
+    for (const auto& tx : block.vtx) {
+        if (tx->IsCoinBase()) {
+            continue;
+        }
+
+        Span<const unsigned char> data;
+        size_t idx;
+        if (!getOpReturnData(*tx, data, idx)) {
+            continue;
+        }
+
+        const DataCommitment commitment{tx->GetHash(), pindex->nHeight, pindex->GetBlockHash()};
+        uint256 data_hash;
+        // Same double SHA256 as documents hashed by the data RPCs
+        CHash256().Write(data.data(), data.size()).Finalize(data_hash.begin());
+        commitments.emplace_back(data_hash, commitment);
+        // Digests stored by storesignature(s) are found by themselves: a single
+        // digest, or the Merkle root of a documents commitment.
+        uint256 root;
+        uint32_t count;
+        if (data.size() == static_cast<std::ptrdiff_t>(data_hash.size())) {
+            commitments.emplace_back(uint256(std::vector<unsigned char>(data.begin(), data.end())), commitment);
+        } else if (parseDocumentsCommitment(data, root, count)) {
+            commitments.emplace_back(root, commitment);
+        }
+    }
+    return commitments.empty() || m_db->WriteCommitments(commitments);
+}
+
+BaseIndex::DB& DataIndex::GetDB() const { return *m_db; }
+
+bool DataIndex::FindData(const uint256& data_hash, std::vector<DataCommitment>& commitments) const
+{
+    commitments.clear();
+    return m_db->ReadCommitments(data_hash, commitments);
+}
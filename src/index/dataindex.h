@@ -0,0 +1,61 @@
+// Copyright (c) 2018 Slawek Mozdzonek
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_DATAINDEX_H
+#define BITCOIN_INDEX_DATAINDEX_H
+
+#include <chain.h>
+#include <index/base.h>
+
+#include <vector>
+
+static const bool DEFAULT_DATAINDEX = false;
+
+/** A block storing data with a given hash. */
+struct DataCommitment
+{
+    uint256 txid;
+    int height;
+    uint256 block_hash;
+};
+
+/**
+ * DataIndex is used to find the transactions committing to a document.
+ * It maps the double SHA256 of every OP_RETURN payload, the hash that
+ * storesignature(s), checkdata and checkmessage compute, and the payload itself
+ * when it is a 32-byte digest stored by storesignature(s), to the
+ * transactions carrying it.
+ */
+class DataIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "dataindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit DataIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~DataIndex() override;
+
+    /// Look up the transactions committing to a hash, in the order they were indexed.
+    /// Blocks disconnected by a reorg are reported as well; callers check
+    /// block_hash against the active chain.
+    bool FindData(const uint256& data_hash, std::vector<DataCommitment>& commitments) const;
+};
+
+/// The global data commitment index, used by the finddata rpc. May be null.
+extern std::unique_ptr<DataIndex> g_dataindex;
+
+#endif // BITCOIN_INDEX_DATAINDEX_H
@@ -17,13 +17,18 @@
 #include <compat/sanity.h>
 #include <consensus/validation.h>
 #include <fs.h>
+#include <games/modulo/modulobettracker.h>
 #include <httpserver.h>
 #include <httprpc.h>
+#include <index/bettxindex.h>
+#include <index/dataindex.h>
 #include <index/txindex.h>
 #include <key.h>
 #include <validation.h>
 #include <miner.h>
 #include <names/encoding.h>
+#include <names/main.h>
+#include <names/snapshot.h>
 #include <netbase.h>
 #include <net.h>
 #include <net_processing.h>
@@ -155,6 +160,22 @@ void Interrupt()
     if (g_txindex) {
         g_txindex->Interrupt();
     }
+    if (g_bettxindex) {
+        g_bettxindex->Interrupt();
+    }
+    if (g_dataindex) {
+        g_dataindex->Interrupt();
+    }
+    if (modulo::ver_2::g_betTracker) {
+        modulo::ver_2::g_betTracker->Interrupt();
+    }
+}
+
+/** The game transaction index is redundant with -txindex and needs unpruned blocks. */
+static bool BetTxIndexEnabled()
+{
+    return !gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX) && !gArgs.GetArg("-prune", 0) &&
+           gArgs.GetBoolArg("-bettxindex", DEFAULT_BETTXINDEX);
 }
 
 void Shutdown()
@@ -184,6 +205,9 @@ void Shutdown()
     if (peerLogic) UnregisterValidationInterface(peerLogic.get());
     if (g_connman) g_connman->Stop();
     if (g_txindex) g_txindex->Stop();
+    if (g_bettxindex) g_bettxindex->Stop();
+    if (g_dataindex) g_dataindex->Stop();
+    if (modulo::ver_2::g_betTracker) modulo::ver_2::g_betTracker->Stop();
 
     StopTorControl();
 
@@ -191,12 +215,16 @@ void Shutdown()
     // CScheduler/checkqueue threadGroup
     threadGroup.interrupt_all();
     threadGroup.join_all();
+    StopNameDBCheck();
 
     // After the threads that potentially access these pointers have been stopped,
     // destruct and reset all to nullptr.
     peerLogic.reset();
     g_connman.reset();
     g_txindex.reset();
+    g_bettxindex.reset();
+    g_dataindex.reset();
+    modulo::ver_2::g_betTracker.reset();
 
     if (g_is_mempool_loaded && gArgs.GetArg("-persistmempool", DEFAULT_PERSIST_MEMPOOL)) {
         DumpMempool();
@@ -236,6 +264,7 @@ void Shutdown()
         }
         pcoinsTip.reset();
         pcoinscatcher.reset();
+        ResetNameStateSnapshot();
         pcoinsdbview.reset();
         pblocktree.reset();
     }
@@ -352,6 +381,8 @@ void SetupServerArgs()
     gArgs.AddArg("-minimumchainwork=<hex>", strprintf("Minimum work assumed to exist on a valid chain in hex (default: %s, testnet: %s)", defaultChainParams->GetConsensus().nMinimumChainWork.GetHex(), testnetChainParams->GetConsensus().nMinimumChainWork.GetHex()), true, OptionsCategory::OPTIONS);
     gArgs.AddArg("-par=<n>", strprintf("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)",
         -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-parmakebet=<n>", strprintf("Set the number of makebet evaluation threads, apart from the script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)",
+        -GetNumCores(), MAX_MAKEBETCHECK_THREADS, DEFAULT_MAKEBETCHECK_THREADS), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-persistmempool", strprintf("Whether to save the mempool on shutdown and load on restart (default: %u)", DEFAULT_PERSIST_MEMPOOL), false, OptionsCategory::OPTIONS);
 #ifndef WIN32
     gArgs.AddArg("-pid=<file>", strprintf("Specify pid file. Relative paths will be prefixed by a net-specific datadir location. (default: %s)", BITCOIN_PID_FILENAME), false, OptionsCategory::OPTIONS);
@@ -369,7 +400,11 @@ void SetupServerArgs()
     hidden_args.emplace_back("-sysperms");
 #endif
     gArgs.AddArg("-txindex", strprintf("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)", DEFAULT_TXINDEX), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-bettxindex", strprintf("Maintain an index of game transactions, used by RPC to look up bets when -txindex is off (default: %u)", DEFAULT_BETTXINDEX), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-dataindex", strprintf("Maintain an index of data stored in OP_RETURN outputs, used by the finddata rpc call (default: %u)", DEFAULT_DATAINDEX), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-bettracker", strprintf("Track the settlement of makebets for the getbetstatus and listbets rpc calls (default: %u)", DEFAULT_BETTRACKER), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-namehistory", strprintf("Keep track of the full name history (default: %u)", 0), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-namehistorydepth=<n>", strprintf("With -namehistory, only keep the last <n> history entries of each name, 0 to keep all (default: %u)", DEFAULT_NAME_HISTORY_DEPTH), false, OptionsCategory::OPTIONS);
 
     gArgs.AddArg("-addnode=<ip>", "Add a node to connect to and attempt to keep the connection open (see the `addnode` RPC command help for more info). This option can be specified multiple times to add multiple nodes.", false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-banscore=<n>", strprintf("Threshold for disconnecting misbehaving peers (default: %u)", DEFAULT_BANSCORE_THRESHOLD), false, OptionsCategory::CONNECTION);
@@ -420,11 +455,13 @@ void SetupServerArgs()
     gArgs.AddArg("-zmqpubhashtx=<address>", "Enable publish hash transaction in <address>", false, OptionsCategory::ZMQ);
     gArgs.AddArg("-zmqpubrawblock=<address>", "Enable publish raw block in <address>", false, OptionsCategory::ZMQ);
     gArgs.AddArg("-zmqpubrawtx=<address>", "Enable publish raw transaction in <address>", false, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubbetstatus=<address>", "Enable publish makebet settlement status in <address> (requires -bettracker)", false, OptionsCategory::ZMQ);
 #else
     hidden_args.emplace_back("-zmqpubhashblock=<address>");
     hidden_args.emplace_back("-zmqpubhashtx=<address>");
     hidden_args.emplace_back("-zmqpubrawblock=<address>");
     hidden_args.emplace_back("-zmqpubrawtx=<address>");
+    hidden_args.emplace_back("-zmqpubbetstatus=<address>");
 #endif
 
     gArgs.AddArg("-checkblocks=<n>", strprintf("How many blocks to check at startup (default: %u, 0 = all)", DEFAULT_CHECKBLOCKS), true, OptionsCategory::DEBUG_TEST);
@@ -920,6 +957,12 @@ bool AppInitParameterInteraction()
     if (gArgs.GetArg("-prune", 0)) {
         if (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX))
             return InitError(_("Prune mode is incompatible with -txindex."));
+        if (gArgs.IsArgSet("-bettxindex") && gArgs.GetBoolArg("-bettxindex", DEFAULT_BETTXINDEX))
+            return InitError(_("Prune mode is incompatible with -bettxindex."));
+        if (gArgs.GetBoolArg("-dataindex", DEFAULT_DATAINDEX))
+            return InitError(_("Prune mode is incompatible with -dataindex."));
+        if (gArgs.GetBoolArg("-bettracker", DEFAULT_BETTRACKER))
+            return InitError(_("Prune mode is incompatible with -bettracker."));
     }
 
     // -bind and -whitebind can't be set when not listening
@@ -1037,6 +1080,20 @@ bool AppInitParameterInteraction()
     else if (nScriptCheckThreads > MAX_SCRIPTCHECK_THREADS)
         nScriptCheckThreads = MAX_SCRIPTCHECK_THREADS;
 
+    // same for -parmakebet, its pool runs next to the script verification threads
+    nMakeBetCheckThreads = gArgs.GetArg("-parmakebet", DEFAULT_MAKEBETCHECK_THREADS);
+    if (nMakeBetCheckThreads <= 0)
+        nMakeBetCheckThreads += GetNumCores();
+    if (nMakeBetCheckThreads <= 1)
+        nMakeBetCheckThreads = 0;
+    else if (nMakeBetCheckThreads > MAX_MAKEBETCHECK_THREADS)
+        nMakeBetCheckThreads = MAX_MAKEBETCHECK_THREADS;
+
+    const int64_t nNameHistoryDepthArg = gArgs.GetArg("-namehistorydepth", DEFAULT_NAME_HISTORY_DEPTH);
+    if (nNameHistoryDepthArg < 0 || nNameHistoryDepthArg > std::numeric_limits<uint32_t>::max())
+        return InitError(_("-namehistorydepth is out of range."));
+    nNameHistoryDepth = nNameHistoryDepthArg;
+
     // block pruning; get the amount of disk space (in MiB) to allot for block & undo files
     int64_t nPruneArg = gArgs.GetArg("-prune", 0);
     if (nPruneArg < 0) {
@@ -1263,6 +1320,12 @@ bool AppInitMain()
             threadGroup.create_thread(&ThreadScriptCheck);
     }
 
+    LogPrintf("Using %u threads for makebet evaluation\n", nMakeBetCheckThreads);
+    if (nMakeBetCheckThreads) {
+        for (int i=0; i<nMakeBetCheckThreads-1; i++)
+            threadGroup.create_thread(&ThreadMakeBetCheck);
+    }
+
     // Start the lightweight task scheduler thread
     CScheduler::Function serviceLoop = boost::bind(&CScheduler::serviceQueue, &scheduler);
     threadGroup.create_thread(boost::bind(&TraceThread<CScheduler::Function>, "scheduler", serviceLoop));
@@ -1420,6 +1483,12 @@ bool AppInitMain()
     nTotalCache -= nBlockTreeDBCache;
     int64_t nTxIndexCache = std::min(nTotalCache / 8, gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX) ? nMaxTxIndexCache << 20 : 0);
     nTotalCache -= nTxIndexCache;
+    int64_t nBetTxIndexCache = std::min(nTotalCache / 16, BetTxIndexEnabled() ? nMaxBetTxIndexCache << 20 : 0);
+    nTotalCache -= nBetTxIndexCache;
+    int64_t nDataIndexCache = std::min(nTotalCache / 16, gArgs.GetBoolArg("-dataindex", DEFAULT_DATAINDEX) ? nMaxDataIndexCache << 20 : 0);
+    nTotalCache -= nDataIndexCache;
+    int64_t nBetTrackerCache = std::min(nTotalCache / 32, gArgs.GetBoolArg("-bettracker", DEFAULT_BETTRACKER) ? nMaxBetTrackerCache << 20 : 0);
+    nTotalCache -= nBetTrackerCache;
     int64_t nCoinDBCache = std::min(nTotalCache / 2, (nTotalCache / 4) + (1 << 23)); // use 25%-50% of the remainder for disk cache
     nCoinDBCache = std::min(nCoinDBCache, nMaxCoinsDBCache << 20); // cap total coins db cache
     nTotalCache -= nCoinDBCache;
@@ -1430,6 +1499,15 @@ bool AppInitMain()
     if (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
         LogPrintf("* Using %.1fMiB for transaction index database\n", nTxIndexCache * (1.0 / 1024 / 1024));
     }
+    if (BetTxIndexEnabled()) {
+        LogPrintf("* Using %.1fMiB for game transaction index database\n", nBetTxIndexCache * (1.0 / 1024 / 1024));
+    }
+    if (gArgs.GetBoolArg("-dataindex", DEFAULT_DATAINDEX)) {
+        LogPrintf("* Using %.1fMiB for data commitment index database\n", nDataIndexCache * (1.0 / 1024 / 1024));
+    }
+    if (gArgs.GetBoolArg("-bettracker", DEFAULT_BETTRACKER)) {
+        LogPrintf("* Using %.1fMiB for bet settlement database\n", nBetTrackerCache * (1.0 / 1024 / 1024));
+    }
     LogPrintf("* Using %.1fMiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for in-memory UTXO set (plus up to %.1fMiB of unused mempool space)\n", nCoinCacheUsage * (1.0 / 1024 / 1024), nMempoolSizeMax * (1.0 / 1024 / 1024));
 
@@ -1447,6 +1525,7 @@ bool AppInitMain()
             try {
                 UnloadBlockIndex();
                 pcoinsTip.reset();
+                ResetNameStateSnapshot();
                 pcoinsdbview.reset();
                 pcoinscatcher.reset();
                 // new CBlockTreeDB tries to delete the existing file, which
@@ -1484,6 +1563,14 @@ bool AppInitMain()
                     break;
                 }
 
+                // Name history written before it was stored per entry
+                bool fNameHistoryEntries = false;
+                pblocktree->ReadFlag("namehistoryentries", fNameHistoryEntries);
+                if (fNameHistory && !fNameHistoryEntries) {
+                    strLoadError = _("You need to rebuild the database using -reindex to upgrade the name history");
+                    break;
+                }
+
                 // Check for changed -prune state.  What we are concerned about is a user who has pruned blocks
                 // in the past, but is now trying to run unpruned.
                 if (fHavePruned && !fPruneMode) {
@@ -1615,6 +1702,18 @@ bool AppInitMain()
         g_txindex = MakeUnique<TxIndex>(nTxIndexCache, false, fReindex);
         g_txindex->Start();
     }
+    if (BetTxIndexEnabled()) {
+        g_bettxindex = MakeUnique<BetTxIndex>(nBetTxIndexCache, false, fReindex);
+        g_bettxindex->Start();
+    }
+    if (gArgs.GetBoolArg("-dataindex", DEFAULT_DATAINDEX)) {
+        g_dataindex = MakeUnique<DataIndex>(nDataIndexCache, false, fReindex);
+        g_dataindex->Start();
+    }
+    if (gArgs.GetBoolArg("-bettracker", DEFAULT_BETTRACKER)) {
+        modulo::ver_2::g_betTracker = MakeUnique<modulo::ver_2::BetTracker>(nBetTrackerCache, false, fReindex);
+        modulo::ver_2::g_betTracker->Start();
+    }
 
     // ********************************************************* Step 9: load wallet
     if (!g_wallet_init_interface.Open()) return false;
@@ -31,6 +31,7 @@
 #include <utility>
 
 #include <games/modulo/moduloverify.h>
+#include <games/modulo/modulobetindex.h>
 
 // Unconfirmed transactions in the memory pool often depend on other
 // transactions in the memory pool. When we select transactions from the
@@ -97,6 +98,9 @@ void BlockAssembler::resetBlock()
     // These counters do not include coinbase tx
     nBlockTx = 0;
     nFees = 0;
+    nBlockBetSum = 0;
+    nBlockBetPotentialReward = 0;
+    nBlockNameNew = 0;
 }
 
 static std::string random_string( size_t length )
@@ -112,6 +116,65 @@ static std::string random_string( size_t length )
     return str;
 }
 
+namespace {
+/** Getbet paying the winning makebets of a tip, with its block accounting. */
+struct GetBetTemplate
+{
+    uint256 hashPrevBlock;
+    CTransactionRef tx; // nullptr when no makebet of the tip won
+    int64_t sigOpCost;
+    int64_t weight;
+    CAmount fee;
+};
+
+std::shared_ptr<const GetBetTemplate> cachedGetBet GUARDED_BY(cs_main);
+}
+
+/** The getbet only depends on the tip, so it is assembled once per tip and
+ *  shared by every template built on top of it. */
+static std::shared_ptr<const GetBetTemplate> GetBetTemplateForTip(const CBlockIndex* pindexPrev, const Consensus::Params& params) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    AssertLockHeld(cs_main);
+    if (cachedGetBet != nullptr && cachedGetBet->hashPrevBlock == pindexPrev->GetBlockHash())
+        return cachedGetBet;
+
+    const modulo::ver_2::WinningBetsRef winningBets = modulo::ver_2::g_winningBets.getWinningBets(pindexPrev, params);
+    if (winningBets == nullptr)
+        return nullptr;
+
+    std::shared_ptr<GetBetTemplate> getBet = std::make_shared<GetBetTemplate>();
+    getBet->hashPrevBlock = pindexPrev->GetBlockHash();
+    getBet->sigOpCost = 0;
+    getBet->weight = 0;
+    getBet->fee = 0;
+    if (!winningBets->empty())
+    {
+        const int nHeight = pindexPrev->nHeight + 1;
+        CMutableTransaction getBetTx;
+        getBetTx.nVersion=(GET_MODULO_NEW_GAME_INDICATOR | CTransaction::CURRENT_VERSION);
+        for(const modulo::ver_2::MakeBetData& makeBetData : *winningBets)
+        {
+            CTxIn in;
+            in.prevout.hash = makeBetData.hash;
+            in.prevout.n = 0;
+            in.scriptSig = CScript() << nHeight << static_cast<int64_t>(makeBetData.idx);
+            getBetTx.vin.push_back(in);
+            CTxOut out;
+            out.scriptPubKey = createScriptPubkey(makeBetData.keyID);
+            out.nValue = makeBetData.payoff;
+            getBetTx.vout.push_back(out);
+        }
+
+        getBet->sigOpCost = WITNESS_SCALE_FACTOR * GetLegacySigOpCount(CTransaction(getBetTx));
+        getBet->weight = GetTransactionWeight(getBetTx);
+        getBet->fee = 0;//applyFee(getBetTx, getBet->weight, getBet->sigOpCost);
+        getBet->tx = MakeTransactionRef(std::move(getBetTx));
+    }
+
+    cachedGetBet = getBet;
+    return cachedGetBet;
+}
+
 std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& scriptPubKeyIn, bool fMineWitnessTx)
 {
     int64_t nTimeStart = GetTimeMicros();
@@ -135,18 +198,6 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     CBlockIndex* pindexPrev = chainActive.Tip();
     assert(pindexPrev != nullptr);
     
-    CBlock prevBlock;
-    std::vector<CTransaction> makeBets;
-    if(ReadBlockFromDisk(prevBlock, pindexPrev, Params().GetConsensus()))
-    {
-        for (unsigned int i = 0; i < prevBlock.vtx.size(); i++) {
-            const CTransaction& tx = *(prevBlock.vtx[i]);
-            if (modulo::ver_2::isMakeBetTx(tx)) {
-                makeBets.push_back(tx);
-            }
-        }
-    }
-    
     nHeight = pindexPrev->nHeight + 1;
 
     pblock->nVersion = ComputeBlockVersion(pindexPrev, chainparams.GetConsensus());
@@ -174,46 +225,20 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     fIncludeWitness = IsWitnessEnabled(pindexPrev, chainparams.GetConsensus()) && fMineWitnessTx;
 
     CAmount getBetFee = 0;
-    if (makeBets.size() > 0) 
+    const std::shared_ptr<const GetBetTemplate> getBet = GetBetTemplateForTip(pindexPrev, chainparams.GetConsensus());
+    if (getBet != nullptr && getBet->tx != nullptr)
     {
-        CMutableTransaction getBetTx;
-        getBetTx.nVersion=(GET_MODULO_NEW_GAME_INDICATOR | CTransaction::CURRENT_VERSION);
-        bool hasWinningBets = false;
-        uint256 prevBlockHash = pindexPrev->GetBlockHash();
-        for(size_t i=0;i<makeBets.size();++i)
-        {
-            modulo::ver_2::MakeBetWinningProcess makeBetWinningProcess(makeBets[i], prevBlockHash);
-            if(makeBetWinningProcess.isMakeBetWinning())
-            {
-                CTxIn in;
-                in.prevout.hash = makeBets[i].GetHash();
-                in.prevout.n = 0;
-                in.scriptSig = CScript() << nHeight << i;
-                getBetTx.vin.push_back(in);
-                CTxOut out;
-                out.scriptPubKey = createScriptPubkey(makeBets[i]);
-                out.nValue = makeBetWinningProcess.getMakeBetPayoff();
-                getBetTx.vout.push_back(out);
-                hasWinningBets=true;
-            }
-        }
-        
-        if(hasWinningBets)
-        {
-            int64_t sigOpCost= WITNESS_SCALE_FACTOR * GetLegacySigOpCount(CTransaction(getBetTx));
-            nBlockSigOpsCost += sigOpCost;
-            pblocktemplate->vTxSigOpsCost.push_back(sigOpCost);
+        nBlockSigOpsCost += getBet->sigOpCost;
+        pblocktemplate->vTxSigOpsCost.push_back(getBet->sigOpCost);
 
-            nBlockTx++;
-            int64_t nTxWeight = GetTransactionWeight(getBetTx);
-            nBlockWeight += nTxWeight;
+        nBlockTx++;
+        nBlockWeight += getBet->weight;
 
-            getBetFee = 0;//applyFee(getBetTx, nTxWeight, sigOpCost);
-            nFees += getBetFee;
-            pblocktemplate->vTxFees.push_back(getBetFee);
+        getBetFee = getBet->fee;
+        nFees += getBetFee;
+        pblocktemplate->vTxFees.push_back(getBetFee);
 
-           pblock->vtx.emplace_back(MakeTransactionRef(std::move(getBetTx)));
-        }
+        pblock->vtx.push_back(getBet->tx);
     }
 
     int nPackagesSelected = 0;
@@ -253,7 +278,6 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     int64_t nTime2 = GetTimeMicros();
 
     LogPrint(BCLog::BENCH, "CreateNewBlock() packages: %.2fms (%d packages, %d updated descendants), validity: %.2fms (total %.2fms)\n", 0.001 * (nTime1 - nTimeStart), nPackagesSelected, nDescendantsUpdated, 0.001 * (nTime2 - nTime1), 0.001 * (nTime2 - nTimeStart));
-    makeBets.clear();
     return std::move(pblocktemplate);
 }
 
@@ -400,6 +424,10 @@ void BlockAssembler::AddToBlock(CTxMemPool::txiter iter)
     ++nBlockTx;
     nBlockSigOpsCost += iter->GetSigOpCost();
     nFees += iter->GetFee();
+    nBlockBetSum += iter->GetBetSum();
+    nBlockBetPotentialReward += iter->GetBetPotentialReward();
+    if (isNameNew(iter->GetTx()))
+        ++nBlockNameNew;
     inBlock.insert(iter);
 
     bool fPrintPriority = gArgs.GetBoolArg("-printpriority", DEFAULT_PRINTPRIORITY);
@@ -496,18 +524,6 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpda
 
     while (mi != mempool.mapTx.get<ancestor_score>().end() || !mapModifiedTx.empty())
     {
-        unsigned int nameTxnCounter = 0;
-        // get balance of transactions already added to block
-        CAmount sumOfBlockBets{}, potentialWinSum{};
-        for (size_t i=0; i<pblock->vtx.size(); ++i)
-        {
-            if(pblock->vtx[i]) {
-                const CTransaction& txn = *(pblock->vtx[i]);
-                if (isNameNew(txn)) ++nameTxnCounter;
-                modulo::ver_2::checkBetsPotentialReward(potentialWinSum, sumOfBlockBets, txn);
-            }
-        }
-
         // First try to find a new transaction in mapTx to evaluate.
         if (mi != mempool.mapTx.get<ancestor_score>().end() &&
                 SkipMapTxEntry(mempool.mapTx.project<0>(mi), mapModifiedTx, failedTx)) {
@@ -586,23 +602,21 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpda
         onlyUnconfirmed(ancestors);
         ancestors.insert(iter);
 
-        bool txnLimitExceeded = false;
-        unsigned int localNameTxnCounter = 0;
+        // The bets of the package, cached by the mempool, have to fit into
+        // what is left of the limits of the block, as does a name_new
+        CAmount packageBetSum = 0, packageBetPotentialReward = 0;
+        unsigned int packageNameNew = 0;
         for (auto it : ancestors)
         {
-            const CTransaction& txn = it->GetTx();
-            if (isNameNew(txn)) ++localNameTxnCounter;
-            if (!modulo::ver_2::checkBetsPotentialReward(potentialWinSum, sumOfBlockBets, txn))
-            {
-                txnLimitExceeded = true;
-                break;
-            }
+            packageBetSum += it->GetBetSum();
+            packageBetPotentialReward += it->GetBetPotentialReward();
+            if (isNameNew(it->GetTx())) ++packageNameNew;
         }
 
-        if (!txnLimitExceeded && (localNameTxnCounter + nameTxnCounter) > 1)
-        {
-            txnLimitExceeded = true;
-        }
+        const bool txnLimitExceeded = (nBlockNameNew + packageNameNew) > 1 ||
+            !modulo::ver_2::isBetsPotentialRewardWithinLimit(nBlockBetPotentialReward + packageBetPotentialReward,
+                                                             nBlockBetSum + packageBetSum,
+                                                             chainActive.Height(), chainparams.GetConsensus());
 
         // Test if all tx's are Final
         if (txnLimitExceeded || !TestPackageTransactions(ancestors) || !DbLockLimitOk(ancestors)) {
@@ -139,6 +139,9 @@ private:
     uint64_t nBlockTx;
     uint64_t nBlockSigOpsCost;
     CAmount nFees;
+    CAmount nBlockBetSum;
+    CAmount nBlockBetPotentialReward;
+    unsigned int nBlockNameNew;
     CTxMemPool::setEntries inBlock;
 
     // Chain context for the block
@@ -4,9 +4,15 @@
 
 #include <names/common.h>
 
+#include <hash.h>
+#include <memusage.h>
+#include <random.h>
 #include <script/names.h>
 
+#include <algorithm>
+
 bool fNameHistory = false;
+unsigned nNameHistoryDepth = DEFAULT_NAME_HISTORY_DEPTH;
 
 /* ************************************************************************** */
 /* CNameData.  */
@@ -22,6 +28,26 @@ CNameData::fromScript (unsigned h, const COutPoint& out,
   addr = script.getAddress ();
 }
 
+size_t
+CNameData::DynamicMemoryUsage () const
+{
+  return memusage::DynamicUsage (value)
+          + memusage::DynamicUsage (static_cast<const CScriptBase&> (addr));
+}
+
+/* ************************************************************************** */
+/* CNameHistory.  */
+
+size_t
+CNameHistory::DynamicMemoryUsage () const
+{
+  size_t res = memusage::DynamicUsage (data);
+  for (const auto& entry : data)
+    res += entry.DynamicMemoryUsage ();
+
+  return res;
+}
+
 /* ************************************************************************** */
 /* CNameIterator.  */
 
@@ -31,6 +57,78 @@ CNameIterator::~CNameIterator ()
      subclasses if they need a destructor.  */
 }
 
+/* ************************************************************************** */
+/* CNamePrefixIterator.  */
+
+CNamePrefixIterator::CNamePrefixIterator (CNameIterator* b, const valtype& p)
+  : base(b), prefix(p), length(0)
+{
+  seek (valtype ());
+}
+
+CNamePrefixIterator::~CNamePrefixIterator ()
+{
+  delete base;
+}
+
+void
+CNamePrefixIterator::seekLength (size_t len)
+{
+  assert (len >= prefix.size ());
+  length = len;
+
+  valtype start = prefix;
+  start.resize (len, 0);
+  base->seek (start);
+}
+
+bool
+CNamePrefixIterator::hasPrefix (const valtype& name) const
+{
+  return name.size () >= prefix.size ()
+          && std::equal (prefix.begin (), prefix.end (), name.begin ());
+}
+
+void
+CNamePrefixIterator::seek (const valtype& start)
+{
+  if (start.size () < prefix.size ())
+    {
+      seekLength (prefix.size ());
+      return;
+    }
+
+  const valtype head(start.begin (), start.begin () + prefix.size ());
+  if (head < prefix)
+    seekLength (start.size ());
+  else if (head == prefix)
+    {
+      length = start.size ();
+      base->seek (start);
+    }
+  else
+    seekLength (start.size () + 1);
+}
+
+bool
+CNamePrefixIterator::next (valtype& name, CNameData& data)
+{
+  while (true)
+    {
+      /* If there is no name at all after the current position, there
+         are also none of larger length.  */
+      if (!base->next (name, data))
+        return false;
+
+      if (name.size () == length && hasPrefix (name))
+        return true;
+
+      /* We left the range for the current length.  If the name is longer,
+         there are no names at all with lengths in between.  */
+      seekLength (name.size () > length ? name.size () : length + 1);
+    }
+}
+
 /* ************************************************************************** */
 /* CNameCacheNameIterator.  */
 
@@ -166,6 +264,17 @@ CCacheNameIterator::next (valtype& name, CNameData& data)
 /* ************************************************************************** */
 /* CNameCache.  */
 
+CNameCache::NameHasher::NameHasher ()
+  : k0(GetRand (std::numeric_limits<uint64_t>::max ())),
+    k1(GetRand (std::numeric_limits<uint64_t>::max ()))
+{}
+
+size_t
+CNameCache::NameHasher::operator() (const valtype& name) const
+{
+  return CSipHasher (k0, k1).Write (name.data (), name.size ()).Finalize ();
+}
+
 bool
 CNameCache::get (const valtype& name, CNameData& data) const
 {
@@ -180,15 +289,25 @@ CNameCache::get (const valtype& name, CNameData& data) const
 void
 CNameCache::set (const valtype& name, const CNameData& data)
 {
-  const std::set<valtype>::iterator di = deleted.find (name);
+  const auto di = deleted.find (name);
   if (di != deleted.end ())
-    deleted.erase (di);
+    {
+      innerUsage -= memusage::DynamicUsage (*di);
+      deleted.erase (di);
+    }
 
-  const EntryMap::iterator ei = entries.find (name);
+  EntryMap::iterator ei = entries.find (name);
   if (ei != entries.end ())
-    ei->second = data;
+    {
+      innerUsage -= ei->second.DynamicMemoryUsage ();
+      ei->second = data;
+    }
   else
-    entries.insert (std::make_pair (name, data));
+    {
+      ei = entries.insert (std::make_pair (name, data)).first;
+      innerUsage += memusage::DynamicUsage (ei->first);
+    }
+  innerUsage += ei->second.DynamicMemoryUsage ();
 }
 
 void
@@ -196,9 +315,15 @@ CNameCache::remove (const valtype& name)
 {
   const EntryMap::iterator ei = entries.find (name);
   if (ei != entries.end ())
-    entries.erase (ei);
+    {
+      innerUsage -= memusage::DynamicUsage (ei->first)
+                      + ei->second.DynamicMemoryUsage ();
+      entries.erase (ei);
+    }
 
-  deleted.insert (name);
+  const auto ins = deleted.insert (name);
+  if (ins.second)
+    innerUsage += memusage::DynamicUsage (*ins.first);
 }
 
 CNameIterator*
@@ -208,12 +333,12 @@ CNameCache::iterateNames (CNameIterator* base) const
 }
 
 bool
-CNameCache::getHistory (const valtype& name, CNameHistory& res) const
+CNameCache::getHistoryInfo (const valtype& name, CNameHistoryInfo& res) const
 {
   assert (fNameHistory);
 
-  const std::map<valtype, CNameHistory>::const_iterator i = history.find (name);
-  if (i == history.end ())
+  const auto i = historyInfo.find (name);
+  if (i == historyInfo.end ())
     return false;
 
   res = i->second;
@@ -221,15 +346,95 @@ CNameCache::getHistory (const valtype& name, CNameHistory& res) const
 }
 
 void
-CNameCache::setHistory (const valtype& name, const CNameHistory& data)
+CNameCache::setHistoryInfo (const valtype& name, const CNameHistoryInfo& info)
+{
+  assert (fNameHistory);
+
+  const auto ins = historyInfo.insert (std::make_pair (name, info));
+  if (ins.second)
+    innerUsage += memusage::DynamicUsage (ins.first->first);
+  else
+    ins.first->second = info;
+}
+
+bool
+CNameCache::getHistoryEntry (const valtype& name, uint32_t idx,
+                             CNameData& data) const
+{
+  const auto i = historyEntries.find (HistoryKey (name, idx));
+  if (i == historyEntries.end ())
+    return false;
+
+  data = i->second;
+  return true;
+}
+
+bool
+CNameCache::isHistoryEntryErased (const valtype& name, uint32_t idx) const
+{
+  return historyErased.count (HistoryKey (name, idx)) > 0;
+}
+
+void
+CNameCache::writeHistoryEntry (const valtype& name, uint32_t idx,
+                               const CNameData& data)
 {
   assert (fNameHistory);
+  const HistoryKey key(name, idx);
+
+  const auto ei = historyErased.find (key);
+  if (ei != historyErased.end ())
+    {
+      innerUsage -= memusage::DynamicUsage (ei->first);
+      historyErased.erase (ei);
+    }
 
-  const std::map<valtype, CNameHistory>::iterator ei = history.find (name);
-  if (ei != history.end ())
-    ei->second = data;
+  auto i = historyEntries.find (key);
+  if (i != historyEntries.end ())
+    {
+      innerUsage -= i->second.DynamicMemoryUsage ();
+      i->second = data;
+    }
   else
-    history.insert (std::make_pair (name, data));
+    {
+      i = historyEntries.insert (std::make_pair (key, data)).first;
+      innerUsage += memusage::DynamicUsage (i->first.first);
+    }
+  innerUsage += i->second.DynamicMemoryUsage ();
+}
+
+void
+CNameCache::eraseHistoryEntry (const valtype& name, uint32_t idx)
+{
+  assert (fNameHistory);
+  const HistoryKey key(name, idx);
+
+  const auto i = historyEntries.find (key);
+  if (i != historyEntries.end ())
+    {
+      innerUsage -= memusage::DynamicUsage (i->first.first)
+                      + i->second.DynamicMemoryUsage ();
+      historyEntries.erase (i);
+    }
+
+  const auto ins = historyErased.insert (key);
+  if (ins.second)
+    innerUsage += memusage::DynamicUsage (ins.first->first);
+}
+
+void
+CNameCache::updateHistory (const valtype& name,
+                           std::map<uint32_t, CNameData>& entries) const
+{
+  const HistoryKey seekKey(name, 0);
+
+  for (auto i = historyEntries.lower_bound (seekKey);
+       i != historyEntries.end () && i->first.first == name; ++i)
+    entries[i->first.second] = i->second;
+
+  for (auto i = historyErased.lower_bound (seekKey);
+       i != historyErased.end () && i->first == name; ++i)
+    entries.erase (i->second);
 }
 
 void
@@ -256,18 +461,47 @@ CNameCache::updateNamesForHeight (unsigned nHeight,
     }
 }
 
+void
+CNameCache::updateNamesForHeights (unsigned nFromHeight, unsigned nToHeight,
+                                   std::set<ExpireEntry>& entries) const
+{
+  const ExpireEntry seekEntry(nFromHeight, valtype ());
+  std::map<ExpireEntry, bool>::const_iterator it;
+
+  for (it = expireIndex.lower_bound (seekEntry); it != expireIndex.end (); ++it)
+    {
+      const ExpireEntry& cur = it->first;
+      assert (cur.nHeight >= nFromHeight);
+      if (cur.nHeight > nToHeight)
+        break;
+
+      if (it->second)
+        entries.insert (cur);
+      else
+        entries.erase (cur);
+    }
+}
+
+void
+CNameCache::setExpireIndex (const ExpireEntry& entry, bool add)
+{
+  const auto ins = expireIndex.insert (std::make_pair (entry, add));
+  if (ins.second)
+    innerUsage += memusage::DynamicUsage (ins.first->first.name);
+  else
+    ins.first->second = add;
+}
+
 void
 CNameCache::addExpireIndex (const valtype& name, unsigned height)
 {
-  const ExpireEntry entry(height, name);
-  expireIndex[entry] = true;
+  setExpireIndex (ExpireEntry (height, name), true);
 }
 
 void
 CNameCache::removeExpireIndex (const valtype& name, unsigned height)
 {
-  const ExpireEntry entry(height, name);
-  expireIndex[entry] = false;
+  setExpireIndex (ExpireEntry (height, name), false);
 }
 
 void
@@ -277,15 +511,27 @@ CNameCache::apply (const CNameCache& cache)
        i != cache.entries.end (); ++i)
     set (i->first, i->second);
 
-  for (std::set<valtype>::const_iterator i = cache.deleted.begin ();
-       i != cache.deleted.end (); ++i)
-    remove (*i);
+  for (const auto& name : cache.deleted)
+    remove (name);
 
-  for (std::map<valtype, CNameHistory>::const_iterator i
-        = cache.history.begin (); i != cache.history.end (); ++i)
-    setHistory (i->first, i->second);
+  for (const auto& entry : cache.historyInfo)
+    setHistoryInfo (entry.first, entry.second);
+  for (const auto& entry : cache.historyEntries)
+    writeHistoryEntry (entry.first.first, entry.first.second, entry.second);
+  for (const auto& key : cache.historyErased)
+    eraseHistoryEntry (key.first, key.second);
 
   for (std::map<ExpireEntry, bool>::const_iterator i
         = cache.expireIndex.begin (); i != cache.expireIndex.end (); ++i)
-    expireIndex[i->first] = i->second;
+    setExpireIndex (i->first, i->second);
+}
+
+size_t
+CNameCache::DynamicMemoryUsage () const
+{
+  return memusage::DynamicUsage (entries) + memusage::DynamicUsage (deleted)
+          + memusage::DynamicUsage (historyInfo)
+          + memusage::DynamicUsage (historyEntries)
+          + memusage::DynamicUsage (historyErased)
+          + memusage::DynamicUsage (expireIndex) + innerUsage;
 }
@@ -12,6 +12,8 @@
 
 #include <map>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
 
 class CNameScript;
 class CDBBatch;
@@ -19,6 +21,11 @@ class CDBBatch;
 /** Whether or not name history is enabled.  */
 extern bool fNameHistory;
 
+/** Default for -namehistorydepth, 0 keeps the full history.  */
+static const unsigned DEFAULT_NAME_HISTORY_DEPTH = 0;
+/** Number of history entries kept per name, 0 for all of them.  */
+extern unsigned nNameHistoryDepth;
+
 /* ************************************************************************** */
 /* CNameData.  */
 
@@ -132,6 +139,9 @@ public:
    */
   void fromScript (unsigned h, const COutPoint& out, const CNameScript& script);
 
+  /* Heap memory used by the value and address.  */
+  size_t DynamicMemoryUsage () const;
+
 };
 
 /* ************************************************************************** */
@@ -139,39 +149,53 @@ public:
 
 /**
  * Keep track of a name's history.  This is a stack of old CNameData
- * objects that have been obsoleted.
+ * objects that have been obsoleted.  The entries are stored in the database
+ * one per (name, index) row, so that pushing an entry does not rewrite the
+ * others; this class holds a (possibly pruned) stack read back from it.
  */
 class CNameHistory
 {
 
 private:
 
-  /** The actual data.  */
+  /** Index the next pushed entry gets, i. e. the full stack size.  */
+  uint32_t nEnd;
+
+  /** The entries still stored, oldest first and ending at nEnd.  */
   std::vector<CNameData> data;
 
 public:
 
-  ADD_SERIALIZE_METHODS;
+  inline CNameHistory ()
+    : nEnd(0), data()
+  {}
 
-  template<typename Stream, typename Operation>
-    inline void SerializationOp (Stream& s, Operation ser_action)
+  inline CNameHistory (uint32_t end, std::vector<CNameData>&& d)
+    : nEnd(end), data(std::move (d))
   {
-    READWRITE (data);
+    assert (data.size () <= nEnd);
   }
 
   /**
-   * Check if the stack is empty.  This is used to decide when to fully
-   * delete an entry in the database.
+   * Check if the stack is empty.
    * @return True iff the data stack is empty.
    */
   inline bool
   empty () const
   {
-    return data.empty ();
+    return nEnd == 0;
+  }
+
+  /* Size of the full stack, including pruned entries.  */
+  inline uint32_t
+  getEnd () const
+  {
+    return nEnd;
   }
 
   /**
-   * Access the data in a read-only way.
+   * Access the data in a read-only way.  If the history is pruned, these
+   * are only the most recent entries.
    * @return The data stack.
    */
   inline const std::vector<CNameData>&
@@ -180,29 +204,53 @@ public:
     return data;
   }
 
-  /**
-   * Push a new entry onto the data stack.  The new entry's height should
-   * be at least as high as the stack top entry's.  If not, fail.
-   * @param entry The new entry to push onto the stack.
-   */
-  inline void
-  push (const CNameData& entry)
+  /* Heap memory used by the stack and its entries.  */
+  size_t DynamicMemoryUsage () const;
+
+};
+
+/**
+ * Database row per name with history, describing which of its history
+ * entries exist.  Entries are indexed from zero in the order they were
+ * pushed; the entries in [nEnd - nStored, nEnd) are stored while older ones
+ * have been pruned according to -namehistorydepth.
+ */
+class CNameHistoryInfo
+{
+
+public:
+
+  /** Index the next pushed entry gets.  */
+  uint32_t nEnd;
+
+  /** Number of entries before nEnd that are still stored.  */
+  uint32_t nStored;
+
+  inline CNameHistoryInfo ()
+    : nEnd(0), nStored(0)
+  {}
+
+  ADD_SERIALIZE_METHODS;
+
+  template<typename Stream, typename Operation>
+    inline void SerializationOp (Stream& s, Operation ser_action)
   {
-    assert (data.empty () || data.back ().getHeight () <= entry.getHeight ());
-    data.push_back (entry);
+    READWRITE (nEnd);
+    READWRITE (nStored);
   }
 
-  /**
-   * Pop the top entry off the stack.  This is used when undoing name
-   * changes.  The name's new value is passed as argument and should
-   * match the removed entry.  If not, fail.
-   * @param entry The name's value after undoing.
-   */
-  inline void
-  pop (const CNameData& entry)
+  /* If this is empty, the database row is deleted.  */
+  inline bool
+  empty () const
+  {
+    return nEnd == 0;
+  }
+
+  /* Index of the oldest entry still stored.  */
+  inline uint32_t
+  first () const
   {
-    assert (!data.empty () && data.back () == entry);
-    data.pop_back ();
+    return nEnd - nStored;
   }
 
 };
@@ -237,6 +285,52 @@ public:
 
 };
 
+/**
+ * Name iterator that only yields names starting with a given prefix.
+ * Since the database is ordered by name length first, the names with
+ * a prefix are not a single range of it.  They are one range for each
+ * possible name length, though, so that the iterator can seek through
+ * those ranges instead of filtering all names.
+ */
+class CNamePrefixIterator : public CNameIterator
+{
+
+private:
+
+  /** The iterator over all names, owned by this object.  */
+  CNameIterator* base;
+
+  /** The prefix of all returned names.  */
+  valtype prefix;
+
+  /** Length of the names in the range currently iterated.  */
+  size_t length;
+
+  /* Seek the base iterator to the first name of length len with
+     our prefix.  */
+  void seekLength (size_t len);
+
+  /* Check if a name has our prefix.  */
+  bool hasPrefix (const valtype& name) const;
+
+public:
+
+  /**
+   * Construct the iterator.  This takes ownership of the base iterator.
+   * @param b The base iterator.
+   * @param p The prefix to iterate.
+   */
+  CNamePrefixIterator (CNameIterator* b, const valtype& p);
+
+  /* Destruct, this deletes also the base iterator.  */
+  ~CNamePrefixIterator ();
+
+  /* Implement iterator methods.  */
+  void seek (const valtype& name);
+  bool next (valtype& name, CNameData& data);
+
+};
+
 /* ************************************************************************** */
 /* CNameCache.  */
 
@@ -248,12 +342,13 @@ public:
 class CNameCache
 {
 
-private:
+public:
 
   /**
    * Special comparator class for names that compares by length first.
    * This is used to sort the cache entry map in the same way as the
-   * database is sorted.
+   * database is sorted.  It is public since name iterators yield names
+   * in this order, too.
    */
   class NameComparator
   {
@@ -268,7 +363,18 @@ private:
     }
   };
 
-public:
+  /**
+   * Salted hasher for names, used for the containers of the cache that
+   * need no ordering.
+   */
+  class NameHasher
+  {
+  private:
+    uint64_t k0, k1;
+  public:
+    NameHasher ();
+    size_t operator() (const valtype& name) const;
+  };
 
   /**
    * Type for expire-index entries.  We have to make sure that
@@ -349,16 +455,28 @@ public:
 
 private:
 
-  /** New or updated names.  */
+  /**
+   * New or updated names.  This and the expire index are iterated in
+   * database order by name iterators and expire-index queries, so they
+   * stay ordered; the other containers are only looked up and hashed.
+   */
   EntryMap entries;
   /** Deleted names.  */
-  std::set<valtype> deleted;
+  std::unordered_set<valtype, NameHasher> deleted;
 
   /**
-   * New or updated history stacks.  If they are empty, the corresponding
+   * New or updated history info rows.  If they are empty, the corresponding
    * database entry is deleted instead.
    */
-  std::map<valtype, CNameHistory> history;
+  std::unordered_map<valtype, CNameHistoryInfo, NameHasher> historyInfo;
+
+  /**
+   * Written and erased history entries, keyed by name and index.  These
+   * are ordered so that all changes of a name can be found together.
+   */
+  typedef std::pair<valtype, uint32_t> HistoryKey;
+  std::map<HistoryKey, CNameData> historyEntries;
+  std::set<HistoryKey> historyErased;
 
   /**
    * Changes to be performed to the expire index.  The entry is mapped
@@ -366,6 +484,16 @@ private:
    */
   std::map<ExpireEntry, bool> expireIndex;
 
+  /**
+   * Heap memory used by the keys and values in the containers above,
+   * kept up-to-date by the modifying methods.  The memory of the container
+   * nodes themselves follows from their sizes.
+   */
+  size_t innerUsage = 0;
+
+  /* Set an expire-index change and account for its memory.  */
+  void setExpireIndex (const ExpireEntry& entry, bool add);
+
   friend class CCacheNameIterator;
 
 public:
@@ -375,8 +503,11 @@ public:
   {
     entries.clear ();
     deleted.clear ();
-    history.clear ();
+    historyInfo.clear ();
+    historyEntries.clear ();
+    historyErased.clear ();
     expireIndex.clear ();
+    innerUsage = 0;
   }
 
   /**
@@ -390,7 +521,8 @@ public:
   {
     if (entries.empty () && deleted.empty ())
       {
-        assert (history.empty () && expireIndex.empty ());
+        assert (historyInfo.empty () && historyEntries.empty ()
+                  && historyErased.empty () && expireIndex.empty ());
         return true;
       }
 
@@ -421,19 +553,36 @@ public:
   CNameIterator* iterateNames (CNameIterator* base) const;
 
   /**
-   * Query for an history entry.
+   * Query for the history info of a name.
    * @param name The name to look up.
-   * @param res Put the resulting history entry here.
+   * @param res Put the resulting info here.
    * @return True iff the name was found in the cache.
    */
-  bool getHistory (const valtype& name, CNameHistory& res) const;
+  bool getHistoryInfo (const valtype& name, CNameHistoryInfo& res) const;
 
   /**
-   * Set a name history entry.
+   * Set the history info of a name.
    * @param name The name to modify.
-   * @param data The new history entry.
+   * @param info The new info.
    */
-  void setHistory (const valtype& name, const CNameHistory& data);
+  void setHistoryInfo (const valtype& name, const CNameHistoryInfo& info);
+
+  /* Try to get a history entry written in the cache.  */
+  bool getHistoryEntry (const valtype& name, uint32_t idx,
+                        CNameData& data) const;
+
+  /* See if a history entry is marked as erased.  */
+  bool isHistoryEntryErased (const valtype& name, uint32_t idx) const;
+
+  /* Write or erase a history entry.  */
+  void writeHistoryEntry (const valtype& name, uint32_t idx,
+                          const CNameData& data);
+  void eraseHistoryEntry (const valtype& name, uint32_t idx);
+
+  /* Apply the cached changes to the history entries of a name, which are
+     given by their index.  */
+  void updateHistory (const valtype& name,
+                      std::map<uint32_t, CNameData>& entries) const;
 
   /* Query the cached changes to the expire index.  In particular,
      for a given height and a given set of names that were indexed to
@@ -441,6 +590,12 @@ public:
      are represented by the cached expire index changes.  */
   void updateNamesForHeight (unsigned nHeight, std::set<valtype>& names) const;
 
+  /* Same as updateNamesForHeight, but for all heights in the range
+     [nFromHeight, nToHeight].  The entries are kept together with their
+     heights, since a name may move between heights within the range.  */
+  void updateNamesForHeights (unsigned nFromHeight, unsigned nToHeight,
+                              std::set<ExpireEntry>& entries) const;
+
   /* Add an expire-index entry.  */
   void addExpireIndex (const valtype& name, unsigned height);
 
@@ -453,6 +608,9 @@ public:
   /* Write all cached changes to a database batch update object.  */
   void writeBatch (CDBBatch& batch) const;
 
+  /* Memory used by the cached changes.  */
+  size_t DynamicMemoryUsage () const;
+
 };
 
 #endif // H_BITCOIN_NAMES_COMMON
@@ -10,14 +10,20 @@
 #include <dbwrapper.h>
 #include <hash.h>
 #include <names/encoding.h>
+#include <primitives/block.h>
 #include <script/interpreter.h>
 #include <script/names.h>
+#include <txdb.h>
 #include <txmempool.h>
 #include <undo.h>
 #include <util.h>
 #include <utilstrencodings.h>
 #include <validation.h>
 
+#include <boost/thread.hpp>
+
+#include <algorithm>
+
 /**
  * Check whether a name at nPrevHeight is expired at nHeight.  Also
  * heights of MEMPOOL_HEIGHT are supported.  For nHeight == MEMPOOL_HEIGHT,
@@ -77,20 +83,20 @@ CNameTxUndo::apply (CCoinsViewCache& view) const
 uint256
 CNameMemPool::getTxForName (const valtype& name) const
 {
-  NameTxMap::const_iterator mi;
+  NameEntryMap::const_iterator mi;
 
   mi = mapNameRegs.find (name);
   if (mi != mapNameRegs.end ())
     {
       assert (mapNameUpdates.count (name) == 0);
-      return mi->second;
+      return mi->second->GetTx ().GetHash ();
     }
 
   mi = mapNameUpdates.find (name);
   if (mi != mapNameUpdates.end ())
     {
       assert (mapNameRegs.count (name) == 0);
-      return mi->second;
+      return mi->second->GetTx ().GetHash ();
     }
 
   return uint256 ();
@@ -116,14 +122,14 @@ CNameMemPool::addUnchecked (const CTxMemPoolEntry& entry)
     {
       const valtype& name = entry.getName ();
       assert (mapNameRegs.count (name) == 0);
-      mapNameRegs.insert (std::make_pair (name, txHash));
+      mapNameRegs.insert (std::make_pair (name, &entry));
     }
 
   if (entry.isNameUpdate ())
     {
       const valtype& name = entry.getName ();
       assert (mapNameUpdates.count (name) == 0);
-      mapNameUpdates.insert (std::make_pair (name, txHash));
+      mapNameUpdates.insert (std::make_pair (name, &entry));
     }
 }
 
@@ -134,20 +140,23 @@ CNameMemPool::remove (const CTxMemPoolEntry& entry)
 
   if (entry.isNameRegistration ())
     {
-      const NameTxMap::iterator mit = mapNameRegs.find (entry.getName ());
-      assert (mit != mapNameRegs.end ());
+      const NameEntryMap::iterator mit = mapNameRegs.find (entry.getName ());
+      assert (mit != mapNameRegs.end () && mit->second == &entry);
       mapNameRegs.erase (mit);
     }
   if (entry.isNameUpdate ())
     {
-      const NameTxMap::iterator mit = mapNameUpdates.find (entry.getName ());
-      assert (mit != mapNameUpdates.end ());
+      const NameEntryMap::iterator mit
+          = mapNameUpdates.find (entry.getName ());
+      assert (mit != mapNameUpdates.end () && mit->second == &entry);
       mapNameUpdates.erase (mit);
     }
 }
 
 void
-CNameMemPool::removeConflicts (const CTransaction& tx)
+CNameMemPool::getConflicts (const CTransaction& tx,
+                            std::vector<const CTxMemPoolEntry*>& conflicts)
+  const
 {
   AssertLockHeld (pool.cs);
 
@@ -159,61 +168,74 @@ CNameMemPool::removeConflicts (const CTransaction& tx)
       const CNameScript nameOp(txout.scriptPubKey);
       if (nameOp.isNameOp () && nameOp.getNameOp () == OP_NAME_FIRSTUPDATE)
         {
-          const valtype& name = nameOp.getOpName ();
-          const NameTxMap::const_iterator mit = mapNameRegs.find (name);
+          const NameEntryMap::const_iterator mit
+              = mapNameRegs.find (nameOp.getOpName ());
           if (mit != mapNameRegs.end ())
-            {
-              const CTxMemPool::txiter mit2 = pool.mapTx.find (mit->second);
-              assert (mit2 != pool.mapTx.end ());
-              pool.removeRecursive (mit2->GetTx (),
-                                    MemPoolRemovalReason::NAME_CONFLICT);
-            }
+            conflicts.push_back (mit->second);
         }
     }
 }
 
 void
-CNameMemPool::removeUnexpireConflicts (const std::set<valtype>& unexpired)
+CNameMemPool::getUnexpireConflicts (
+    const std::set<valtype>& unexpired,
+    std::vector<const CTxMemPoolEntry*>& conflicts) const
 {
   AssertLockHeld (pool.cs);
 
   for (const auto& name : unexpired)
     {
+      const NameEntryMap::const_iterator mit = mapNameRegs.find (name);
       LogPrint (BCLog::NAMES, "unexpired: %s, mempool: %u\n",
-                EncodeNameForMessage (name), mapNameRegs.count (name));
+                EncodeNameForMessage (name), mit != mapNameRegs.end ());
 
-      const NameTxMap::const_iterator mit = mapNameRegs.find (name);
       if (mit != mapNameRegs.end ())
-        {
-          const CTxMemPool::txiter mit2 = pool.mapTx.find (mit->second);
-          assert (mit2 != pool.mapTx.end ());
-          pool.removeRecursive (mit2->GetTx (),
-                                MemPoolRemovalReason::NAME_CONFLICT);
-        }
+        conflicts.push_back (mit->second);
     }
 }
 
 void
-CNameMemPool::removeExpireConflicts (const std::set<valtype>& expired)
+CNameMemPool::getExpireConflicts (
+    const std::set<valtype>& expired,
+    std::vector<const CTxMemPoolEntry*>& conflicts) const
 {
   AssertLockHeld (pool.cs);
 
   for (const auto& name : expired)
     {
+      const NameEntryMap::const_iterator mit = mapNameUpdates.find (name);
       LogPrint (BCLog::NAMES, "expired: %s, mempool: %u\n",
-                EncodeNameForMessage (name), mapNameUpdates.count (name));
+                EncodeNameForMessage (name), mit != mapNameUpdates.end ());
 
-      const NameTxMap::const_iterator mit = mapNameUpdates.find (name);
       if (mit != mapNameUpdates.end ())
-        {
-          const CTxMemPool::txiter mit2 = pool.mapTx.find (mit->second);
-          assert (mit2 != pool.mapTx.end ());
-          pool.removeRecursive (mit2->GetTx (),
-                                MemPoolRemovalReason::NAME_CONFLICT);
-        }
+        conflicts.push_back (mit->second);
     }
 }
 
+void
+CNameMemPool::removeConflicts (const CTransaction& tx)
+{
+  std::vector<const CTxMemPoolEntry*> conflicts;
+  getConflicts (tx, conflicts);
+  pool.removeNameConflicts (conflicts);
+}
+
+void
+CNameMemPool::removeUnexpireConflicts (const std::set<valtype>& unexpired)
+{
+  std::vector<const CTxMemPoolEntry*> conflicts;
+  getUnexpireConflicts (unexpired, conflicts);
+  pool.removeNameConflicts (conflicts);
+}
+
+void
+CNameMemPool::removeExpireConflicts (const std::set<valtype>& expired)
+{
+  std::vector<const CTxMemPoolEntry*> conflicts;
+  getExpireConflicts (expired, conflicts);
+  pool.removeNameConflicts (conflicts);
+}
+
 void
 CNameMemPool::check (const CCoinsView& coins) const
 {
@@ -244,9 +266,9 @@ CNameMemPool::check (const CCoinsView& coins) const
         {
           const valtype& name = entry.getName ();
 
-          const NameTxMap::const_iterator mit = mapNameRegs.find (name);
+          const NameEntryMap::const_iterator mit = mapNameRegs.find (name);
           assert (mit != mapNameRegs.end ());
-          assert (mit->second == txHash);
+          assert (mit->second == &entry);
 
           assert (nameRegs.count (name) == 0);
           nameRegs.insert (name);
@@ -263,9 +285,9 @@ CNameMemPool::check (const CCoinsView& coins) const
         {
           const valtype& name = entry.getName ();
 
-          const NameTxMap::const_iterator mit = mapNameUpdates.find (name);
+          const NameEntryMap::const_iterator mit = mapNameUpdates.find (name);
           assert (mit != mapNameUpdates.end ());
-          assert (mit->second == txHash);
+          assert (mit->second == &entry);
 
           assert (nameUpdates.count (name) == 0);
           nameUpdates.insert (name);
@@ -314,8 +336,7 @@ CNameMemPool::checkTx (const CTransaction& tx) const
         case OP_NAME_NEW:
           {
             const valtype& newHash = nameOp.getOpHash ();
-            std::map<valtype, uint256>::const_iterator mi;
-            mi = mapNameNews.find (newHash);
+            const NameTxMap::const_iterator mi = mapNameNews.find (newHash);
             if (mi != mapNameNews.end () && mi->second != tx.GetHash ())
               return false;
             break;
@@ -636,30 +657,56 @@ ExpireNames (unsigned nHeight, CCoinsViewCache& view, CBlockUndo& undo,
      flat -- which is fine.  */
   assert (expireFrom <= expireTo + 1);
 
-  /* Find all names that expire at those depths.  Note that GetNamesForHeight
-     clears the output set, to we union all sets here.  */
-  for (unsigned h = expireFrom; h <= expireTo; ++h)
+  /* Find all names that expire at those depths.  The expire index is
+     ordered by height, so this is a single range read.  */
+  if (expireFrom <= expireTo)
     {
-      std::set<valtype> newNames;
-      view.GetNamesForHeight (h, newNames);
-      names.insert (newNames.begin (), newNames.end ());
+      std::set<CNameCache::ExpireEntry> entries;
+      view.GetNamesForHeights (expireFrom, expireTo, entries);
+      for (const auto& entry : entries)
+        names.insert (entry.name);
     }
 
-  /* Expire all those names.  */
-  for (std::set<valtype>::const_iterator i = names.begin ();
-       i != names.end (); ++i)
+  /* Look up all names first, and then fetch their coins in outpoint
+     order.  That way the database is read mostly sequentially instead
+     of jumping around in name order.  */
+  std::vector<COutPoint> outpoints;
+  outpoints.reserve (names.size ());
+  for (const auto& name : names)
     {
-      const std::string nameStr = EncodeNameForMessage (*i);
+      const std::string nameStr = EncodeNameForMessage (name);
 
       CNameData data;
-      if (!view.GetName (*i, data))
+      if (!view.GetName (name, data))
         return error ("%s : name %s not found in the database",
                       __func__, nameStr);
       if (!data.isExpired (nHeight))
         return error ("%s : name %s is not actually expired",
                       __func__, nameStr);
 
-      const COutPoint& out = data.getUpdateOutpoint ();
+      outpoints.push_back (data.getUpdateOutpoint ());
+    }
+
+  std::vector<size_t> order(outpoints.size ());
+  for (size_t i = 0; i < order.size (); ++i)
+    order[i] = i;
+  std::sort (order.begin (), order.end (),
+             [&outpoints] (size_t a, size_t b)
+               {
+                 return outpoints[a] < outpoints[b];
+               });
+  for (const size_t i : order)
+    view.AccessCoin (outpoints[i]);
+
+  /* Expire all those names.  This is done in name order, which is the
+     order of the undo data.  */
+  size_t idx = 0;
+  for (std::set<valtype>::const_iterator i = names.begin ();
+       i != names.end (); ++i, ++idx)
+    {
+      const std::string nameStr = EncodeNameForMessage (*i);
+
+      const COutPoint& out = outpoints[idx];
       Coin coin;
       if (!view.GetCoin(out, coin))
         return error ("%s : name coin for %s is not available",
@@ -717,8 +764,54 @@ UnexpireNames (unsigned nHeight, CBlockUndo& undo, CCoinsViewCache& view,
   return true;
 }
 
+bool
+CheckName (const CCoinsView& view, const valtype& name, unsigned nHeight)
+{
+  CNameData data;
+  if (!view.GetName (name, data))
+    {
+      CNameHistoryInfo info;
+      if (fNameHistory && view.GetNameHistoryInfo (name, info)
+          && !info.empty ())
+        return error ("%s : history entry for name '%s' not in main DB",
+                      __func__, EncodeNameForMessage (name));
+      return true;
+    }
+
+  std::set<valtype> namesAtHeight;
+  if (!view.GetNamesForHeight (data.getHeight (), namesAtHeight))
+    return error ("%s : failed to read expire index", __func__);
+  if (namesAtHeight.count (name) == 0)
+    return error ("%s : name '%s' missing in expire index",
+                  __func__, EncodeNameForMessage (name));
+
+  bool inUTXO = false;
+  Coin coin;
+  if (view.GetCoin (data.getUpdateOutpoint (), coin))
+    {
+      const CNameScript nameOp(coin.out.scriptPubKey);
+      inUTXO = nameOp.isNameOp () && nameOp.isAnyUpdate ()
+                && nameOp.getOpName () == name;
+    }
+
+  /* Expiration is checked at height+1, because that matches
+     how the UTXO set is cleared in ExpireNames.  */
+  if (data.isExpired (nHeight + 1))
+    {
+      if (inUTXO)
+        return error ("%s : expired name '%s' in UTXO set",
+                      __func__, EncodeNameForMessage (name));
+    }
+  else if (!inUTXO)
+    return error ("%s : name '%s' in DB but not UTXO set",
+                  __func__, EncodeNameForMessage (name));
+
+  return true;
+}
+
 void
-CheckNameDB (bool disconnect)
+CheckNameDB (const CBlock& block, const std::set<valtype>& names,
+             bool disconnect)
 {
   const int option
     = gArgs.GetArg ("-checknamedb", Params ().DefaultCheckNameDB ());
@@ -733,13 +826,98 @@ CheckNameDB (bool disconnect)
         return;
     }
 
+  std::set<valtype> touched = names;
+  for (const auto& tx : block.vtx)
+    for (const auto& txout : tx->vout)
+      {
+        const CNameScript nameOp(txout.scriptPubKey);
+        if (nameOp.isNameOp () && nameOp.isAnyUpdate ())
+          touched.insert (nameOp.getOpName ());
+      }
+
+  const unsigned nHeight = chainActive.Height ();
+  for (const auto& name : touched)
+    if (!CheckName (*pcoinsTip, name, nHeight))
+      {
+        LogPrintf ("ERROR: %s : name database is inconsistent\n", __func__);
+        assert (false);
+      }
+}
+
+namespace
+{
+
+CCriticalSection cs_nameDBCheck;
+NameDBCheckStatus nameDBCheckStatus GUARDED_BY(cs_nameDBCheck);
+std::unique_ptr<boost::thread> nameDBCheckThread GUARDED_BY(cs_nameDBCheck);
+
+void
+ThreadNameDBCheck (std::shared_ptr<CDBIterator> cursor, unsigned nHeight)
+{
+  RenameThread ("bst-namedbcheck");
+
+  bool ok = false;
+  try
+    {
+      ok = CCoinsViewDB::ValidateNameDB (*cursor, nHeight);
+    }
+  catch (const boost::thread_interrupted&)
+    {
+      LogPrintf ("%s : interrupted\n", __func__);
+    }
+  catch (const std::exception& e)
+    {
+      LogPrintf ("ERROR: %s : %s\n", __func__, e.what ());
+    }
+
+  LOCK (cs_nameDBCheck);
+  nameDBCheckStatus.running = false;
+  nameDBCheckStatus.ok = ok;
+}
+
+} // anonymous namespace
+
+bool
+StartNameDBCheck ()
+{
+  LOCK2 (cs_main, cs_nameDBCheck);
+  if (nameDBCheckStatus.running)
+    return false;
+  if (nameDBCheckThread)
+    nameDBCheckThread->join ();
+
   pcoinsTip->Flush ();
-  const bool ok = pcoinsTip->ValidateNameDB ();
+  const unsigned nHeight = chainActive.Height ();
+  std::shared_ptr<CDBIterator> cursor(pcoinsdbview->SnapshotCursor ());
+
+  nameDBCheckStatus.started = true;
+  nameDBCheckStatus.running = true;
+  nameDBCheckStatus.height = nHeight;
+  nameDBCheckStatus.ok = false;
+  nameDBCheckThread.reset (new boost::thread (&ThreadNameDBCheck,
+                                              cursor, nHeight));
+  return true;
+}
+
+NameDBCheckStatus
+GetNameDBCheckStatus ()
+{
+  LOCK (cs_nameDBCheck);
+  return nameDBCheckStatus;
+}
+
+void
+StopNameDBCheck ()
+{
+  std::unique_ptr<boost::thread> thread;
+  {
+    LOCK (cs_nameDBCheck);
+    thread = std::move (nameDBCheckThread);
+  }
 
-  if (!ok)
+  if (thread)
     {
-      const unsigned nHeight = chainActive.Height ();
-      LogPrintf ("ERROR: %s : name database is inconsistent\n", __func__);
-      assert (false);
+      thread->interrupt ();
+      thread->join ();
     }
 }
@@ -16,7 +16,10 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
+class CBlock;
 class CBlockUndo;
 class CCoinsView;
 class CCoinsViewCache;
@@ -102,17 +105,27 @@ private:
   /** The parent mempool object.  Used to, e. g., remove conflicting tx.  */
   CTxMemPool& pool;
 
-  /** Type used for internal indices.  */
-  typedef std::map<valtype, uint256> NameTxMap;
+  /**
+   * Type used for the indices of pending name operations.  They map names
+   * directly to the mempool entries, which stay at the same address while
+   * they are in the pool, so that conflicts are found without looking up
+   * the pool by txid.
+   */
+  typedef std::unordered_map<valtype, const CTxMemPoolEntry*,
+                             CNameCache::NameHasher> NameEntryMap;
+
+  /** Type used for the index of NAME_NEW hashes.  */
+  typedef std::unordered_map<valtype, uint256,
+                             CNameCache::NameHasher> NameTxMap;
 
   /**
    * Keep track of names that are registered by transactions in the pool.
    * Map name to registering transaction.
    */
-  NameTxMap mapNameRegs;
+  NameEntryMap mapNameRegs;
 
-  /** Map pending name updates to transaction IDs.  */
-  NameTxMap mapNameUpdates;
+  /** Map pending name updates to their transactions.  */
+  NameEntryMap mapNameUpdates;
 
   /**
    * Map NAME_NEW hashes to the corresponding transaction IDs.  This is
@@ -187,27 +200,39 @@ public:
   void remove (const CTxMemPoolEntry& entry);
 
   /**
-   * Remove conflicts for the given tx, based on name operations.  I. e.,
-   * if the tx registers a name that conflicts with another registration
-   * in the mempool, detect this and remove the mempool tx accordingly.
+   * Find conflicts for the given tx, based on name operations.  I. e.,
+   * if the tx registers a name that is also registered by a transaction
+   * in the mempool, that mempool entry is added to the conflicts.
    * @param tx The transaction for which we look for conflicts.
-   * @param removed Put removed tx here.
+   * @param conflicts Add conflicting entries here.
    */
-  void removeConflicts (const CTransaction& tx);
+  void getConflicts (const CTransaction& tx,
+                     std::vector<const CTxMemPoolEntry*>& conflicts) const;
 
   /**
-   * Remove conflicts in the mempool due to unexpired names.  This removes
-   * conflicting name registrations that are no longer possible.
+   * Find conflicts in the mempool due to unexpired names.  These are
+   * name registrations that are no longer possible.
    * @param unexpired The set of unexpired names.
-   * @param removed Put removed tx here.
+   * @param conflicts Add conflicting entries here.
    */
-  void removeUnexpireConflicts (const std::set<valtype>& unexpired);
+  void getUnexpireConflicts (const std::set<valtype>& unexpired,
+                             std::vector<const CTxMemPoolEntry*>& conflicts)
+    const;
+
   /**
-   * Remove conflicts in the mempool due to expired names.  This removes
-   * conflicting name updates that are no longer possible.
+   * Find conflicts in the mempool due to expired names.  These are
+   * name updates that are no longer possible.
    * @param expired The set of expired names.
-   * @param removed Put removed tx here.
+   * @param conflicts Add conflicting entries here.
    */
+  void getExpireConflicts (const std::set<valtype>& expired,
+                           std::vector<const CTxMemPoolEntry*>& conflicts)
+    const;
+
+  /* Remove the conflicts found by the methods above, together with all
+     their descendants, from the pool.  */
+  void removeConflicts (const CTransaction& tx);
+  void removeUnexpireConflicts (const std::set<valtype>& unexpired);
   void removeExpireConflicts (const std::set<valtype>& expired);
 
   /**
@@ -308,11 +333,56 @@ bool UnexpireNames (unsigned nHeight, CBlockUndo& undo,
                     CCoinsViewCache& view, std::set<valtype>& names);
 
 /**
- * Check the name database consistency.  This calls CCoinsView::ValidateNameDB,
- * but only if applicable depending on the -checknamedb setting.  If it fails,
- * this throws an assertion failure.
+ * Check a single name in the chain state.  An unexpired name must be held
+ * by the coin at its update outpoint, an expired one must be gone from the
+ * UTXO set, and either must be listed in the expire index at its height.
+ * @param view The chain state to check.
+ * @param name The name to check.
+ * @param nHeight The height of the best block of view.
+ * @return True iff the name is consistent.
+ */
+bool CheckName (const CCoinsView& view, const valtype& name, unsigned nHeight);
+
+/**
+ * Check the name database consistency for the names touched by a block
+ * that was just connected or disconnected, if applicable depending on the
+ * -checknamedb setting.  Each name is checked against the UTXO set and the
+ * expire index of pcoinsTip, so that the chain state need not be flushed.
+ * If it fails, this throws an assertion failure.
+ * @param block The block connected or disconnected.
+ * @param names Names expired or unexpired together with the block.
  * @param disconnect Whether we are disconnecting blocks.
  */
-void CheckNameDB (bool disconnect);
+void CheckNameDB (const CBlock& block, const std::set<valtype>& names,
+                  bool disconnect);
+
+/**
+ * State of the full name database check run in the background.
+ */
+struct NameDBCheckStatus
+{
+  /** Whether a check has been started at all.  */
+  bool started = false;
+  /** Whether the check is still running.  */
+  bool running = false;
+  /** Height of the chain state that is being checked.  */
+  unsigned height = 0;
+  /** Result of the finished check.  */
+  bool ok = false;
+};
+
+/**
+ * Start CCoinsViewDB::ValidateNameDB on a snapshot of the chain state in
+ * a background thread.  The chain state is flushed first, which requires
+ * cs_main; the scan itself runs without it.
+ * @return False if a check is already running.
+ */
+bool StartNameDBCheck ();
+
+/** Return the state of the last background name database check.  */
+NameDBCheckStatus GetNameDBCheckStatus ();
+
+/** Interrupt a running background name database check and wait for it.  */
+void StopNameDBCheck ();
 
 #endif // H_BITCOIN_NAMES_MAIN
@@ -0,0 +1,248 @@
+// Copyright (c) 2018 Daniel Kraft
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <names/snapshot.h>
+
+#include <chain.h>
+#include <coins.h>
+#include <memusage.h>
+#include <names/encoding.h>
+#include <txdb.h>
+#include <util.h>
+#include <utiltime.h>
+#include <validation.h>
+
+#include <limits>
+
+namespace
+{
+
+/**
+ * The published name state.  It is only replaced with cs_main held, but
+ * read without any lock through the atomic shared_ptr functions.
+ */
+CNameStateSnapshotRef currentNameState;
+
+/** Time (in microseconds) the database snapshot of the state was taken.  */
+int64_t nNameStateSnapshotTime = 0;
+
+} // anonymous namespace
+
+CNameStateSnapshot::CNameStateSnapshot (
+    const std::shared_ptr<const CCoinsView>& b, const uint256& hash,
+    const int h)
+  : base(b), changes(), hashBlock(hash), nHeight(h)
+{}
+
+CNameStateSnapshot::CNameStateSnapshot (
+    const std::shared_ptr<const CCoinsView>& b, const CNameCache& pending,
+    const uint256& hash, const int h)
+  : base(b), changes(), hashBlock(hash), nHeight(h)
+{
+  if (!pending.empty ())
+    changes.push_back ({std::make_shared<const CNameCache> (pending),
+                        std::numeric_limits<unsigned>::max ()});
+}
+
+bool
+CNameStateSnapshot::getName (const valtype& name, CNameData& data) const
+{
+  for (auto it = changes.rbegin (); it != changes.rend (); ++it)
+    {
+      if (it->cache->isDeleted (name))
+        return false;
+      if (it->cache->get (name, data))
+        return true;
+    }
+
+  return base->GetName (name, data);
+}
+
+bool
+CNameStateSnapshot::getNameHistory (const valtype& name,
+                                    CNameHistory& data) const
+{
+  assert (fNameHistory);
+
+  CNameHistoryInfo info;
+  bool found = false;
+  for (auto it = changes.rbegin (); !found && it != changes.rend (); ++it)
+    found = it->cache->getHistoryInfo (name, info);
+  if (!found && !base->GetNameHistoryInfo (name, info))
+    return false;
+  if (info.empty ())
+    return false;
+
+  std::vector<CNameData> entries;
+  entries.reserve (info.nStored);
+  for (uint32_t idx = info.first (); idx < info.nEnd; ++idx)
+    {
+      CNameData entry;
+      found = false;
+      for (auto it = changes.rbegin (); !found && it != changes.rend (); ++it)
+        {
+          if (it->cache->isHistoryEntryErased (name, idx))
+            break;
+          found = it->cache->getHistoryEntry (name, idx, entry);
+        }
+      if (!found && !base->GetNameHistoryEntry (name, idx, entry))
+        return error ("%s : history entry %u of name %s missing",
+                      __func__, idx, EncodeNameForMessage (name));
+      entries.push_back (entry);
+    }
+
+  data = CNameHistory (info.nEnd, std::move (entries));
+  return true;
+}
+
+bool
+CNameStateSnapshot::getNamesForHeights (
+    const unsigned nFromHeight, const unsigned nToHeight,
+    std::set<CNameCache::ExpireEntry>& entries) const
+{
+  if (!base->GetNamesForHeights (nFromHeight, nToHeight, entries))
+    return false;
+
+  for (const auto& entry : changes)
+    entry.cache->updateNamesForHeights (nFromHeight, nToHeight, entries);
+  return true;
+}
+
+CNameIterator*
+CNameStateSnapshot::iterateNames () const
+{
+  CNameIterator* res = base->IterateNames ();
+  for (const auto& entry : changes)
+    res = entry.cache->iterateNames (res);
+  return res;
+}
+
+size_t
+CNameStateSnapshot::DynamicMemoryUsage () const
+{
+  size_t res = memusage::DynamicUsage (changes);
+  for (const auto& entry : changes)
+    res += memusage::DynamicUsage (entry.cache)
+            + entry.cache->DynamicMemoryUsage ();
+  return res;
+}
+
+std::shared_ptr<const CNameStateSnapshot>
+CNameStateSnapshot::withChanges (const CNameCache& blockChanges,
+                                 const uint256& hash, const int h) const
+{
+  auto res = std::make_shared<CNameStateSnapshot> (base, hash, h);
+  res->changes = changes;
+  if (!blockChanges.empty ())
+    res->changes.push_back ({std::make_shared<const CNameCache> (blockChanges),
+                             1});
+
+  /* Merge the newest run into the one before it as long as that one does
+     not cover more blocks, like carries in a binary counter.  */
+  while (res->changes.size () > 1)
+    {
+      const BlockChanges& newer = res->changes.back ();
+      BlockChanges& older = res->changes[res->changes.size () - 2];
+      if (older.blocks > newer.blocks)
+        break;
+
+      auto merged = std::make_shared<CNameCache> (*older.cache);
+      merged->apply (*newer.cache);
+      older.cache = merged;
+      older.blocks += newer.blocks;
+      res->changes.pop_back ();
+    }
+
+  return res;
+}
+
+CNameStateSnapshotRef
+GetNameStateSnapshot ()
+{
+  CNameStateSnapshotRef res = std::atomic_load (&currentNameState);
+  if (res != nullptr || IsInitialBlockDownload ())
+    return res;
+
+  LOCK (cs_main);
+  res = std::atomic_load (&currentNameState);
+  if (res == nullptr)
+    res = CreateNameStateSnapshot ();
+  return res;
+}
+
+CNameStateSnapshotRef
+GetPublishedNameState ()
+{
+  return std::atomic_load (&currentNameState);
+}
+
+CNameStateSnapshotRef
+CreateNameStateSnapshot ()
+{
+  AssertLockHeld (cs_main);
+
+  if (pcoinsdbview == nullptr || pcoinsTip == nullptr)
+    return nullptr;
+
+  const uint256 hash = pcoinsTip->GetBestBlock ();
+  const CBlockIndex* pindex = LookupBlockIndex (hash);
+  if (pindex == nullptr)
+    return nullptr;
+
+  std::shared_ptr<const CCoinsView> base(pcoinsdbview->Snapshot ());
+  const CNameStateSnapshotRef res
+      = std::make_shared<const CNameStateSnapshot> (
+          base, pcoinsTip->GetNameChanges (), hash, pindex->nHeight);
+
+  std::atomic_store (&currentNameState, res);
+  nNameStateSnapshotTime = GetTimeMicros ();
+  return res;
+}
+
+void
+PublishNameChanges (const CNameCache& blockChanges, const uint256& prevHash,
+                    const uint256& hash, const int height,
+                    const bool fInitialDownload)
+{
+  AssertLockHeld (cs_main);
+
+  const CNameStateSnapshotRef cur = std::atomic_load (&currentNameState);
+  if (cur == nullptr)
+    return;
+
+  if (fInitialDownload)
+    {
+      std::atomic_store (&currentNameState, CNameStateSnapshotRef ());
+      return;
+    }
+
+  if (cur->getBlockHash () != prevHash)
+    {
+      LogPrint (BCLog::NAMES, "%s: name state at %s does not precede %s\n",
+                __func__, cur->getBlockHash ().GetHex (), hash.GetHex ());
+      std::atomic_store (&currentNameState, CNameStateSnapshotRef ());
+      return;
+    }
+
+  std::atomic_store (&currentNameState,
+                     cur->withChanges (blockChanges, hash, height));
+}
+
+void
+ResetNameStateSnapshot ()
+{
+  AssertLockHeld (cs_main);
+  std::atomic_store (&currentNameState, CNameStateSnapshotRef ());
+}
+
+void
+ExpireNameStateSnapshot (const int64_t nNow)
+{
+  AssertLockHeld (cs_main);
+
+  if (std::atomic_load (&currentNameState) != nullptr
+        && nNow > nNameStateSnapshotTime
+                    + NAME_STATE_SNAPSHOT_INTERVAL * 1000000)
+    ResetNameStateSnapshot ();
+}
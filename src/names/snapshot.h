@@ -0,0 +1,159 @@
+// Copyright (c) 2018 Daniel Kraft
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef H_BITCOIN_NAMES_SNAPSHOT
+#define H_BITCOIN_NAMES_SNAPSHOT
+
+#include <names/common.h>
+#include <uint256.h>
+
+#include <memory>
+#include <set>
+#include <vector>
+
+class CCoinsView;
+
+/** Seconds after which the name state's snapshot of the database is released.  */
+static const int64_t NAME_STATE_SNAPSHOT_INTERVAL = 10 * 60;
+
+/**
+ * Immutable state of the name database at some block, which can be read
+ * without holding cs_main.  It consists of a snapshot of the coin database,
+ * plus the name changes that were not yet flushed to it when the snapshot
+ * was taken and those of the blocks connected or disconnected since then.  The changes are kept in a few runs of blocks
+ * (newest last) which are shared between states, so that publishing a block
+ * does not copy the changes of all the blocks before it.
+ */
+class CNameStateSnapshot
+{
+
+private:
+
+  /** Snapshot of the database the changes are applied on.  */
+  std::shared_ptr<const CCoinsView> base;
+
+  /** Merged name changes of a run of consecutive blocks.  */
+  struct BlockChanges
+  {
+    std::shared_ptr<const CNameCache> cache;
+    unsigned blocks;
+  };
+
+  /**
+   * Name changes of the blocks since the database snapshot.  Each run covers
+   * more blocks than the next one, so that there are only logarithmically
+   * many of them and every block is merged (copied) only that often.
+   */
+  std::vector<BlockChanges> changes;
+
+  /** Block whose state this is, and its height.  */
+  uint256 hashBlock;
+  int nHeight;
+
+public:
+
+  CNameStateSnapshot (const std::shared_ptr<const CCoinsView>& b,
+                      const uint256& hash, int h);
+
+  /**
+   * Construct the state at a block from a database snapshot and the name
+   * changes not yet flushed to it.  Those may be many, so they are kept as a
+   * run of their own that the changes of later blocks are never merged into.
+   */
+  CNameStateSnapshot (const std::shared_ptr<const CCoinsView>& b,
+                      const CNameCache& pending,
+                      const uint256& hash, int h);
+
+  inline const uint256&
+  getBlockHash () const
+  {
+    return hashBlock;
+  }
+
+  inline int
+  getHeight () const
+  {
+    return nHeight;
+  }
+
+  /* Look up the current data of a name.  */
+  bool getName (const valtype& name, CNameData& data) const;
+
+  /* Look up the stored history of a name.  -namehistory must be enabled.  */
+  bool getNameHistory (const valtype& name, CNameHistory& data) const;
+
+  /* Look up the names in the expire index for a range of heights.  */
+  bool getNamesForHeights (unsigned nFromHeight, unsigned nToHeight,
+                           std::set<CNameCache::ExpireEntry>& entries) const;
+
+  /* Iterate the names.  The iterator must not outlive this state.  */
+  CNameIterator* iterateNames () const;
+
+  /* Memory held by the name changes of this state.  */
+  size_t DynamicMemoryUsage () const;
+
+  /* Return the state after the given name changes, at a new block.  */
+  std::shared_ptr<const CNameStateSnapshot>
+    withChanges (const CNameCache& blockChanges,
+                 const uint256& hash, int h) const;
+
+};
+
+typedef std::shared_ptr<const CNameStateSnapshot> CNameStateSnapshotRef;
+
+/**
+ * Return the latest published name state.  This is lock-free; the returned
+ * state stays valid as long as it is held, but may lag behind the chain tip
+ * by the block currently being processed.  If there is no state, a new one
+ * is created at the tip, which takes cs_main once.  During the initial block
+ * download, where it would be dropped with the next block anyway, or before
+ * the chain state is loaded, null is returned and readers fall back to
+ * cs_main.
+ */
+CNameStateSnapshotRef GetNameStateSnapshot ();
+
+/**
+ * Return the published name state, or null if there is none, without
+ * creating one.
+ */
+CNameStateSnapshotRef GetPublishedNameState ();
+
+/**
+ * Create and publish the name state at the tip of the coins cache, from a
+ * fresh snapshot of the database and the name changes of the cache not yet
+ * flushed to it.  Returns null if the chain state is not loaded.  Must be
+ * called with cs_main held.
+ */
+CNameStateSnapshotRef CreateNameStateSnapshot ();
+
+/**
+ * Publish the name changes of a block connected to or disconnected from the
+ * tip, on top of the current state, which must be at prevHash.  This is
+ * done once the changes are flushed to the coins cache and the block is the
+ * tip, so that the state never runs ahead of the chain.  If the state is
+ * not at prevHash, or during the initial block download (where nobody reads
+ * names and the changes would pile up), the state is dropped until it is
+ * created again.  Must be called with cs_main held.
+ */
+void PublishNameChanges (const CNameCache& blockChanges, const uint256& prevHash,
+                         const uint256& hash, int height,
+                         bool fInitialDownload);
+
+/**
+ * Drop the name state, releasing its snapshot of the database.  This must be
+ * done before the database is destroyed, and is done after a full flush so
+ * that the next state is based on the flushed database.  Must be called with
+ * cs_main held.
+ */
+void ResetNameStateSnapshot ();
+
+/**
+ * Drop the name state if its snapshot of the database is older than
+ * NAME_STATE_SNAPSHOT_INTERVAL.  A held snapshot keeps LevelDB from dropping
+ * the data it sees during compactions, so it is not kept until the next full
+ * flush, which may be a day away.  Must be called with cs_main held.
+ */
+void ExpireNameStateSnapshot (int64_t nNow);
+
+#endif // H_BITCOIN_NAMES_SNAPSHOT
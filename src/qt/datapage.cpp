@@ -608,8 +608,8 @@ void DataPage::retrieve()
     
         std::string txid=ui->txidRetrieveEdit->text().toStdString();
         RetrieveDataTxs retrieveDataTxs(txid, pwallet);
-        std::vector<char> txData=retrieveDataTxs.getTxData();
-        QByteArray dataArray(txData.data(), txData.size());
+        const Span<const unsigned char> txData=retrieveDataTxs.getTxData();
+        QByteArray dataArray(reinterpret_cast<const char*>(txData.data()), txData.size());
 
         textValue = QString::fromUtf8(dataArray);
         hexaValue = dataArray.toHex();
@@ -896,8 +896,8 @@ void DataPage::check()
         }
             
         RetrieveDataTxs retrieveDataTxs(txid, pwallet);
-        std::vector<char> txData=retrieveDataTxs.getTxData();
-        QByteArray dataArray(txData.data(), txData.size());
+        const Span<const unsigned char> txData=retrieveDataTxs.getTxData();
+        QByteArray dataArray(reinterpret_cast<const char*>(txData.data()), txData.size());
 
         if(ui->checkFileRadioButton->isChecked() || ui->checkMessageRadioButton->isChecked())
         {
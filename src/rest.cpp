@@ -9,6 +9,7 @@
 #include <index/txindex.h>
 #include <names/common.h>
 #include <names/encoding.h>
+#include <names/snapshot.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <validation.h>
@@ -26,7 +27,11 @@
 
 #include <univalue.h>
 
+#include <algorithm>
+#include <unordered_map>
+
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
+static const size_t MAX_REST_NAMES = 1000; //allow a max of 1000 names to be resolved at once
 
 enum class RetFormat {
     UNDEF,
@@ -628,6 +633,111 @@ static bool rest_getutxos(HTTPRequest* req, const std::string& strURIPart)
     }
 }
 
+/** Result of resolving a name for the REST interface.  */
+struct RestNameRecord
+{
+    bool found = false;
+    CNameData data;
+};
+
+/**
+ * Cache of the name records resolved by the REST interface.  It holds the
+ * records of one block of the published name state, and is cleared as soon
+ * as a lookup sees the state at another block.  Names missing from the cache
+ * are read from the name state outside of its lock.
+ */
+class RestNameCache
+{
+private:
+    /** Maximum number of records; the cache is cleared when it is full.  */
+    static const size_t MAX_ENTRIES = 10000;
+
+    CCriticalSection cs;
+    uint256 hashBlock GUARDED_BY(cs);
+    std::unordered_map<valtype, RestNameRecord, CNameCache::NameHasher> records GUARDED_BY(cs);
+
+public:
+    /* Fill in the cached records of the names at the given block, and mark
+       which of them were cached.  */
+    void get(const uint256& hash, const std::vector<valtype>& names,
+             std::vector<RestNameRecord>& res, std::vector<bool>& cached)
+    {
+        cached.assign(names.size(), false);
+        LOCK(cs);
+        if (hashBlock != hash)
+            return;
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            const auto it = records.find(names[i]);
+            if (it != records.end())
+            {
+                res[i] = it->second;
+                cached[i] = true;
+            }
+        }
+    }
+
+    /* Add the records of the names that were not cached.  */
+    void add(const uint256& hash, const std::vector<valtype>& names,
+             const std::vector<RestNameRecord>& res, const std::vector<bool>& cached)
+    {
+        LOCK(cs);
+        if (hashBlock != hash)
+        {
+            records.clear();
+            hashBlock = hash;
+        }
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            if (cached[i])
+                continue;
+            if (records.size() >= MAX_ENTRIES)
+                records.clear();
+            records.emplace(names[i], res[i]);
+        }
+    }
+};
+
+static RestNameCache restNameCache;
+
+/**
+ * Resolves a batch of names.  They are read through the cache from the
+ * published name state without taking cs_main, so that concurrent REST
+ * workers do not contend with block processing.  Only if there is no
+ * published state, the chain state is locked instead.  All records are
+ * as of the same block, whose height and hash are returned.
+ */
+static void ResolveNames(const std::vector<valtype>& names,
+                         std::vector<RestNameRecord>& records,
+                         int& height, uint256& hash)
+{
+    records.assign(names.size(), RestNameRecord());
+
+    const CNameStateSnapshotRef snapshot = GetNameStateSnapshot();
+    if (snapshot == nullptr)
+    {
+        LOCK(cs_main);
+        for (size_t i = 0; i < names.size(); ++i)
+            records[i].found = pcoinsTip->GetName(names[i], records[i].data);
+        height = chainActive.Height();
+        hash = chainActive.Tip()->GetBlockHash();
+        return;
+    }
+
+    height = snapshot->getHeight();
+    hash = snapshot->getBlockHash();
+
+    std::vector<bool> cached;
+    restNameCache.get(hash, names, records, cached);
+    if (std::find(cached.begin(), cached.end(), false) == cached.end())
+        return;
+
+    for (size_t i = 0; i < names.size(); ++i)
+        if (!cached[i])
+            records[i].found = snapshot->getName(names[i], records[i].data);
+    restNameCache.add(hash, names, records, cached);
+}
+
 static bool rest_name(HTTPRequest* req, const std::string& strURIPart)
 {
     if (!CheckWarmup(req))
@@ -640,10 +750,14 @@ static bool rest_name(HTTPRequest* req, const std::string& strURIPart)
         return RESTERR(req, HTTP_BAD_REQUEST,
                        "Invalid encoded name: " + encodedName);
 
-    CNameData data;
-    if (!pcoinsTip->GetName(plainName, data))
+    std::vector<RestNameRecord> records;
+    int height;
+    uint256 hash;
+    ResolveNames({plainName}, records, height, hash);
+    if (!records[0].found)
         return RESTERR(req, HTTP_NOT_FOUND,
                        EncodeNameForMessage (plainName) + " not found");
+    const CNameData& data = records[0].data;
 
     switch (rf)
     {
@@ -666,7 +780,7 @@ static bool rest_name(HTTPRequest* req, const std::string& strURIPart)
 
     case RetFormat::JSON:
     {
-        const UniValue obj = getNameInfo(plainName, data);
+        const UniValue obj = getNameInfo(plainName, data, height);
         const std::string strJSON = obj.write() + "\n";
         req->WriteHeader("Content-Type", "application/json");
         req->WriteReply(HTTP_OK, strJSON);
@@ -683,6 +797,141 @@ static bool rest_name(HTTPRequest* req, const std::string& strURIPart)
     return true; // continue to process further HTTP reqs on this cxn
 }
 
+static bool rest_names(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    if (!param.empty())
+        return RESTERR(req, HTTP_BAD_REQUEST, "Error: names must be sent as POST data");
+
+    std::string strRequest = req->ReadBody();
+    if (strRequest.empty())
+        return RESTERR(req, HTTP_BAD_REQUEST, "Error: empty request");
+
+    // parse/deserialize input
+    // input-format = output-format, like for rest/getutxos
+    std::vector<valtype> names;
+    switch (rf)
+    {
+    case RetFormat::HEX:
+    {
+        // convert hex to bin, continue then with bin part
+        const std::vector<unsigned char> requestBin = ParseHex(strRequest);
+        strRequest.assign(requestBin.begin(), requestBin.end());
+    }
+
+    case RetFormat::BINARY:
+    {
+        try {
+            CDataStream ss(strRequest.data(), strRequest.data() + strRequest.size(),
+                           SER_NETWORK, PROTOCOL_VERSION);
+            ss >> names;
+        } catch (const std::ios_base::failure&) {
+            // abort in case of unreadable binary data
+            return RESTERR(req, HTTP_BAD_REQUEST, "Parse error");
+        }
+        break;
+    }
+
+    case RetFormat::JSON:
+    {
+        UniValue request;
+        if (!request.read(strRequest) || !request.isArray())
+            return RESTERR(req, HTTP_BAD_REQUEST, "Error: expected JSON array of names");
+        for (const UniValue& val : request.getValues())
+        {
+            if (!val.isStr())
+                return RESTERR(req, HTTP_BAD_REQUEST, "Error: expected JSON array of names");
+            try {
+                names.push_back(DecodeName(val.get_str(), ConfiguredNameEncoding()));
+            } catch (const InvalidNameString&) {
+                return RESTERR(req, HTTP_BAD_REQUEST, "Invalid encoded name: " + val.get_str());
+            }
+        }
+        break;
+    }
+
+    default:
+        return RESTERR(req, HTTP_NOT_FOUND,
+                       "output format not found (available: "
+                        + AvailableDataFormatsString() + ")");
+    }
+
+    if (names.empty())
+        return RESTERR(req, HTTP_BAD_REQUEST, "Error: empty request");
+    if (names.size() > MAX_REST_NAMES)
+        return RESTERR(req, HTTP_BAD_REQUEST, strprintf("Error: max names exceeded (max: %d, tried: %d)", MAX_REST_NAMES, names.size()));
+
+    std::vector<RestNameRecord> records;
+    int height;
+    uint256 hash;
+    ResolveNames(names, records, height, hash);
+
+    switch (rf)
+    {
+    case RetFormat::BINARY:
+    case RetFormat::HEX:
+    {
+        // same layout as rest/getutxos: a bitmap of the names found,
+        // followed by the data of those names
+        std::vector<unsigned char> bitmap((names.size() + 7) / 8);
+        std::vector<CNameData> found;
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            if (!records[i].found)
+                continue;
+            bitmap[i / 8] |= 1 << (i % 8);
+            found.push_back(records[i].data);
+        }
+
+        CDataStream ssResponse(SER_NETWORK, PROTOCOL_VERSION);
+        ssResponse << height << hash << bitmap << found;
+
+        if (rf == RetFormat::HEX)
+        {
+            const std::string strHex = HexStr(ssResponse.begin(), ssResponse.end()) + "\n";
+            req->WriteHeader("Content-Type", "text/plain");
+            req->WriteReply(HTTP_OK, strHex);
+            return true;
+        }
+
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, ssResponse.str());
+        return true;
+    }
+
+    case RetFormat::JSON:
+    {
+        UniValue result(UniValue::VARR);
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            if (records[i].found)
+                result.push_back(getNameInfo(names[i], records[i].data, height));
+            else
+                result.push_back(NullUniValue);
+        }
+
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("chainHeight", height);
+        obj.pushKV("chaintipHash", hash.GetHex());
+        obj.pushKV("names", result);
+
+        const std::string strJSON = obj.write() + "\n";
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, strJSON);
+        return true;
+    }
+
+    default:
+        assert(false);
+    }
+
+    // not reached
+    return true; // continue to process further HTTP reqs on this cxn
+}
+
 static const struct {
     const char* prefix;
     bool (*handler)(HTTPRequest* req, const std::string& strReq);
@@ -696,6 +945,7 @@ static const struct {
       {"/rest/headers/", rest_headers},
       {"/rest/getutxos", rest_getutxos},
       {"/rest/name/", rest_name},
+      {"/rest/names", rest_names},
 };
 
 void StartREST()
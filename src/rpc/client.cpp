@@ -30,14 +30,31 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "makebet", 1 , "range" },
     { "makebet", 2 , "replaceable" },
     { "makebet", 3 , "conf_target" },
+    { "makebets", 0 , "bets" },
+    { "makebets", 1 , "replaceable" },
+    { "makebets", 2 , "conf_target" },
+    { "simulatebets", 1 , "transactions" },
+    { "simulatebets", 2 , "verbose" },
+    { "listbets", 1 , "count" },
+    { "listbets", 2 , "skip" },
     { "getbet", 3 , "replaceable" },
     { "getbet", 4 , "conf_target" },
     { "storemessage", 1 , "replaceable" },
     { "storemessage", 2 , "conf_target" },
     { "storesignature", 1 , "replaceable" },
     { "storesignature", 2 , "conf_target" },
+    { "storesignatures", 0 , "documents" },
+    { "storesignatures", 1 , "replaceable" },
+    { "storesignatures", 2 , "conf_target" },
+    { "checksignatureproof", 2 , "index" },
+    { "checksignatureproof", 3 , "branch" },
+    { "checksignatureproof", 4 , "digest" },
     { "storedata", 1 , "replaceable" },
     { "storedata", 2 , "conf_target" },
+    { "listunspentpage", 1 , "count" },
+    { "listunspentpage", 2 , "addresses" },
+    { "listunspentpage", 3 , "minconf" },
+    { "listunspentpage", 4 , "maxconf" },
     { "setmocktime", 0, "timestamp" },
     { "generate", 0, "nblocks" },
     { "generate", 1, "maxtries" },
@@ -164,6 +181,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "name_filter", 1, "maxage" },
     { "name_filter", 2, "from" },
     { "name_filter", 3, "nb" },
+    { "name_checkdb", 0, "restart" },
     { "name_new", 1, "options" },
     { "name_firstupdate", 4, "options" },
     { "name_firstupdate", 5, "allow_active" },
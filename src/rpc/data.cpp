@@ -16,14 +16,20 @@
 #include <utilmoneystr.h>
 #include <wallet/coincontrol.h>
 #include <wallet/fees.h>
+#include <wallet/gamepool.h>
+#include <wallet/rpcwallet.h>
 
 #include <univalue.h>
 #include <boost/algorithm/string.hpp>
 
 #include <data/datautils.h>
+#include <data/documentproof.h>
+#include <data/processunspent.h>
 #include <data/retrievedatatxs.h>
+#include <index/dataindex.h>
 
 static constexpr size_t maxDataSize=MAX_OP_RETURN_RELAY-6;
+static constexpr size_t fileChunkSize=1<<16;
 static std::string changeAddress("");
 
 template 
@@ -79,6 +85,31 @@ public:
         }
     }
 
+    size_t getSize() const
+    {
+        return static_cast<size_t>(size);
+    }
+
+    //hashes the file chunk by chunk instead of loading it whole
+    uint256 hash()
+    {
+        CHash256 fileHasher;
+        if(file.is_open())
+        {
+            std::vector<char> chunk(fileChunkSize);
+            file.seekg(0, std::ios::beg);
+            while(file)
+            {
+                file.read(chunk.data(), chunk.size());
+                fileHasher.Write(reinterpret_cast<const unsigned char*>(chunk.data()), file.gcount());
+            }
+        }
+
+        uint256 fileHash;
+        fileHasher.Finalize(fileHash.begin());
+        return fileHash;
+    }
+
 private:
     std::ifstream file;
     std::streampos size;
@@ -103,11 +134,11 @@ public:
         }
     }
 
-    void write(const std::vector<char>& binaryData)
+    void write(Span<const unsigned char> binaryData)
     {
         if(file.is_open())
         {
-            file.write(binaryData.data(), binaryData.size());
+            file.write(reinterpret_cast<const char*>(binaryData.data()), binaryData.size());
         }
     }
 
@@ -115,30 +146,28 @@ private:
     std::ofstream file;
 };
 
-static std::string computeHash(char* binaryData, size_t size)
+static uint256 computeHash(Span<const unsigned char> binaryData)
 {
-    constexpr size_t hashSize=CSHA256::OUTPUT_SIZE;
-    unsigned char fileHash[hashSize];
-
-    CHash256 fileHasher;
-
-    fileHasher.Write(reinterpret_cast<unsigned char*>(binaryData), size);
-    fileHasher.Finalize(fileHash);
-
-    return byte2str(&fileHash[0], static_cast<int>(hashSize));                
+    uint256 hash;
+    CHash256().Write(binaryData.data(), binaryData.size()).Finalize(hash.begin());
+    return hash;
 }
 
-static void computeHash(char* binaryData, size_t size, std::vector<unsigned char>& hash)
+//a document is a path to the file to hash, or with digest set the hex-encoded 32-byte hash of the file;
+//both are tagged as leaves by the document tree so a digest can not stand for an inner node
+static uint256 documentHash(const std::string& document, bool digest)
 {
-    constexpr size_t hashSize=CSHA256::OUTPUT_SIZE;
-    unsigned char fileHash[hashSize];
-
-    CHash256 fileHasher;
-
-    fileHasher.Write(reinterpret_cast<unsigned char*>(binaryData), size);
-    fileHasher.Finalize(fileHash);
+    if(digest)
+    {
+        if(document.size()!=2*CSHA256::OUTPUT_SIZE || !IsHex(document))
+        {
+            throw std::runtime_error("digest must be a hex-encoded 32-byte hash");
+        }
+        return uint256(ParseHex(document));
+    }
 
-    hash.insert(hash.end(), &fileHash[0], &fileHash[hashSize]);
+    FileReader<char> fileReader(document);
+    return fileReader.hash();
 }
 
 static UniValue callRPC(std::string args)
@@ -162,7 +191,7 @@ static UniValue callRPC(std::string args)
     }
 }
 
-static std::vector<char> getOPreturnData(const std::string& txid)
+static RetrieveDataTxs retrieveDataTxs(const std::string& txid)
 {
     std::shared_ptr<CWallet> wallet = GetWallets()[0];
     CWallet* pwallet=nullptr;
@@ -171,8 +200,7 @@ static std::vector<char> getOPreturnData(const std::string& txid)
         pwallet=wallet.get();
     }
     
-    RetrieveDataTxs retrieveDataTxs(txid, pwallet);
-    return retrieveDataTxs.getTxData();
+    return RetrieveDataTxs(txid, pwallet);
 }
 
 UniValue setOPreturnData(const std::vector<unsigned char>& data, CCoinControl& coin_control)
@@ -208,7 +236,10 @@ UniValue setOPreturnData(const std::vector<unsigned char>& data, CCoinControl& c
 
     EnsureWalletIsUnlocked(pwallet);
 
-    if(!pwallet->CreateTransaction(vecSend, nullptr, tx, reservekey, nFeeRequired, nChangePosInOut, strFailReason, coin_control))
+    //spend a pre-split output of the -gamepool if there is one, otherwise run coin selection
+    const std::shared_ptr<CGamePool> pool = GetGamePool(pwallet);
+    const bool fromPool = pool && pool->CreateTransaction(vecSend, CTransaction::CURRENT_VERSION, tx, reservekey, coin_control, strFailReason);
+    if(!fromPool && !pwallet->CreateTransaction(vecSend, nullptr, tx, reservekey, nFeeRequired, nChangePosInOut, strFailReason, coin_control))
     {
         if (nFeeRequired > curBalance)
         {
@@ -220,6 +251,10 @@ UniValue setOPreturnData(const std::vector<unsigned char>& data, CCoinControl& c
     CValidationState state;
     if(!pwallet->CommitTransaction(tx, {}, {}, reservekey, g_connman.get(), state))
     {
+        if (fromPool)
+        {
+            pool->ReturnTransaction(*tx);
+        }
         throw std::runtime_error(std::string("CommitTransaction failed with reason: ")+FormatStateMessage(state));
     }
 
@@ -252,7 +287,8 @@ UniValue retrievedata(const JSONRPCRequest& request)
     );
 
     std::string txid=request.params[0].get_str();
-    std::vector<char> OPreturnData=getOPreturnData(txid);
+    const RetrieveDataTxs dataTx=retrieveDataTxs(txid);
+    const Span<const unsigned char> OPreturnData=dataTx.getTxData();
 
     if(!request.params[1].isNull())
     {
@@ -263,7 +299,7 @@ UniValue retrievedata(const JSONRPCRequest& request)
         return UniValue(UniValue::VSTR);
     }
 
-    std::string retStr=byte2str(reinterpret_cast<unsigned char*>(OPreturnData.data()), OPreturnData.size());
+    std::string retStr=byte2str(OPreturnData.data(), OPreturnData.size());
     return UniValue(UniValue::VSTR, std::string("\"")+retStr+std::string("\""));
 }
 
@@ -289,8 +325,9 @@ UniValue retrievemessage(const JSONRPCRequest& request)
     );
 
     std::string txid=request.params[0].get_str();
-    std::vector<char> OPreturnData=getOPreturnData(txid);
-    if(!OPreturnData.empty())
+    const RetrieveDataTxs dataTx=retrieveDataTxs(txid);
+    const Span<const unsigned char> OPreturnData=dataTx.getTxData();
+    if(OPreturnData.size()>0)
     {
         return UniValue(UniValue::VSTR, std::string("\"")+std::string(OPreturnData.begin(), OPreturnData.end())+std::string("\""));
     }
@@ -384,11 +421,9 @@ UniValue storesignature(const JSONRPCRequest& request)
 
     std::string filePath=request.params[0].get_str();
 
-    std::vector<char> binaryData;
     FileReader<char> fileReader(filePath);
-    fileReader.read(binaryData);
-    std::vector<unsigned char> data;
-    computeHash(binaryData.data(), binaryData.size(), data);
+    const uint256 fileHash=fileReader.hash();
+    std::vector<unsigned char> data(fileHash.begin(), fileHash.end());
 
     CCoinControl coin_control;
     if (!request.params[1].isNull())
@@ -410,6 +445,135 @@ UniValue storesignature(const JSONRPCRequest& request)
     return setOPreturnData(data, coin_control);
 }
 
+UniValue storesignatures(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 4)
+    throw std::runtime_error(
+        "storesignatures [\"document\",...] \n"
+        "\nStores a Merkle root of the hashes of many user files, with their number, into a blockchain in one transaction.\n"
+        "Each document is a path to the file, or an object giving the hash of the file instead.\n"
+        "A transaction fee is computed as a (hash length)*(fee rate). \n"
+        "Before this command walletpassphrase is required. \n"
+
+        "\nArguments:\n"
+        "1. \"documents\"                   (array, required) The documents, each one either\n"
+        "     \"path\"                        (string) A path to the file\n"
+        "     or\n"
+        "     {\n"
+        "       \"document\": \"document\",     (string, required) A path to the file, or its hash if digest is set\n"
+        "       \"digest\": true|false        (boolean, optional, default=false) Whether document is a hex-encoded 32-byte hash of the file\n"
+        "     }\n"
+        "2. replaceable                     (boolean, optional) Allow this transaction to be replaced by a transaction with higher fees via BIP 125\n"
+        "3. conf_target                     (numeric, optional) Confirmation target (in blocks)\n"
+        "4. \"estimate_mode\"               (string, optional, default=UNSET) The fee estimate mode, must be one of:\n"
+        "       \"UNSET\"\n"
+        "       \"ECONOMICAL\"\n"
+        "       \"CONSERVATIVE\"\n"
+
+        "\nResult:\n"
+        "{\n"
+        "  \"txid\": \"txid\",               (string) A hex-encoded transaction id\n"
+        "  \"root\": \"hash\",               (string) The stored Merkle root\n"
+        "  \"count\": n,                   (numeric) The stored number of documents\n"
+        "  \"proofs\": [                    (array) One inclusion proof per document, in input order\n"
+        "    {\n"
+        "      \"document\": \"document\",   (string) The path or the digest as given\n"
+        "      \"hash\": \"hash\",           (string) The hash of the document\n"
+        "      \"index\": n,                (numeric) The position of the document in the tree\n"
+        "      \"branch\": [\"hash\",...]    (array) Sibling hashes from the document up to the root\n"
+        "    }\n"
+        "  ]\n"
+        "}\n"
+
+        "\nExamples:\n"
+        + HelpExampleCli("storesignatures", "\"[\\\"/home/myfile1.txt\\\",\\\"/home/myfile2.txt\\\"]\"")
+        + HelpExampleCli("storesignatures", "\"[\\\"/home/myfile1.txt\\\",{\\\"document\\\":\\\"hash\\\",\\\"digest\\\":true}]\"")
+        + HelpExampleRpc("storesignatures", "[\"/home/myfile1.txt\",\"/home/myfile2.txt\"]")
+    );
+
+    RPCTypeCheckArgument(request.params[0], UniValue::VARR);
+    const UniValue& documents=request.params[0].get_array();
+    if(documents.empty())
+    {
+        throw std::runtime_error("no documents given");
+    }
+
+    if(documents.size()>std::numeric_limits<uint32_t>::max())
+    {
+        throw std::runtime_error("too many documents given");
+    }
+
+    std::vector<std::string> names;
+    std::vector<uint256> hashes;
+    names.reserve(documents.size());
+    hashes.reserve(documents.size());
+    for(size_t i=0;i<documents.size();++i)
+    {
+        bool digest=false;
+        if(documents[i].isObject())
+        {
+            RPCTypeCheckObj(documents[i],
+                {
+                    {"document", UniValueType(UniValue::VSTR)},
+                    {"digest", UniValueType(UniValue::VBOOL)},
+                }, true, true);
+            names.push_back(find_value(documents[i], "document").get_str());
+            const UniValue& digestValue=find_value(documents[i], "digest");
+            digest=!digestValue.isNull() && digestValue.get_bool();
+        }
+        else
+        {
+            names.push_back(documents[i].get_str());
+        }
+        hashes.push_back(documentHash(names.back(), digest));
+    }
+    std::vector<std::vector<uint256>> branches;
+    const uint256 root=computeDocumentsRoot(hashes, &branches);
+
+    CCoinControl coin_control;
+    if (!request.params[1].isNull())
+    {
+        coin_control.m_signal_bip125_rbf = request.params[1].get_bool();
+    }
+
+    if (!request.params[2].isNull())
+    {
+        coin_control.m_confirm_target = ParseConfirmTarget(request.params[2]);
+    }
+
+    if (!request.params[3].isNull())
+    {
+        if (!FeeModeFromString(request.params[3].get_str(), coin_control.m_fee_mode)) {
+            throw std::runtime_error("Invalid estimate_mode parameter");
+        }
+    }
+    const UniValue txid=setOPreturnData(serializeDocumentsCommitment(root, hashes.size()), coin_control);
+
+    UniValue proofs(UniValue::VARR);
+    for(size_t i=0;i<hashes.size();++i)
+    {
+        UniValue branch(UniValue::VARR);
+        for(const uint256& sibling : branches[i])
+        {
+            branch.push_back(HexStr(sibling.begin(), sibling.end()));
+        }
+
+        UniValue proof(UniValue::VOBJ);
+        proof.pushKV("document", names[i]);
+        proof.pushKV("hash", HexStr(hashes[i].begin(), hashes[i].end()));
+        proof.pushKV("index", static_cast<uint64_t>(i));
+        proof.pushKV("branch", branch);
+        proofs.push_back(proof);
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("txid", txid);
+    result.pushKV("root", HexStr(root.begin(), root.end()));
+    result.pushKV("count", static_cast<uint64_t>(hashes.size()));
+    result.pushKV("proofs", proofs);
+    return result;
+}
+
 UniValue storedata(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() < 1 || request.params.size() > 4)
@@ -441,16 +605,15 @@ UniValue storedata(const JSONRPCRequest& request)
 
     std::string filePath=request.params[0].get_str();
 
-    std::vector<unsigned char> binaryData;
-
     FileReader<unsigned char> fileReader(filePath);
-    fileReader.read(binaryData);
-
-    if(binaryData.size()>maxDataSize)
+    if(fileReader.getSize()>maxDataSize)
     {
         throw std::runtime_error(strprintf("data size is grater than %d bytes", maxDataSize));
     }
 
+    std::vector<unsigned char> binaryData;
+    fileReader.read(binaryData);
+
     CCoinControl coin_control;
     if (!request.params[1].isNull())
     {
@@ -494,19 +657,16 @@ UniValue checkmessage(const JSONRPCRequest& request)
     );
 
     std::string txid=request.params[0].get_str();
-    std::vector<char> OPreturnData=getOPreturnData(txid);
-    if(!OPreturnData.empty())
+    const RetrieveDataTxs dataTx=retrieveDataTxs(txid);
+    const Span<const unsigned char> OPreturnData=dataTx.getTxData();
+    if(OPreturnData.size()>0)
     {
-        std::string blockchainHash=computeHash(OPreturnData.data(), OPreturnData.size());
+        const uint256 blockchainHash=computeHash(OPreturnData);
 
-        std::string  message=request.params[1].get_str();
-        std::string hexMsg=HexStr(message.begin(), message.end());
-        std::vector<char> messageBinaryData;
-        messageBinaryData.resize(hexMsg.length()/2);
-        hex2bin(messageBinaryData, hexMsg);
-        std::string messageHash=computeHash(messageBinaryData.data(), messageBinaryData.size());
+        const std::string& message=request.params[1].get_str();
+        const uint256 messageHash=computeHash(Span<const unsigned char>(reinterpret_cast<const unsigned char*>(message.data()), message.size()));
 
-        if(messageHash.compare(blockchainHash))
+        if(messageHash!=blockchainHash)
         {
             return UniValue(UniValue::VSTR, std::string("FAIL"));
         }
@@ -541,25 +701,21 @@ UniValue checkdata(const JSONRPCRequest& request)
 
 
     std::string txid=request.params[0].get_str();
-    std::vector<char> OPreturnData=getOPreturnData(txid);
+    const RetrieveDataTxs dataTx=retrieveDataTxs(txid);
+    const Span<const unsigned char> OPreturnData=dataTx.getTxData();
 
     if(!request.params[1].isNull())
     {
-        std::string blockchainHash=computeHash(OPreturnData.data(), OPreturnData.size());
+        const uint256 blockchainHash=computeHash(OPreturnData);
 
         std::string filePath=request.params[1].get_str();
-        std::vector<char> binaryData;
-
         FileReader<char> fileReader(filePath);
-        fileReader.read(binaryData);
-
-        if(binaryData.size()>maxDataSize)
+        if(fileReader.getSize()>maxDataSize)
         {
             throw std::runtime_error(strprintf("data size is grater than %d bytes", maxDataSize));
         }
 
-        std::string dataHash=computeHash(binaryData.data(), binaryData.size());
-        if(dataHash.compare(blockchainHash))
+        if(fileReader.hash()!=blockchainHash)
         {
             return UniValue(UniValue::VSTR, std::string("FAIL"));
         }
@@ -594,25 +750,21 @@ UniValue checksignature(const JSONRPCRequest& request)
 
 
     std::string txid=request.params[0].get_str();
-    std::vector<char> OPreturnData=getOPreturnData(txid);
-    std::string OPreturnDataStr=byte2str(reinterpret_cast<unsigned char*>(OPreturnData.data()), OPreturnData.size());
-    std::transform(OPreturnDataStr.begin(), OPreturnDataStr.end(), OPreturnDataStr.begin(), ::toupper);
+    const RetrieveDataTxs dataTx=retrieveDataTxs(txid);
+    const Span<const unsigned char> OPreturnData=dataTx.getTxData();
 
     if(!request.params[1].isNull())
     {
         std::string filePath=request.params[1].get_str();
-        std::vector<char> binaryData;
-
         FileReader<char> fileReader(filePath);
-        fileReader.read(binaryData);
-
-        if(binaryData.size()>maxDataSize)
+        if(fileReader.getSize()>maxDataSize)
         {
             throw std::runtime_error(strprintf("data size is grater than %d bytes", maxDataSize));
         }
 
-        std::string dataHash=computeHash(binaryData.data(), binaryData.size());
-        if(dataHash.compare(OPreturnDataStr))
+        //stored signature is the raw 32-byte digest of the file
+        const uint256 dataHash=fileReader.hash();
+        if(OPreturnData.size()!=static_cast<std::ptrdiff_t>(dataHash.size()) || !std::equal(dataHash.begin(), dataHash.end(), OPreturnData.begin()))
         {
             return UniValue(UniValue::VSTR, std::string("FAIL"));
         }
@@ -623,6 +775,239 @@ UniValue checksignature(const JSONRPCRequest& request)
     return UniValue(UniValue::VSTR, std::string("FAIL"));
 }
 
+UniValue checksignatureproof(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 4 || request.params.size() > 5)
+    throw std::runtime_error(
+        "checksignatureproof \"txid\" \"document\" index [\"hash\",...] ( digest )\n"
+        "\nChecks a document against a Merkle root stored by storesignatures.\n"
+
+        "\nArguments:\n"
+        "1. \"txid\"                        (string, required) A hex-encoded transaction id string\n"
+        "2. \"document\"                    (string, required) A path to the file, or its hash if digest is set\n"
+        "3. index                         (numeric, required) The position of the document returned by storesignatures\n"
+        "4. \"branch\"                      (array, required) The branch returned by storesignatures\n"
+        "5. digest                        (boolean, optional, default=false) Whether document is a hex-encoded 32-byte hash of the file\n"
+
+        "\nResult:\n"
+        "\"string\"                         (string) PASS or FAIL\n"
+
+
+        "\nExamples:\n"
+        + HelpExampleCli("checksignatureproof", "\"txid\" \"/home/myfile.txt\" 0 \"[\\\"hash\\\"]\"")
+        + HelpExampleCli("checksignatureproof", "\"txid\" \"hash\" 0 \"[\\\"hash\\\"]\" true")
+        + HelpExampleRpc("checksignatureproof", "\"txid\", \"/home/myfile.txt\", 0, [\"hash\"]")
+    );
+
+    RPCTypeCheck(request.params, {UniValue::VSTR, UniValue::VSTR, UniValue::VNUM, UniValue::VARR, UniValue::VBOOL});
+    const bool digest=!request.params[4].isNull() && request.params[4].get_bool();
+
+    const int index=request.params[2].get_int();
+    if(index<0)
+    {
+        throw std::runtime_error("index must be non-negative");
+    }
+
+    std::vector<uint256> branch;
+    const UniValue& branchArray=request.params[3].get_array();
+    for(size_t i=0;i<branchArray.size();++i)
+    {
+        const std::string& sibling=branchArray[i].get_str();
+        if(sibling.size()!=2*CSHA256::OUTPUT_SIZE || !IsHex(sibling))
+        {
+            throw std::runtime_error("branch must contain hex-encoded 32-byte hashes");
+        }
+        branch.push_back(uint256(ParseHex(sibling)));
+    }
+
+    const RetrieveDataTxs dataTx=retrieveDataTxs(request.params[0].get_str());
+    const Span<const unsigned char> OPreturnData=dataTx.getTxData();
+
+    uint256 storedRoot;
+    uint32_t count;
+    if(!parseDocumentsCommitment(OPreturnData, storedRoot, count))
+    {
+        return UniValue(UniValue::VSTR, std::string("FAIL"));
+    }
+
+    uint256 root;
+    if(!computeDocumentsRootFromBranch(documentHash(request.params[1].get_str(), digest), branch, index, count, root) || root!=storedRoot)
+    {
+        return UniValue(UniValue::VSTR, std::string("FAIL"));
+    }
+
+    return UniValue(UniValue::VSTR, std::string("PASS"));
+}
+
+UniValue finddata(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+    throw std::runtime_error(
+        "finddata \"hash\" \n"
+        "\nReturns the transactions storing data with a given hash. Requires -dataindex.\n"
+        "Data stored with storemessage or storedata is found by the double SHA256 of the stored bytes (the hash\n"
+        "storesignature, storesignatures and checkdata compute for a document),\n"
+        "a signature stored with storesignature by the stored hash itself and a batch stored with storesignatures by its Merkle root.\n"
+
+        "\nArguments:\n"
+        "1. \"hash\"                        (string, required) A hex-encoded 32-byte hash\n"
+
+        "\nResult:\n"
+        "[\n"
+        "  {\n"
+        "    \"txid\" : \"hash\",             (string) The transaction id\n"
+        "    \"height\" : n,                 (numeric) The height of the block containing the transaction\n"
+        "    \"blockhash\" : \"hash\",        (string) The hash of the block containing the transaction\n"
+        "    \"in_active_chain\" : b         (boolean) Whether the block is in the active chain\n"
+        "  }\n"
+        "  ,...\n"
+        "]\n"
+
+
+        "\nExamples:\n"
+        + HelpExampleCli("finddata", "\"hash\"")
+        + HelpExampleRpc("finddata", "\"hash\"")
+    );
+
+    const std::string& hashHex=request.params[0].get_str();
+    if(hashHex.size()!=2*CSHA256::OUTPUT_SIZE || !IsHex(hashHex))
+    {
+        throw std::runtime_error("hash must be a hex-encoded 32-byte hash");
+    }
+
+    if(!g_dataindex)
+    {
+        throw std::runtime_error("finddata requires -dataindex");
+    }
+    g_dataindex->BlockUntilSyncedToCurrentChain();
+
+    std::vector<DataCommitment> commitments;
+    if(!g_dataindex->FindData(uint256(ParseHex(hashHex)), commitments))
+    {
+        throw std::runtime_error("data index read failed");
+    }
+
+    UniValue result(UniValue::VARR);
+    LOCK(cs_main);
+    for(const DataCommitment& commitment : commitments)
+    {
+        const CBlockIndex* pindex=chainActive[commitment.height];
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("txid", commitment.txid.GetHex());
+        entry.pushKV("height", commitment.height);
+        entry.pushKV("blockhash", commitment.block_hash.GetHex());
+        entry.pushKV("in_active_chain", pindex!=nullptr && pindex->GetBlockHash()==commitment.block_hash);
+        result.push_back(entry);
+    }
+
+    return result;
+}
+
+//cursor of listunspentpage, the outpoint the next page starts after
+static std::string encodeUnspentCursor(const COutPoint& last)
+{
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << last;
+    return HexStr(ss.begin(), ss.end());
+}
+
+static COutPoint decodeUnspentCursor(const std::string& cursor)
+{
+    COutPoint last;
+    if(!IsHex(cursor) || cursor.size()!=2*(sizeof(uint256)+sizeof(uint32_t)))
+    {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+    }
+    const std::vector<unsigned char> data(ParseHex(cursor));
+    CDataStream ss(data, SER_NETWORK, PROTOCOL_VERSION);
+    ss >> last;
+    return last;
+}
+
+UniValue listunspentpage(const JSONRPCRequest& request)
+{
+    std::shared_ptr<CWallet> const wallet = GetWalletForJSONRPCRequest(request);
+    if (!EnsureWalletIsAvailable(wallet.get(), request.fHelp)) {
+        return NullUniValue;
+    }
+
+    if (request.fHelp || request.params.size() > 5)
+    throw std::runtime_error(
+        "listunspentpage ( \"cursor\" count [\"address\",...] minconf maxconf )\n"
+        "\nReturns a page of the unspent outputs of the wallet, so that large wallets can be listed a few outputs at a time.\n"
+        "Pass the returned cursor to get the next page. Outputs are listed by txid and vout, so outputs spent or\n"
+        "confirmed between the calls do not move the following pages; outputs received meanwhile may be left out.\n"
+
+        "\nArguments:\n"
+        "1. \"cursor\"                      (string, optional, default=\"\") The cursor returned with the previous page, \"\" for the first page\n"
+        "2. count                         (numeric, optional, default=100) The maximum number of outputs of the page\n"
+        "3. [\"address\",...]               (array, optional) Only list outputs paying to one of these addresses\n"
+        "4. minconf                       (numeric, optional, default=1) The minimum confirmations to filter\n"
+        "5. maxconf                       (numeric, optional, default=9999999) The maximum confirmations to filter\n"
+
+        "\nResult:\n"
+        "{\n"
+        "  \"unspents\" : [                 (array) The outputs of the page, as returned by listunspent\n"
+        "    {\n"
+        "      \"txid\" : \"txid\",          (string) the transaction id\n"
+        "      \"vout\" : n,                 (numeric) the vout value\n"
+        "      \"address\" : \"address\",    (string) the address\n"
+        "      \"scriptPubKey\" : \"key\",   (string) the script key\n"
+        "      \"amount\" : x.xxx,           (numeric) the transaction output amount\n"
+        "      \"confirmations\" : n,        (numeric) The number of confirmations\n"
+        "      ...\n"
+        "    }\n"
+        "    ,...\n"
+        "  ],\n"
+        "  \"cursor\" : \"cursor\"          (string) The cursor of the next page, \"\" once all outputs are listed\n"
+        "}\n"
+
+
+        "\nExamples:\n"
+        + HelpExampleCli("listunspentpage", "")
+        + HelpExampleCli("listunspentpage", "\"cursor\" 100")
+        + HelpExampleRpc("listunspentpage", "\"cursor\", 100")
+    );
+
+    const bool first=request.params[0].isNull() || request.params[0].get_str().empty();
+    const COutPoint after=first ? COutPoint() : decodeUnspentCursor(request.params[0].get_str());
+    const int64_t count=request.params[1].isNull() ? 100 : request.params[1].get_int64();
+    if(count<=0)
+    {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "count must be positive");
+    }
+
+    std::vector<std::string> addresses;
+    if(!request.params[2].isNull())
+    {
+        const UniValue& inputs=request.params[2].get_array();
+        for(size_t i=0;i<inputs.size();++i)
+        {
+            addresses.push_back(inputs[i].get_str());
+        }
+    }
+    const int nMinDepth=request.params[3].isNull() ? 1 : request.params[3].get_int();
+    const int nMaxDepth=request.params[4].isNull() ? 9999999 : request.params[4].get_int();
+
+    COutPoint last;
+    UniValue page;
+    try
+    {
+        page=getUnspentPage(wallet.get(), addresses, nMinDepth, nMaxDepth, first ? nullptr : &after, count, last);
+    }
+    catch(const std::runtime_error& e)
+    {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, e.what());
+    }
+
+    //a short page is the last one
+    const bool complete=page.size()<static_cast<size_t>(count);
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("unspents", page);
+    result.pushKV("cursor", complete ? std::string() : encodeUnspentCursor(last));
+    return result;
+}
+
 static const CRPCCommand commands[] =
 { //  category              name                            actor (function)            argNames
   //  --------------------- ------------------------        -----------------------     ----------
@@ -630,10 +1015,13 @@ static const CRPCCommand commands[] =
     { "blockstamp",         "retrievemessage",             	&retrievemessage,          {"txid"} },
     { "blockstamp",         "retrievedata",             	&retrievedata,             {"txid"} },
     { "blockstamp",         "storesignature",             	&storesignature,           {"file_path", "replaceable", "conf_target", "estimate_mode"} },
+    { "blockstamp",         "storesignatures",             	&storesignatures,          {"documents", "replaceable", "conf_target", "estimate_mode"} },
     { "blockstamp",         "storedata",             		&storedata,          	   {"file_path", "replaceable", "conf_target", "estimate_mode"} },
     { "blockstamp",         "checkmessage",             	&checkmessage,             {"txid", "message"} },
     { "blockstamp",         "checkdata",             		&checkdata,          	   {"txid", "file_path"} },
     { "blockstamp",         "checksignature",             	&checksignature,           {"txid", "file_path"} },
+    { "blockstamp",         "checksignatureproof",         	&checksignatureproof,      {"txid", "document", "index", "branch", "digest"} },
+    { "blockstamp",         "finddata",                 	&finddata,                 {"hash"} },
 };
 
 void RegisterDataRPCCommands(CRPCTable &t)
@@ -6,17 +6,22 @@
 #include <rpc/server.h>
 #include <rpc/client.h>
 #include <consensus/validation.h>
+#include <core_io.h>
 #include <validation.h>
 #include <policy/policy.h>
+#include <policy/rbf.h>
 #include <utilstrencodings.h>
 #include <stdint.h>
 #include <amount.h>
 #include <chainparams.h>
+#include <key_io.h>
 #include <net.h>
 #include <rpc/mining.h>
 #include <utilmoneystr.h>
 #include <wallet/coincontrol.h>
 #include <wallet/fees.h>
+#include <wallet/gamepool.h>
+#include <wallet/wallet.h>
 
 #include <univalue.h>
 #include <boost/algorithm/string.hpp>
@@ -29,6 +34,10 @@
 #include <games/gamesutils.h>
 #include <games/modulo/moduloutils.h>
 #include <games/modulo/moduloverify.h>
+#include <games/modulo/modulobettracker.h>
+#include <games/modulo/modulosimulation.h>
+#include <txmempool.h>
+#include <validationinterface.h>
 
 using namespace modulo;
 
@@ -55,6 +64,203 @@ static UniValue callRPC(std::string args)
     }
 }
 
+//maximum number of bets created by one makebets call
+static const size_t MAX_MAKEBETS_BATCH = 1000;
+
+//parses a bet pattern along with its optional range into the op-return recipient of a makebet
+static CRecipient createMakeBetRecipient(std::string betTypePattern, const UniValue& rangeParam)
+{
+    std::vector<CAmount> betAmounts;
+    std::vector<std::string> betTypes;
+
+    bool isRoulette=true;
+    int range=36;//by default roulette range
+    if(!rangeParam.isNull())
+    {
+        range=rangeParam.get_int();
+        if (range <= 1) {
+            throw std::runtime_error(std::string("Range must be greater than 1"));
+        }
+        isRoulette=false;
+    }
+
+    parseBetType(betTypePattern, range, betAmounts, betTypes, isRoulette);
+    const CAmount betSum = betAmountsSum(betAmounts);
+
+    std::string arg=int2hex(range)+std::string("_");
+    std::string msg=HexStr(arg.begin(), arg.end());
+    const std::string plus_msg("+");
+    const std::string at_msg("@");
+
+    for(size_t i=0;i<betTypes.size();++i)
+    {
+        msg+=HexStr(betTypes[i].begin(), betTypes[i].end());
+        std::string amountStr = at_msg + std::to_string(betAmounts[i]);
+        msg+=HexStr(amountStr.begin(), amountStr.end());
+        if(i<betTypes.size()-1)
+        {
+            msg+=HexStr(plus_msg.begin(), plus_msg.end());
+        }
+    }
+
+    return createMakeBetDestination(betSum, msg);
+}
+
+//reads the replaceable, conf_target and estimate_mode arguments starting at params[idx]
+static CCoinControl parseMakeBetCoinControl(const UniValue& params, size_t idx)
+{
+    CCoinControl coin_control;
+    if (!params[idx].isNull())
+    {
+        coin_control.m_signal_bip125_rbf = params[idx].get_bool();
+    }
+
+    if (!params[idx+1].isNull())
+    {
+        coin_control.m_confirm_target = ParseConfirmTarget(params[idx+1]);
+    }
+
+    if (!params[idx+2].isNull())
+    {
+        if (!FeeModeFromString(params[idx+2].get_str(), coin_control.m_fee_mode)) {
+            throw std::runtime_error("Invalid estimate_mode parameter");
+        }
+    }
+    return coin_control;
+}
+
+//checks the potential reward of a signed makebet and commits it, returning its output to pool (if it came from one) on failure
+static void commitMakeBet(CWallet* const pwallet, const CTransactionRef& tx, CReserveKey& reservekey, CGamePool* pool)
+{
+    CAmount rewardSum{}, betsSum{};
+    if (!modulo::ver_2::checkBetsPotentialReward(rewardSum, betsSum, *tx))
+    {
+        if (pool)
+        {
+            pool->ReturnTransaction(*tx);
+        }
+        throw std::runtime_error("checkBetsPotentialReward failed with reason: potential reward or sum of bets over limit");
+    }
+
+    CValidationState state;
+    if(!pwallet->CommitTransaction(tx, {}, {}, reservekey, g_connman.get(), state))
+    {
+        if (pool)
+        {
+            pool->ReturnTransaction(*tx);
+        }
+        throw std::runtime_error(std::string("CommitTransaction failed with reason: ")+FormatStateMessage(state));
+    }
+}
+
+//creates and commits a makebet funded by the -gamepool or by coin selection
+static CTransactionRef makeBet(CWallet* const pwallet, const CRecipient& recipient, const CCoinControl& coin_control)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(pwallet->cs_wallet);
+
+    CReserveKey reservekey(pwallet);
+    CAmount nFeeRequired;
+    int nChangePosInOut=1;
+    std::string strFailReason;
+    CTransactionRef tx;
+
+    //spend a pre-split output of the -gamepool if there is one, otherwise run coin selection
+    const std::shared_ptr<CGamePool> pool = GetGamePool(pwallet);
+    const bool fromPool = pool && pool->CreateTransaction({recipient}, MAKE_MODULO_NEW_GAME_INDICATOR | CTransaction::CURRENT_VERSION,
+                                                          tx, reservekey, coin_control, strFailReason);
+    if(!fromPool && !pwallet->CreateTransaction({recipient}, nullptr, tx, reservekey, nFeeRequired, nChangePosInOut, strFailReason, coin_control, true, true))
+    {
+        if (nFeeRequired > pwallet->GetBalance())
+        {
+            strFailReason = strprintf("Error: This transaction requires a transaction fee of at least %s", FormatMoney(nFeeRequired));
+        }        
+        throw std::runtime_error(std::string("CreateTransaction failed with reason: ")+strFailReason);
+    }
+
+    commitMakeBet(pwallet, tx, reservekey, fromPool ? pool.get() : nullptr);
+    return tx;
+}
+
+static bool isLargerOutput(const COutput& a, const COutput& b)
+{
+    return a.tx->tx->vout[a.i].nValue > b.tx->tx->vout[b.i].nValue;
+}
+
+//creates and commits a makebet funded by outputs of a player's address, so that the payoff goes to the player's key;
+//the change goes back to the same address; the spent outputs are removed from playerOutputs and the change is added to it;
+//change below the dust limit is added to the fee and returned in nDustChange
+static CTransactionRef makePlayerBet(CWallet* const pwallet, const CRecipient& recipient, const CScript& playerScript,
+                                     std::vector<COutput>& playerOutputs, const CCoinControl& coin_control, CAmount& nDustChange)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(pwallet->cs_wallet);
+
+    CMutableTransaction txNew;
+    txNew.nVersion=(MAKE_MODULO_NEW_GAME_INDICATOR | CTransaction::CURRENT_VERSION);
+    txNew.nLockTime=chainActive.Height();
+    txNew.vout.emplace_back(recipient.nAmount, recipient.scriptPubKey);
+    txNew.vout.emplace_back(0, playerScript);
+
+    const uint32_t nSequence = coin_control.m_signal_bip125_rbf.get_value_or(pwallet->m_signal_rbf) ? MAX_BIP125_RBF_SEQUENCE : (CTxIn::SEQUENCE_FINAL - 1);
+    const CFeeRate feeRate = GetMinimumFeeRate(*pwallet, coin_control, ::mempool, ::feeEstimator, nullptr);
+
+    //the largest outputs first, keeping the transaction small
+    CAmount nValueIn=0;
+    CAmount nFee=0;
+    size_t nInputs=0;
+    for(; nInputs<playerOutputs.size(); ++nInputs)
+    {
+        const COutput& out=playerOutputs[nInputs];
+        txNew.vin.emplace_back(COutPoint(out.tx->GetHash(), out.i), CScript(), nSequence);
+        nValueIn+=out.tx->tx->vout[out.i].nValue;
+
+        const int64_t nBytes=CalculateMaximumSignedTxSize(CTransaction(txNew), pwallet);
+        if(nBytes<0)
+        {
+            throw std::runtime_error("Player address can not be signed for");
+        }
+        nFee=feeRate.GetFee(nBytes);
+        if(nValueIn>=recipient.nAmount+nFee)
+        {
+            ++nInputs;
+            break;
+        }
+    }
+    if(nValueIn<recipient.nAmount+nFee)
+    {
+        throw std::runtime_error("Insufficient funds of the player address");
+    }
+
+    //dust change goes to the fee
+    txNew.vout[1].nValue=nValueIn-recipient.nAmount-nFee;
+    nDustChange=0;
+    if(IsDust(txNew.vout[1], ::dustRelayFee))
+    {
+        nDustChange=txNew.vout[1].nValue;
+        txNew.vout.pop_back();
+    }
+
+    if(!pwallet->SignTransaction(txNew))
+    {
+        throw std::runtime_error("Signing transaction failed");
+    }
+    CTransactionRef tx=MakeTransactionRef(std::move(txNew));
+
+    CReserveKey reservekey(pwallet);
+    commitMakeBet(pwallet, tx, reservekey, nullptr);
+    playerOutputs.erase(playerOutputs.begin(), playerOutputs.begin()+nInputs);
+
+    //further bets of the player spend the unconfirmed change, keeping the largest outputs first
+    const CWalletTx* wtx=pwallet->GetWalletTx(tx->GetHash());
+    if(wtx!=nullptr && tx->vout.size()>1)
+    {
+        const COutput change(wtx, 1, 0, true, true, true);
+        playerOutputs.insert(std::upper_bound(playerOutputs.begin(), playerOutputs.end(), change, isLargerOutput), change);
+    }
+    return tx;
+}
+
 UniValue makebet(const JSONRPCRequest& request)
 {
 	if (request.fHelp || request.params.size() < 1 || request.params.size() > 5)
@@ -88,94 +294,520 @@ UniValue makebet(const JSONRPCRequest& request)
         throw std::runtime_error(std::string("No wallet found"));
     }
     CWallet* const pwallet=wallet.get();
-    std::vector<CAmount> betAmounts;
-    std::vector<std::string> betTypes;
 
-    std::string betTypePattern=request.params[0].get_str();
+    const CRecipient recipient = createMakeBetRecipient(request.params[0].get_str(), request.params[1]);
+    const CCoinControl coin_control = parseMakeBetCoinControl(request.params, 2);
 
-    bool isRoulette=true;
-    int range=36;//by default roulette range
-    if(!request.params[1].isNull())
+    LOCK2(cs_main, pwallet->cs_wallet);
+    EnsureWalletIsUnlocked(pwallet);
+
+    const CTransactionRef tx = makeBet(pwallet, recipient, coin_control);
+    std::string txid=tx->GetHash().GetHex();
+    return UniValue(UniValue::VSTR, txid);
+}
+
+UniValue makebets(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 4)
+    throw std::runtime_error(
+        "makebets [{\"type_of_bet\":\"bet\",\"range\":n,\"address\":\"address\"},...] ( replaceable conf_target \"estimate_mode\" )\n"
+        "\nCreates a batch of bet transactions under a single wallet lock.\n"
+        "All bets are validated before any transaction is created. A bet funded from a player address pays\n"
+        "its payoff to the key of that address; other bets are funded like in makebet.\n"
+        "The bets of a player address spend the unconfirmed change of the previous one, so there can be at most\n"
+        "-limitancestorcount (default: " + std::to_string(DEFAULT_ANCESTOR_LIMIT) + ") of them in a batch.\n"
+        "Before this command walletpassphrase is required. \n"
+
+        "\nArguments:\n"
+        "1. \"bets\"                        (array, required) The bets, at most " + std::to_string(MAX_MAKEBETS_BATCH) + "\n"
+        "     [\n"
+        "       {\n"
+        "         \"type_of_bet\": \"bet\",       (string, required) The bet types and amounts like for makebet\n"
+        "         \"range\": n,               (numeric, optional) The range of numbers <1, range> to be drawn, default 36 meaning a roulette\n"
+        "         \"address\": \"address\"      (string, optional) A wallet address of the player funding the bet and receiving its payoff\n"
+        "       }\n"
+        "       ,...\n"
+        "     ]\n"
+        "2. replaceable                     (boolean, optional) Allow the transactions to be replaced by transactions with higher fees via BIP 125\n"
+        "3. conf_target                     (numeric, optional) Confirmation target (in blocks)\n"
+        "4. \"estimate_mode\"               (string, optional, default=UNSET) The fee estimate mode, must be one of:\n"
+        "       \"UNSET\"\n"
+        "       \"ECONOMICAL\"\n"
+        "       \"CONSERVATIVE\"\n"
+
+        "\nResult:\n"
+        "[                                (array) One entry per bet, in order\n"
+        "  {\n"
+        "    \"txid\" : \"txid\",             (string) The makebet transaction id, if it was created\n"
+        "    \"dust_change\" : x.xxx,       (numeric, optional) Change of a player bet below the dust limit, added to the fee\n"
+        "    \"error\" : \"message\"          (string) The reason the bet could not be created otherwise\n"
+        "  }\n"
+        "  ,...\n"
+        "]\n"
+
+
+        "\nExamples:\n"
+        + HelpExampleCli("makebets", "\"[{\\\"type_of_bet\\\":\\\"red@1\\\"},{\\\"type_of_bet\\\":\\\"3@2\\\",\\\"range\\\":4}]\"")
+        + HelpExampleRpc("makebets", "[{\"type_of_bet\":\"red@1\"},{\"type_of_bet\":\"3@2\",\"range\":4}]")
+    );
+
+    RPCTypeCheck(request.params, {UniValue::VARR});
+
+    std::shared_ptr<CWallet> wallet = GetWallets()[0];
+    if(wallet==nullptr)
     {
-        range=request.params[1].get_int();
-        if (range <= 1) {
-            throw std::runtime_error(std::string("Range must be greater than 1"));
-        }
-        isRoulette=false;
+        throw std::runtime_error(std::string("No wallet found"));
     }
+    CWallet* const pwallet=wallet.get();
 
-    parseBetType(betTypePattern, range, betAmounts, betTypes, isRoulette);
-    const CAmount betSum = betAmountsSum(betAmounts);
+    const UniValue& bets = request.params[0].get_array();
+    if(bets.empty())
+    {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "No bets given");
+    }
+    if(bets.size() > MAX_MAKEBETS_BATCH)
+    {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Too many bets (max: %u)", MAX_MAKEBETS_BATCH));
+    }
 
-    CCoinControl coin_control;
-    if (!request.params[2].isNull())
+    //validate all bets before creating any transaction
+    std::vector<CRecipient> recipients;
+    std::vector<CScript> playerScripts;
+    std::map<CScript, std::string> playerAddresses;
+    std::map<CScript, size_t> playerBets;
+    const size_t nAncestorLimit = gArgs.GetArg("-limitancestorcount", DEFAULT_ANCESTOR_LIMIT);
+    for(size_t i=0;i<bets.size();++i)
     {
-        coin_control.m_signal_bip125_rbf = request.params[3].get_bool();
+        const UniValue& bet = bets[i].get_obj();
+        RPCTypeCheckObj(bet,
+            {
+                {"type_of_bet", UniValueType(UniValue::VSTR)},
+                {"range", UniValueType(UniValue::VNUM)},
+                {"address", UniValueType(UniValue::VSTR)},
+            }, true, true);
+        if(!bet.exists("type_of_bet"))
+        {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Bet %u: missing type_of_bet", i));
+        }
+
+        try {
+            recipients.push_back(createMakeBetRecipient(find_value(bet, "type_of_bet").get_str(), find_value(bet, "range")));
+        }
+        catch (const std::exception& e) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Bet %u: %s", i, e.what()));
+        }
+
+        CScript playerScript;
+        if(bet.exists("address"))
+        {
+            const CTxDestination dest=DecodeDestination(find_value(bet, "address").get_str());
+            if(!IsValidDestination(dest))
+            {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, strprintf("Bet %u: invalid address", i));
+            }
+            playerScript=GetScriptForDestination(dest);
+            playerAddresses.emplace(playerScript, find_value(bet, "address").get_str());
+            //each bet of a player spends the unconfirmed change of the previous one, a longer chain is not accepted to the mempool
+            if(++playerBets[playerScript] > nAncestorLimit)
+            {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Bet %u: more than %u bets of player address %s", i, nAncestorLimit, playerAddresses[playerScript]));
+            }
+        }
+        playerScripts.push_back(playerScript);
     }
 
-    if (!request.params[3].isNull())
+    const CCoinControl coin_control = parseMakeBetCoinControl(request.params, 1);
+
+    pwallet->BlockUntilSyncedToCurrentChain();
+
+    LOCK2(cs_main, pwallet->cs_wallet);
+    EnsureWalletIsUnlocked(pwallet);
+
+    //outputs of the player addresses, from a single pass over the wallet
+    std::map<CScript, std::vector<COutput>> playerOutputs;
+    for(const auto& player : playerAddresses)
+    {
+        if(!(IsMine(*pwallet, player.first) & ISMINE_SPENDABLE))
+        {
+            throw JSONRPCError(RPC_WALLET_ERROR, "Player address is not spendable by the wallet: "+player.second);
+        }
+        playerOutputs[player.first];
+    }
+    if(!playerOutputs.empty())
     {
-        coin_control.m_confirm_target = ParseConfirmTarget(request.params[4]);
+        std::vector<COutput> outputs;
+        pwallet->AvailableCoins(outputs, true, &coin_control);
+        for(const COutput& out : outputs)
+        {
+            const auto it=playerOutputs.find(out.tx->tx->vout[out.i].scriptPubKey);
+            if(out.fSpendable && it!=playerOutputs.end())
+            {
+                it->second.push_back(out);
+            }
+        }
+        for(auto& entry : playerOutputs)
+        {
+            std::sort(entry.second.begin(), entry.second.end(), isLargerOutput);
+        }
     }
 
-    if (!request.params[4].isNull())
+    UniValue result(UniValue::VARR);
+    for(size_t i=0;i<recipients.size();++i)
     {
-        if (!FeeModeFromString(request.params[4].get_str(), coin_control.m_fee_mode)) {
-            throw std::runtime_error("Invalid estimate_mode parameter");
+        UniValue entry(UniValue::VOBJ);
+        try {
+            CAmount nDustChange=0;
+            const CTransactionRef tx = playerScripts[i].empty()
+                ? makeBet(pwallet, recipients[i], coin_control)
+                : makePlayerBet(pwallet, recipients[i], playerScripts[i], playerOutputs[playerScripts[i]], coin_control, nDustChange);
+            entry.pushKV("txid", tx->GetHash().GetHex());
+            if(nDustChange>0)
+            {
+                entry.pushKV("dust_change", ValueFromAmount(nDustChange));
+            }
+        }
+        catch (const std::exception& e) {
+            entry.pushKV("error", e.what());
         }
+        result.push_back(entry);
     }
+    return result;
+}
 
-    std::string arg=int2hex(range)+std::string("_");
-    std::string msg=HexStr(arg.begin(), arg.end());
-    const std::string plus_msg("+");
-    const std::string at_msg("@");
+static UniValue betStatusToJSON(const uint256& makeBetHash, const modulo::ver_2::BetStatus& status)
+{
+    UniValue entry(UniValue::VOBJ);
+    entry.pushKV("txid", makeBetHash.GetHex());
+    entry.pushKV("status", status.getStateName());
+    entry.pushKV("blockhash", status.blockHash.GetHex());
+    entry.pushKV("height", status.height);
+    entry.pushKV("amount", ValueFromAmount(status.amount));
+    entry.pushKV("payoff", ValueFromAmount(status.payoff));
+    if(!status.keyID.IsNull())
+    {
+        entry.pushKV("address", EncodeDestination(status.keyID));
+    }
+    if(!status.getbetHash.IsNull())
+    {
+        entry.pushKV("getbet", status.getbetHash.GetHex());
+    }
+    return entry;
+}
 
-    for(size_t i=0;i<betTypes.size();++i)
+UniValue getbetstatus(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+    throw std::runtime_error(
+        "getbetstatus \"txid\"\n"
+        "\nReturns the settlement status of a makebet transaction. Requires -bettracker.\n"
+
+        "\nArguments:\n"
+        "1. \"txid\"                        (string, required) A hex-encoded makebet transaction id\n"
+
+        "\nResult:\n"
+        "{\n"
+        "  \"txid\" : \"hash\",               (string) The makebet transaction id\n"
+        "  \"status\" : \"string\",           (string) pending, lost, won (payoff not paid yet) or paid\n"
+        "  \"blockhash\" : \"hash\",          (string) The block drawing the result\n"
+        "  \"height\" : n,                  (numeric) The height of that block\n"
+        "  \"amount\" : x.xxx,              (numeric) The sum of the bets\n"
+        "  \"payoff\" : x.xxx,              (numeric) The amount won\n"
+        "  \"address\" : \"address\",         (string) The address the payoff goes to\n"
+        "  \"getbet\" : \"hash\"              (string, optional) The getbet transaction paying the payoff\n"
+        "}\n"
+
+
+        "\nExamples:\n"
+        + HelpExampleCli("getbetstatus", "\"txid\"")
+        + HelpExampleRpc("getbetstatus", "\"txid\"")
+    );
+
+    if(!modulo::ver_2::g_betTracker)
     {
-        msg+=HexStr(betTypes[i].begin(), betTypes[i].end());
-        std::string amountStr = at_msg + std::to_string(betAmounts[i]);
-        msg+=HexStr(amountStr.begin(), amountStr.end());
-        if(i<betTypes.size()-1)
+        throw std::runtime_error("getbetstatus requires -bettracker");
+    }
+
+    //a tracker catching up from an earlier block would report settled bets as unknown
+    if(!modulo::ver_2::g_betTracker->BlockUntilSyncedToCurrentChain())
+    {
+        throw JSONRPCError(RPC_IN_WARMUP, "Bet tracker is still catching up with the chain");
+    }
+
+    const uint256 makeBetHash=ParseHashV(request.params[0], "txid");
+    modulo::ver_2::BetStatus status;
+    if(modulo::ver_2::g_betTracker->getBetStatus(makeBetHash, status))
+    {
+        return betStatusToJSON(makeBetHash, status);
+    }
+
+    if(mempool.exists(makeBetHash))
+    {
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("txid", makeBetHash.GetHex());
+        entry.pushKV("status", "pending");
+        return entry;
+    }
+
+    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No makebet with this txid is known");
+}
+
+UniValue listbets(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 3)
+    throw std::runtime_error(
+        "listbets ( \"address\" count skip )\n"
+        "\nReturns settled makebets, of one address or of all addresses. Requires -bettracker.\n"
+
+        "\nArguments:\n"
+        "1. \"address\"                     (string, optional) Only list bets paid out to this address, \"\" for all addresses\n"
+        "2. count                         (numeric, optional, default=10) The number of bets to return\n"
+        "3. skip                          (numeric, optional, default=0) The number of bets to skip\n"
+
+        "\nResult:\n"
+        "[                                (array) Bets in getbetstatus format\n"
+        "  ...\n"
+        "]\n"
+
+
+        "\nExamples:\n"
+        + HelpExampleCli("listbets", "\"address\" 20")
+        + HelpExampleRpc("listbets", "\"address\", 20")
+    );
+
+    if(!modulo::ver_2::g_betTracker)
+    {
+        throw std::runtime_error("listbets requires -bettracker");
+    }
+
+    //see getbetstatus
+    if(!modulo::ver_2::g_betTracker->BlockUntilSyncedToCurrentChain())
+    {
+        throw JSONRPCError(RPC_IN_WARMUP, "Bet tracker is still catching up with the chain");
+    }
+
+    CKeyID keyID;
+    if(!request.params[0].isNull() && !request.params[0].get_str().empty())
+    {
+        const CTxDestination dest=DecodeDestination(request.params[0].get_str());
+        const CKeyID* destKeyID=boost::get<CKeyID>(&dest);
+        if(destKeyID==nullptr)
         {
-            msg+=HexStr(plus_msg.begin(), plus_msg.end());
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid key address");
         }
+        keyID=*destKeyID;
     }
-    
-    const CRecipient recipient = createMakeBetDestination(betSum, msg);
-    LOCK2(cs_main, pwallet->cs_wallet);
 
-    CAmount curBalance = pwallet->GetBalance();
-    CReserveKey reservekey(pwallet);
-    CAmount nFeeRequired;
-    int nChangePosInOut=1;
-    std::string strFailReason;
-    CTransactionRef tx;
+    int count=10;
+    if(!request.params[1].isNull())
+    {
+        count=request.params[1].get_int();
+    }
+    int skip=0;
+    if(!request.params[2].isNull())
+    {
+        skip=request.params[2].get_int();
+    }
+    if(count<0 || skip<0)
+    {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Negative count or skip");
+    }
 
-    EnsureWalletIsUnlocked(pwallet);
+    UniValue result(UniValue::VARR);
+    for(const auto& bet : modulo::ver_2::g_betTracker->listBets(keyID, count, skip))
+    {
+        result.push_back(betStatusToJSON(bet.first, bet.second));
+    }
+    return result;
+}
 
-    if(!pwallet->CreateTransaction({recipient}, nullptr, tx, reservekey, nFeeRequired, nChangePosInOut, strFailReason, coin_control, true, true))
+static UniValue payoutDistributionToJSON(const modulo::ver_2::PayoutDistribution& distribution, bool verbose)
+{
+    UniValue entry(UniValue::VOBJ);
+    entry.pushKV("argument", (int64_t)distribution.argument);
+    entry.pushKV("bets", (int64_t)distribution.bets);
+    entry.pushKV("betsum", ValueFromAmount(distribution.betsSum));
+    entry.pushKV("maxpayout", ValueFromAmount(distribution.getMaxPayout()));
+    entry.pushKV("expectedpayout", ValueFromAmount(distribution.getExpectedPayout()));
+    entry.pushKV("winningoutcomes", (int64_t)distribution.payouts.size());
+
+    UniValue histogram(UniValue::VARR);
+    for(const auto& payout : distribution.getHistogram())
+    {
+        UniValue bucket(UniValue::VOBJ);
+        bucket.pushKV("payout", ValueFromAmount(payout.first));
+        bucket.pushKV("outcomes", (int64_t)payout.second);
+        histogram.push_back(bucket);
+    }
+    entry.pushKV("distribution", histogram);
+
+    if(verbose)
     {
-        if (nFeeRequired > curBalance)
+        UniValue payouts(UniValue::VOBJ);
+        for(const auto& payout : distribution.payouts)
         {
-            strFailReason = strprintf("Error: This transaction requires a transaction fee of at least %s", FormatMoney(nFeeRequired));
-        }        
-        throw std::runtime_error(std::string("CreateTransaction failed with reason: ")+strFailReason);
+            payouts.pushKV(std::to_string(payout.first), ValueFromAmount(payout.second));
+        }
+        entry.pushKV("payouts", payouts);
     }
+    return entry;
+}
 
-    CAmount rewardSum{}, betsSum{};
-    if (!modulo::ver_2::checkBetsPotentialReward(rewardSum, betsSum, *tx))
+UniValue simulatebets(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 3)
+    throw std::runtime_error(
+        "simulatebets ( \"blockhash\" [\"hexstring\",...] verbose )\n"
+        "\nComputes the payouts of a set of makebets for every outcome of their modulo argument, i.e. over all block hashes.\n"
+        "The makebets of the mempool are simulated by default, those of a block if blockhash is given, or the given transactions.\n"
+        "Invalid makebets of the mempool or of a block are skipped, invalid given transactions are an error.\n"
+        "At most 10000 makebets are simulated, further makebets of the mempool or of a block are counted as truncated.\n"
+        "Outcomes of different arguments are drawn from the same block hash, so the totals sum the expected payouts\n"
+        "and give the sum of the maximum payouts as an upper bound of the payout.\n"
+
+        "\nArguments:\n"
+        "1. \"blockhash\"                   (string, optional) Simulate the makebets of this block, \"\" for the mempool\n"
+        "2. [\"hexstring\",...]             (array, optional) Simulate these hex-encoded makebet transactions instead\n"
+        "3. verbose                       (boolean, optional, default=false) Also return the payout of each winning outcome\n"
+
+        "\nResult:\n"
+        "{\n"
+        "  \"bets\" : n,                    (numeric) The number of makebets simulated\n"
+        "  \"skipped\" : n,                 (numeric) The number of invalid makebets skipped\n"
+        "  \"truncated\" : n,               (numeric) The number of makebets left out beyond the limit of simulated makebets\n"
+        "  \"betsum\" : x.xxx,              (numeric) The sum of all bets\n"
+        "  \"maxpayout\" : x.xxx,           (numeric) The sum of the maximum payouts of all arguments\n"
+        "  \"expectedpayout\" : x.xxx,      (numeric) The sum of the expected payouts of all arguments\n"
+        "  \"arguments\" : [                (array) The payout distribution of each modulo argument\n"
+        "    {\n"
+        "      \"argument\" : n,            (numeric) The modulo argument, outcomes are 1..argument\n"
+        "      \"bets\" : n,                (numeric) The number of bets of the argument\n"
+        "      \"betsum\" : x.xxx,          (numeric) The sum of these bets\n"
+        "      \"maxpayout\" : x.xxx,       (numeric) The highest payout of an outcome\n"
+        "      \"expectedpayout\" : x.xxx,  (numeric) The payout averaged over all outcomes\n"
+        "      \"winningoutcomes\" : n,     (numeric) The number of outcomes paying anything\n"
+        "      \"distribution\" : [         (array) The number of outcomes of each payout, by ascending payout\n"
+        "        { \"payout\" : x.xxx, \"outcomes\" : n }, ...\n"
+        "      ],\n"
+        "      \"payouts\" : {              (object, verbose only) The payout of each winning outcome\n"
+        "        \"outcome\" : x.xxx, ...\n"
+        "      }\n"
+        "    }, ...\n"
+        "  ]\n"
+        "}\n"
+
+
+        "\nExamples:\n"
+        + HelpExampleCli("simulatebets", "")
+        + HelpExampleCli("simulatebets", "\"blockhash\"")
+        + HelpExampleCli("simulatebets", "\"\" '[\"hexstring\"]' true")
+        + HelpExampleRpc("simulatebets", "\"blockhash\"")
+    );
+
+    const bool hasBlockHash=!request.params[0].isNull() && !request.params[0].get_str().empty();
+    if(hasBlockHash && !request.params[1].isNull())
     {
-        throw std::runtime_error("checkBetsPotentialReward failed with reason: potential reward or sum of bets over limit");
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Give either a blockhash or transactions");
     }
+    const bool verbose=!request.params[2].isNull() && request.params[2].get_bool();
 
-    CValidationState state;
-    if(!pwallet->CommitTransaction(tx, {}, {}, reservekey, g_connman.get(), state))
+    modulo::ver_2::BetSimulation simulation;
+    size_t skipped=0, truncated=0;
+    std::string error;
+    if(!request.params[1].isNull())
     {
-        throw std::runtime_error(std::string("CommitTransaction failed with reason: ")+FormatStateMessage(state));
+        const UniValue& txs=request.params[1].get_array();
+        if(txs.size()>modulo::ver_2::MAX_SIMULATED_BETS)
+        {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("At most %u transactions can be simulated", modulo::ver_2::MAX_SIMULATED_BETS));
+        }
+        for(size_t i=0;i<txs.size();++i)
+        {
+            CMutableTransaction mtx;
+            if(!DecodeHexTx(mtx, txs[i].get_str(), true))
+            {
+                throw JSONRPCError(RPC_DESERIALIZATION_ERROR, strprintf("Transaction %u: TX decode failed", i));
+            }
+            if(!simulation.addBet(CTransaction(mtx), error))
+            {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Transaction %u: %s", i, error));
+            }
+        }
+    }
+    else if(hasBlockHash)
+    {
+        const uint256 hash=ParseHashV(request.params[0], "blockhash");
+        CBlock block;
+        {
+            LOCK(cs_main);
+            const CBlockIndex* pblockindex=LookupBlockIndex(hash);
+            if(!pblockindex)
+            {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+            }
+            if(IsBlockPruned(pblockindex))
+            {
+                throw JSONRPCError(RPC_MISC_ERROR, "Block not available (pruned data)");
+            }
+            if(!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus()))
+            {
+                throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
+            }
+        }
+        for(const CTransactionRef& tx : block.vtx)
+        {
+            if(!modulo::ver_2::isMakeBetTx(*tx))
+            {
+                continue;
+            }
+            if(simulation.isFull())
+            {
+                ++truncated;
+            }
+            else if(!simulation.addBet(*tx, error))
+            {
+                ++skipped;
+            }
+        }
+    }
+    else
+    {
+        LOCK(mempool.cs);
+        for(const CTxMemPoolEntry& entry : mempool.mapTx)
+        {
+            if(!modulo::ver_2::isMakeBetTx(entry.GetTx()))
+            {
+                continue;
+            }
+            if(simulation.isFull())
+            {
+                ++truncated;
+            }
+            else if(!simulation.addBet(entry.GetTx(), error))
+            {
+                ++skipped;
+            }
+        }
     }
 
-    std::string txid=tx->GetHash().GetHex();
-    return UniValue(UniValue::VSTR, txid);
+    CAmount betsSum=0, maxPayout=0, expectedPayout=0;
+    UniValue arguments(UniValue::VARR);
+    for(const modulo::ver_2::PayoutDistribution& distribution : simulation.getDistributions())
+    {
+        betsSum+=distribution.betsSum;
+        maxPayout+=distribution.getMaxPayout();
+        expectedPayout+=distribution.getExpectedPayout();
+        arguments.push_back(payoutDistributionToJSON(distribution, verbose));
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("bets", (int64_t)simulation.size());
+    result.pushKV("skipped", (int64_t)skipped);
+    result.pushKV("truncated", (int64_t)truncated);
+    result.pushKV("betsum", ValueFromAmount(betsSum));
+    result.pushKV("maxpayout", ValueFromAmount(maxPayout));
+    result.pushKV("expectedpayout", ValueFromAmount(expectedPayout));
+    result.pushKV("arguments", arguments);
+    return result;
 }
 
 
@@ -183,6 +815,10 @@ static const CRPCCommand commands[] =
 { //  category              name                            actor (function)            argNames
   //  --------------------- ------------------------        -----------------------     ----------
     { "games",             "makebet",                      &makebet,                   {"type_of_bet", "range", "replaceable", "conf_target", "estimate_mode"} },
+    { "games",             "makebets",                     &makebets,                  {"bets", "replaceable", "conf_target", "estimate_mode"} },
+    { "games",             "getbetstatus",                 &getbetstatus,              {"txid"} },
+    { "games",             "listbets",                     &listbets,                  {"address", "count", "skip"} },
+    { "games",             "simulatebets",                 &simulatebets,              {"blockhash", "transactions", "verbose"} },
 };
 
 void RegisterGameRPCCommands(CRPCTable &t)
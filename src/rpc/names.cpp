@@ -9,6 +9,7 @@
 #include <key_io.h>
 #include <names/common.h>
 #include <names/main.h>
+#include <names/snapshot.h>
 #include <primitives/transaction.h>
 #include <rpc/names.h>
 #include <rpc/server.h>
@@ -25,6 +26,7 @@
 
 #include <boost/xpressive/xpressive_dynamic.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <memory>
 #include <sstream>
@@ -62,11 +64,21 @@ getNameInfo (const valtype& name, const valtype& value,
  */
 UniValue
 getNameInfo (const valtype& name, const CNameData& data)
+{
+  return getNameInfo (name, data, chainActive.Height ());
+}
+
+/**
+ * Return name info object for a CNameData object, with the expiration
+ * computed relative to the given chain height.
+ */
+UniValue
+getNameInfo (const valtype& name, const CNameData& data, const int curHeight)
 {
   UniValue result = getNameInfo (name, data.getValue (),
                                  data.getUpdateOutpoint (),
                                  data.getAddress ());
-  addExpirationInfo (data.getHeight (), result);
+  addExpirationInfo (data.getHeight (), curHeight, result);
   return result;
 }
 
@@ -77,7 +89,16 @@ getNameInfo (const valtype& name, const CNameData& data)
 void
 addExpirationInfo (const int height, UniValue& data)
 {
-  const int curHeight = chainActive.Height ();
+  addExpirationInfo (height, chainActive.Height (), data);
+}
+
+/**
+ * Adds expiration information to the JSON object, with the chain being
+ * at the given height.
+ */
+void
+addExpirationInfo (const int height, const int curHeight, UniValue& data)
+{
   const Consensus::Params& params = Params ().GetConsensus ();
   const int expireDepth = params.rules->NameExpirationDepth (curHeight);
   const int expireHeight = height + expireDepth;
@@ -207,6 +228,63 @@ getNameInfo (const valtype& name, const CNameData& data,
   return res;
 }
 
+/**
+ * Variant of getNameInfo with ownership information and the expiration
+ * relative to a given chain height.
+ */
+UniValue
+getNameInfo (const valtype& name, const CNameData& data, const int curHeight,
+             const MaybeWalletForRequest& wallet)
+{
+  UniValue res = getNameInfo (name, data, curHeight);
+  addOwnershipInfo (data.getAddress (), wallet, res);
+  return res;
+}
+
+/**
+ * Looks up the current data of a name and, if requested, its history for
+ * the read-only name RPCs.  They are served from the published name state
+ * without taking cs_main; only if there is none (e.g. during the initial
+ * block download), the chain state is locked instead.
+ * Throws if the name does not exist.
+ * @return The chain height the data corresponds to.
+ */
+int
+LookupNameOrThrow (const valtype& name, CNameData& data,
+                   CNameHistory* history)
+{
+  bool found;
+  int curHeight;
+
+  const CNameStateSnapshotRef snapshot = GetNameStateSnapshot ();
+  if (snapshot != nullptr)
+    {
+      found = snapshot->getName (name, data);
+      if (found && history != nullptr
+            && !snapshot->getNameHistory (name, *history))
+        assert (history->empty ());
+      curHeight = snapshot->getHeight ();
+    }
+  else
+    {
+      LOCK (cs_main);
+      found = pcoinsTip->GetName (name, data);
+      if (found && history != nullptr
+            && !pcoinsTip->GetNameHistory (name, *history))
+        assert (history->empty ());
+      curHeight = chainActive.Height ();
+    }
+
+  if (!found)
+    {
+      std::ostringstream msg;
+      msg << "name not found: " << EncodeNameForMessage (name);
+      throw JSONRPCError (RPC_WALLET_ERROR, msg.str ());
+    }
+
+  return curHeight;
+}
+
 } // anonymous namespace
 
 /* ************************************************************************** */
@@ -306,19 +384,11 @@ name_show (const JSONRPCRequest& request)
       = DecodeNameFromRPCOrThrow (request.params[0], ConfiguredNameEncoding ());
 
   CNameData data;
-  {
-    LOCK (cs_main);
-    if (!pcoinsTip->GetName (name, data))
-      {
-        std::ostringstream msg;
-        msg << "name not found: " << EncodeNameForMessage (name);
-        throw JSONRPCError (RPC_WALLET_ERROR, msg.str ());
-      }
-  }
+  const int curHeight = LookupNameOrThrow (name, data, nullptr);
 
   MaybeWalletForRequest wallet(request);
   LOCK (wallet.getLock ());
-  return getNameInfo (name, data, wallet);
+  return getNameInfo (name, data, curHeight, wallet);
 }
 
 /* ************************************************************************** */
@@ -330,7 +400,8 @@ name_history (const JSONRPCRequest& request)
     throw std::runtime_error (
         "name_history \"name\"\n"
         "\nLook up the current and all past data for the given name."
-        "  -namehistory must be enabled.\n"
+        "  -namehistory must be enabled.  With -namehistorydepth, only"
+        " that many past entries are returned.\n"
         "\nArguments:\n"
         "1. \"name\"          (string, required) the name to query for\n"
         "\nResult:\n"
@@ -359,44 +430,133 @@ name_history (const JSONRPCRequest& request)
 
   CNameData data;
   CNameHistory history;
-
-  {
-    LOCK (cs_main);
-
-    if (!pcoinsTip->GetName (name, data))
-      {
-        std::ostringstream msg;
-        msg << "name not found: " << EncodeNameForMessage (name);
-        throw JSONRPCError (RPC_WALLET_ERROR, msg.str ());
-      }
-
-    if (!pcoinsTip->GetNameHistory (name, history))
-      assert (history.empty ());
-  }
+  const int curHeight = LookupNameOrThrow (name, data, &history);
 
   MaybeWalletForRequest wallet(request);
   LOCK (wallet.getLock ());
 
   UniValue res(UniValue::VARR);
   for (const auto& entry : history.getData ())
-    res.push_back (getNameInfo (name, entry, wallet));
-  res.push_back (getNameInfo (name, data, wallet));
+    res.push_back (getNameInfo (name, entry, curHeight, wallet));
+  res.push_back (getNameInfo (name, data, curHeight, wallet));
 
   return res;
 }
 
 /* ************************************************************************** */
 
+namespace
+{
+
+/**
+ * Name iterator over a fixed set of names, as found from the expire index.
+ * The data is looked up from the name state when the names are iterated.
+ */
+class CNameSetIterator : public CNameIterator
+{
+
+private:
+
+  typedef std::set<valtype, CNameCache::NameComparator> NameSet;
+
+  /** The name state to look the names up in.  */
+  const CNameStateSnapshot& state;
+
+  /** The names to iterate, in database order.  */
+  NameSet names;
+
+  /** Current position.  */
+  NameSet::const_iterator pos;
+
+public:
+
+  CNameSetIterator (const CNameStateSnapshot& s,
+                    const std::set<CNameCache::ExpireEntry>& entries)
+    : state(s)
+  {
+    for (const auto& entry : entries)
+      names.insert (entry.name);
+    pos = names.begin ();
+  }
+
+  void
+  seek (const valtype& start) override
+  {
+    pos = names.lower_bound (start);
+  }
+
+  bool
+  next (valtype& name, CNameData& data) override
+  {
+    for (; pos != names.end (); ++pos)
+      if (state.getName (*pos, data))
+        {
+          name = *pos++;
+          return true;
+        }
+
+    return false;
+  }
+
+};
+
+/**
+ * Restrict a name iterator to the names with a given prefix, if any.  This
+ * takes ownership of the base iterator.
+ */
+std::unique_ptr<CNameIterator>
+IterateNamesWithPrefix (CNameIterator* base, const valtype& prefix)
+{
+  if (prefix.empty ())
+    return std::unique_ptr<CNameIterator> (base);
+
+  return std::unique_ptr<CNameIterator> (
+      new CNamePrefixIterator (base, prefix));
+}
+
+/**
+ * Find a literal prefix that all names matching a regexp must have, so
+ * that name_filter can seek to it instead of scanning all names.  This
+ * is deliberately conservative:  Only a run of plain ASCII characters
+ * directly after a leading "^" is used, and nothing if the expression has
+ * alternatives.
+ */
+valtype
+GetRegexpPrefix (const std::string& regexp)
+{
+  if (regexp.empty () || regexp[0] != '^'
+        || regexp.find ('|') != std::string::npos)
+    return valtype ();
+
+  static const std::string special = "\\.^$|?*+()[]{}";
+  size_t end = 1;
+  while (end < regexp.size ()
+          && static_cast<unsigned char> (regexp[end]) < 0x80
+          && special.find (regexp[end]) == std::string::npos)
+    ++end;
+
+  /* A quantifier applies to the last literal character, which is thus not
+     part of the prefix anymore.  */
+  if (end < regexp.size () && end > 1
+        && std::string ("?*+{").find (regexp[end]) != std::string::npos)
+    --end;
+
+  return valtype (regexp.begin () + 1, regexp.begin () + end);
+}
+
+} // anonymous namespace
+
 UniValue
 name_scan (const JSONRPCRequest& request)
 {
-  if (request.fHelp || request.params.size () > 2)
+  if (request.fHelp || request.params.size () > 3)
     throw std::runtime_error (
-        "name_scan (\"start\" (\"count\"))\n"
+        "name_scan (\"start\" (\"count\" (\"prefix\")))\n"
         "\nList names in the database.\n"
         "\nArguments:\n"
         "1. \"start\"       (string, optional) skip initially to this name\n"
         "2. \"count\"       (numeric, optional, default=500) stop after this many names\n"
+        "3. \"prefix\"      (string, optional) only list names starting with this prefix\n"
         "\nResult:\n"
         "[\n"
         + NameInfoHelp ("  ")
@@ -408,10 +568,12 @@ name_scan (const JSONRPCRequest& request)
         + HelpExampleCli ("name_scan", "")
         + HelpExampleCli ("name_scan", "\"d/abc\"")
         + HelpExampleCli ("name_scan", "\"d/abc\" 10")
+        + HelpExampleCli ("name_scan", "\"\" 10 \"d/\"")
         + HelpExampleRpc ("name_scan", "\"d/abc\"")
       );
 
-  RPCTypeCheck (request.params, {UniValue::VSTR, UniValue::VNUM});
+  RPCTypeCheck (request.params,
+                {UniValue::VSTR, UniValue::VNUM, UniValue::VSTR});
 
   if (IsInitialBlockDownload ())
     throw JSONRPCError(RPC_CLIENT_IN_INITIAL_DOWNLOAD,
@@ -426,6 +588,11 @@ name_scan (const JSONRPCRequest& request)
   if (request.params.size () >= 2)
     count = request.params[1].get_int ();
 
+  valtype prefix;
+  if (request.params.size () >= 3)
+    prefix = DecodeNameFromRPCOrThrow (request.params[2],
+                                       ConfiguredNameEncoding ());
+
   UniValue res(UniValue::VARR);
   if (count <= 0)
     return res;
@@ -435,7 +602,8 @@ name_scan (const JSONRPCRequest& request)
 
   valtype name;
   CNameData data;
-  std::unique_ptr<CNameIterator> iter(pcoinsTip->IterateNames ());
+  std::unique_ptr<CNameIterator> iter
+      = IterateNamesWithPrefix (pcoinsTip->IterateNames (), prefix);
   for (iter->seek (start); count > 0 && iter->next (name, data); --count)
     res.push_back (getNameInfo (name, data, wallet));
 
@@ -447,16 +615,21 @@ name_scan (const JSONRPCRequest& request)
 UniValue
 name_filter (const JSONRPCRequest& request)
 {
-  if (request.fHelp || request.params.size () > 5)
+  if (request.fHelp || request.params.size () > 6)
     throw std::runtime_error (
-        "name_filter (\"regexp\" (\"maxage\" (\"from\" (\"nb\" (\"stat\")))))\n"
+        "name_filter (\"regexp\" (\"maxage\" (\"from\" (\"nb\" (\"stat\" (\"cursor\"))))))\n"
         "\nScan and list names matching a regular expression.\n"
+        "\nA regexp starting with \"^\" and a literal prefix only scans names with that prefix,"
+        " otherwise a non-zero \"maxage\" only scans names recently updated.\n"
+        "\"^\" and \"$\" only match at the start and end of a name, not at newlines within it.\n"
         "\nArguments:\n"
         "1. \"regexp\"      (string, optional) filter names with this regexp\n"
         "2. \"maxage\"      (numeric, optional, default=36000) only consider names updated in the last \"maxage\" blocks; 0 means all names\n"
         "3. \"from\"        (numeric, optional, default=0) return from this position onward; index starts at 0\n"
         "4. \"nb\"          (numeric, optional, default=0) return only \"nb\" entries; 0 means all\n"
         "5. \"stat\"        (string, optional) if set to the string \"stat\", print statistics instead of returning the names\n"
+        "6. \"cursor\"      (string, optional) continue after this cursor returned by a previous call, \"\" to start;"
+        " cannot be combined with \"from\"\n"
         "\nResult:\n"
         "[\n"
         + NameInfoHelp ("  ")
@@ -464,16 +637,22 @@ name_filter (const JSONRPCRequest& request)
             .finish (",") +
         "  ...\n"
         "]\n"
+        "\nResult (if \"cursor\" is given):\n"
+        "{\n"
+        "  \"names\": [...],      (array) the names as above\n"
+        "  \"cursor\": \"xxxx\"    (string) cursor for the next page, missing if there are no more names\n"
+        "}\n"
         "\nExamples:\n"
         + HelpExampleCli ("name_filter", "\"\" 5")
         + HelpExampleCli ("name_filter", "\"^id/\"")
         + HelpExampleCli ("name_filter", "\"^id/\" 36000 0 0 \"stat\"")
+        + HelpExampleCli ("name_filter", "\"^d/\" 0 0 100 \"\" \"\"")
         + HelpExampleRpc ("name_scan", "\"^d/\"")
       );
 
   RPCTypeCheck (request.params,
                 {UniValue::VSTR, UniValue::VNUM, UniValue::VNUM, UniValue::VNUM,
-                 UniValue::VSTR});
+                 UniValue::VSTR, UniValue::VSTR});
 
   if (IsInitialBlockDownload ())
     throw JSONRPCError(RPC_CLIENT_IN_INITIAL_DOWNLOAD,
@@ -484,14 +663,23 @@ name_filter (const JSONRPCRequest& request)
 
   bool haveRegexp(false);
   boost::xpressive::sregex regexp;
+  valtype prefix;
 
   int maxage(36000), from(0), nb(0);
   bool stats(false);
 
+  bool haveCursor(false);
+  valtype cursor;
+
   if (request.params.size () >= 1)
     {
+      /* Names may contain newlines, make sure that "^" still only matches
+         at the start of the name so that the prefix is actually required.  */
       haveRegexp = true;
-      regexp = boost::xpressive::sregex::compile (request.params[0].get_str ());
+      const std::string& regexpStr = request.params[0].get_str ();
+      regexp = boost::xpressive::sregex::compile (
+          regexpStr, boost::xpressive::regex_constants::single_line);
+      prefix = GetRegexpPrefix (regexpStr);
     }
 
   if (request.params.size () >= 2)
@@ -511,10 +699,24 @@ name_filter (const JSONRPCRequest& request)
 
   if (request.params.size () >= 5)
     {
-      if (request.params[4].get_str () != "stat")
+      const std::string& statStr = request.params[4].get_str ();
+      if (statStr != "stat" && !(statStr.empty () && request.params.size () >= 6))
         throw JSONRPCError (RPC_INVALID_PARAMETER,
                             "fifth argument must be the literal string 'stat'");
-      stats = true;
+      stats = !statStr.empty ();
+    }
+
+  if (request.params.size () >= 6)
+    {
+      if (from != 0)
+        throw JSONRPCError (RPC_INVALID_PARAMETER,
+                            "'from' cannot be combined with 'cursor'");
+
+      const std::string& cursorStr = request.params[5].get_str ();
+      if (!IsHex (cursorStr) && !cursorStr.empty ())
+        throw JSONRPCError (RPC_INVALID_PARAMETER, "invalid cursor");
+      haveCursor = true;
+      cursor = ParseHex (cursorStr);
     }
 
   /* ******************************************* */
@@ -522,16 +724,47 @@ name_filter (const JSONRPCRequest& request)
 
   UniValue names(UniValue::VARR);
   unsigned count(0);
+  bool more(false);
+  valtype last;
 
   MaybeWalletForRequest wallet(request);
-  LOCK2 (cs_main, wallet.getLock ());
+
+  /* The names are scanned in the published name state, which is based on a
+     snapshot of the database, so that neither block processing nor the
+     wallet is blocked for the scan.  Its height is the tip all names are
+     checked against.  */
+  const CNameStateSnapshotRef state = GetNameStateSnapshot ();
+  if (state == nullptr)
+    throw JSONRPCError(RPC_CLIENT_IN_INITIAL_DOWNLOAD,
+                       "BST is downloading blocks...");
+  const int tip = state->getHeight ();
+
+  /* Seek directly to the names that can match if possible:  A prefix
+     of the regexp limits the names to a few ranges of the database,
+     otherwise maxage limits them to a range of the expire index.  */
+  std::unique_ptr<CNameIterator> iter;
+  if (!prefix.empty () || maxage == 0)
+    iter = IterateNamesWithPrefix (state->iterateNames (), prefix);
+  else
+    {
+      std::set<CNameCache::ExpireEntry> entries;
+      if (!state->getNamesForHeights (std::max (0, tip - maxage + 1),
+                                      tip, entries))
+        throw JSONRPCError (RPC_DATABASE_ERROR,
+                            "could not read the expire index");
+      iter.reset (new CNameSetIterator (*state, entries));
+    }
+
+  iter->seek (cursor);
 
   valtype name;
   CNameData data;
-  std::unique_ptr<CNameIterator> iter(pcoinsTip->IterateNames ());
   while (iter->next (name, data))
     {
-      const int age = chainActive.Height () - data.getHeight ();
+      if (haveCursor && name == cursor)
+        continue;
+
+      const int age = tip - data.getHeight ();
       assert (age >= 0);
       if (maxage != 0 && age >= maxage)
         continue;
@@ -558,17 +791,22 @@ name_filter (const JSONRPCRequest& request)
         }
       assert (from == 0);
 
+      /* Only after the page is full do we know whether there are more
+         names; then the last one returned is the next cursor.  */
+      if (nb > 0 && names.size () + count == static_cast<unsigned> (nb))
+        {
+          more = true;
+          break;
+        }
+
       if (stats)
         ++count;
       else
-        names.push_back (getNameInfo (name, data, wallet));
-
-      if (nb > 0)
         {
-          --nb;
-          if (nb == 0)
-            break;
+          LOCK (wallet.getLock ());
+          names.push_back (getNameInfo (name, data, tip, wallet));
         }
+      last = name;
     }
 
   /* ********************************************************** */
@@ -577,12 +815,22 @@ name_filter (const JSONRPCRequest& request)
   if (stats)
     {
       UniValue res(UniValue::VOBJ);
-      res.pushKV ("blocks", chainActive.Height ());
+      res.pushKV ("blocks", tip);
       res.pushKV ("count", static_cast<int> (count));
 
       return res;
     }
 
+  if (haveCursor)
+    {
+      UniValue res(UniValue::VOBJ);
+      res.pushKV ("names", names);
+      if (more)
+        res.pushKV ("cursor", HexStr (last));
+
+      return res;
+    }
+
   return names;
 }
 
@@ -821,22 +1069,43 @@ namerawtransaction (const JSONRPCRequest& request)
 UniValue
 name_checkdb (const JSONRPCRequest& request)
 {
-  if (request.fHelp || request.params.size () != 0)
+  if (request.fHelp || request.params.size () > 1)
     throw std::runtime_error (
-        "name_checkdb\n"
-        "\nValidate the name DB's consistency.\n"
+        "name_checkdb (restart)\n"
+        "\nValidate the name DB's consistency.  The full database is\n"
+        "scanned in the background on a snapshot of the chain state; the\n"
+        "first call starts the check, later calls report its state.\n"
+        "\nArguments:\n"
+        "1. \"restart\"   (boolean, optional, default=false) start a new check"
+                           " if the last one has finished\n"
         "\nRoughly between blocks 139,000 and 180,000, this call is expected\n"
         "to fail due to the historic 'name stealing' bug.\n"
         "\nResult:\n"
-        "xxxxx                        (boolean) whether the state is valid\n"
+        "{\n"
+        "  \"running\": xxxxx,         (boolean) whether the check is running\n"
+        "  \"height\": xxxxx,          (numeric) the height being checked\n"
+        "  \"valid\": xxxxx,           (boolean) whether the state is valid,"
+                                        " once the check finished\n"
+        "}\n"
         "\nExamples:\n"
         + HelpExampleCli ("name_checkdb", "")
         + HelpExampleRpc ("name_checkdb", "")
       );
 
-  LOCK (cs_main);
-  pcoinsTip->Flush ();
-  return pcoinsTip->ValidateNameDB ();
+  const bool restart = !request.params[0].isNull ()
+                        && request.params[0].get_bool ();
+
+  NameDBCheckStatus status = GetNameDBCheckStatus ();
+  if (!status.running && (!status.started || restart) && StartNameDBCheck ())
+    status = GetNameDBCheckStatus ();
+
+  UniValue res(UniValue::VOBJ);
+  res.pushKV ("running", status.running);
+  res.pushKV ("height", static_cast<int> (status.height));
+  if (!status.running)
+    res.pushKV ("valid", status.ok);
+
+  return res;
 }
 
 } // namespace
@@ -847,10 +1116,10 @@ static const CRPCCommand commands[] =
   //  --------------------- ------------------------  -----------------------  ----------
     { "names",              "name_show",              &name_show,              {"name"} },
     { "names",              "name_history",           &name_history,           {"name"} },
-    { "names",              "name_scan",              &name_scan,              {"start","count"} },
-    { "names",              "name_filter",            &name_filter,            {"regexp","maxage","from","nb","stat"} },
+    { "names",              "name_scan",              &name_scan,              {"start","count","prefix"} },
+    { "names",              "name_filter",            &name_filter,            {"regexp","maxage","from","nb","stat","cursor"} },
     { "names",              "name_pending",           &name_pending,           {"name"} },
-    { "names",              "name_checkdb",           &name_checkdb,           {} },
+    { "names",              "name_checkdb",           &name_checkdb,           {"restart"} },
     { "rawtransactions",    "namerawtransaction",     &namerawtransaction,     {"hexstring","vout","nameop"} },
 };
 
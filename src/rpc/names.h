@@ -20,7 +20,10 @@ class UniValue;
 UniValue getNameInfo (const valtype& name, const valtype& value,
                       const COutPoint& outp, const CScript& addr);
 UniValue getNameInfo (const valtype& name, const CNameData& data);
+UniValue getNameInfo (const valtype& name, const CNameData& data,
+                      int curHeight);
 void addExpirationInfo (int height, UniValue& data);
+void addExpirationInfo (int height, int curHeight, UniValue& data);
 
 #ifdef ENABLE_WALLET
 class CWallet;
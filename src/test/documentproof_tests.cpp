@@ -0,0 +1,121 @@
+// Copyright (c) 2018 Slawek Mozdzonek
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <data/documentproof.h>
+#include <hash.h>
+#include <test/test_bitcoin.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(documentproof_tests, BasicTestingSetup)
+
+static std::vector<uint256> makeDocuments(size_t count)
+{
+    std::vector<uint256> documents;
+    for (size_t i = 0; i < count; ++i) {
+        const unsigned char byte = static_cast<unsigned char>(i);
+        uint256 hash;
+        CHash256().Write(&byte, 1).Finalize(hash.begin());
+        documents.push_back(hash);
+    }
+    return documents;
+}
+
+BOOST_AUTO_TEST_CASE(documentproof_tagged_tree)
+{
+    const std::vector<uint256> documents = makeDocuments(3);
+    const uint256 leaf0 = documentLeafHash(documents[0]);
+    const uint256 leaf1 = documentLeafHash(documents[1]);
+    const uint256 leaf2 = documentLeafHash(documents[2]);
+
+    // leaves and inner nodes are hashed with different tags
+    BOOST_CHECK(leaf0 != documents[0]);
+    BOOST_CHECK(documentLeafHash(leaf0) != documentNodeHash(leaf0, leaf1));
+
+    // the odd last leaf is moved up unchanged, not paired with itself
+    std::vector<std::vector<uint256>> branches;
+    const uint256 root = computeDocumentsRoot(documents, &branches);
+    BOOST_CHECK(root == documentNodeHash(documentNodeHash(leaf0, leaf1), leaf2));
+    BOOST_CHECK(computeDocumentsRoot(documents) == root);
+    BOOST_REQUIRE_EQUAL(branches.size(), 3U);
+    BOOST_CHECK(branches[0] == std::vector<uint256>({leaf1, leaf2}));
+    BOOST_CHECK(branches[1] == std::vector<uint256>({leaf0, leaf2}));
+    BOOST_CHECK(branches[2] == std::vector<uint256>({documentNodeHash(leaf0, leaf1)}));
+
+    // a single document is its own leaf
+    BOOST_CHECK(computeDocumentsRoot({documents[0]}) == leaf0);
+    BOOST_CHECK(computeDocumentsRoot({}).IsNull());
+}
+
+BOOST_AUTO_TEST_CASE(documentproof_branches)
+{
+    for (size_t count = 1; count <= 17; ++count) {
+        const std::vector<uint256> documents = makeDocuments(count);
+        std::vector<std::vector<uint256>> branches;
+        const uint256 root = computeDocumentsRoot(documents, &branches);
+        BOOST_REQUIRE_EQUAL(branches.size(), count);
+
+        for (uint32_t index = 0; index < count; ++index) {
+            uint256 computed;
+            BOOST_CHECK(computeDocumentsRootFromBranch(documents[index], branches[index], index, count, computed));
+            BOOST_CHECK(computed == root);
+
+            // the proof of a document does not pass for another one
+            const uint32_t other = (index + 1) % count;
+            if (other != index) {
+                BOOST_CHECK(!computeDocumentsRootFromBranch(documents[other], branches[index], index, count, computed) || computed != root);
+                BOOST_CHECK(!computeDocumentsRootFromBranch(documents[index], branches[index], other, count, computed) || computed != root);
+            }
+
+            // the branch must have the shape of the tree
+            std::vector<uint256> longer = branches[index];
+            longer.push_back(root);
+            BOOST_CHECK(!computeDocumentsRootFromBranch(documents[index], longer, index, count, computed));
+            if (!branches[index].empty()) {
+                std::vector<uint256> shorter(branches[index].begin(), branches[index].end() - 1);
+                BOOST_CHECK(!computeDocumentsRootFromBranch(documents[index], shorter, index, count, computed));
+            }
+        }
+
+        // indexes at or beyond the number of documents never pass
+        uint256 computed;
+        BOOST_CHECK(!computeDocumentsRootFromBranch(documents[count - 1], branches[count - 1], count, count, computed));
+        BOOST_CHECK(!computeDocumentsRootFromBranch(documents[count - 1], branches[count - 1], 2 * count, count, computed));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(documentproof_inner_node_is_not_a_document)
+{
+    // a digest equal to an inner node is tagged as a leaf, so it does not
+    // pass for the subtree below it with the shorter branch
+    const std::vector<uint256> documents = makeDocuments(4);
+    std::vector<std::vector<uint256>> branches;
+    const uint256 root = computeDocumentsRoot(documents, &branches);
+    const uint256 inner = documentNodeHash(documentLeafHash(documents[0]), documentLeafHash(documents[1]));
+
+    uint256 computed;
+    const std::vector<uint256> upper(branches[0].begin() + 1, branches[0].end());
+    BOOST_CHECK(!computeDocumentsRootFromBranch(inner, upper, 0, 4, computed) || computed != root);
+    BOOST_CHECK(!computeDocumentsRootFromBranch(inner, upper, 0, 2, computed) || computed != root);
+}
+
+BOOST_AUTO_TEST_CASE(documentproof_commitment)
+{
+    const uint256 root = computeDocumentsRoot(makeDocuments(5));
+    const std::vector<unsigned char> data = serializeDocumentsCommitment(root, 5);
+    BOOST_CHECK_EQUAL(data.size(), documentsCommitmentSize);
+
+    uint256 parsedRoot;
+    uint32_t parsedCount;
+    BOOST_CHECK(parseDocumentsCommitment(Span<const unsigned char>(data.data(), data.size()), parsedRoot, parsedCount));
+    BOOST_CHECK(parsedRoot == root);
+    BOOST_CHECK_EQUAL(parsedCount, 5U);
+
+    // a bare root, as stored by storesignature, is not a commitment of many documents
+    BOOST_CHECK(!parseDocumentsCommitment(Span<const unsigned char>(root.begin(), root.end()), parsedRoot, parsedCount));
+    const std::vector<unsigned char> empty = serializeDocumentsCommitment(root, 0);
+    BOOST_CHECK(!parseDocumentsCommitment(Span<const unsigned char>(empty.data(), empty.size()), parsedRoot, parsedCount));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -8,6 +8,9 @@
 #include "chainparams.h"
 #include "data/datautils.h"
 #include "games/gamestxs.h"
+#include "games/modulo/modulobet.h"
+#include "games/modulo/modulobetindex.h"
+#include "games/modulo/modulosimulation.h"
 #include "games/modulo/modulotxs.h"
 #include "games/modulo/moduloutils.h"
 #include "games/modulo/moduloverify.h"
@@ -420,6 +423,329 @@ BOOST_AUTO_TEST_CASE(MakebetPotentialRewardTest_MultipleBetsOverRewardLimit)
     BOOST_CHECK_EQUAL(false, modulo::ver_2::checkBetsPotentialReward(rewardSum, betsSum, CTransaction(txn)));
 }
 
+BOOST_AUTO_TEST_CASE(MakebetPotentialRewardTest_SumsCheckedSeparately)
+{
+    const Consensus::Params& params = Params().GetConsensus();
+    CAmount amount = (GetBlockSubsidy(chainActive.Height(), params) / 2) / 4;
+    const std::string game_tag = "3030303030303031";
+    std::stringstream command{};
+    command << "_1@" << amount << "+2@" << amount;
+
+    CMutableTransaction txn;
+    prepareTransaction(txn);
+    txn.vout[0].nValue = 2 * amount;
+    txn.vout[0].scriptPubKey = CScript() << OP_RETURN << ParseHex(game_tag + toHex(command.str()));
+
+    // the sums match those of checkBetsPotentialReward
+    CAmount rewardSum = 0, betsSum = 0;
+    BOOST_CHECK_EQUAL(true, modulo::ver_2::getBetsPotentialReward(rewardSum, betsSum, CTransaction(txn)));
+    CAmount checkedRewardSum = 0, checkedBetsSum = 0;
+    BOOST_CHECK_EQUAL(true, modulo::ver_2::checkBetsPotentialReward(checkedRewardSum, checkedBetsSum, CTransaction(txn)));
+    BOOST_CHECK_EQUAL(checkedRewardSum, rewardSum);
+    BOOST_CHECK_EQUAL(checkedBetsSum, betsSum);
+    BOOST_CHECK_EQUAL(2 * amount, betsSum);
+
+    // three such bets fit into a block, a fourth one does not
+    BOOST_CHECK_EQUAL(true, modulo::ver_2::isBetsPotentialRewardWithinLimit(3 * rewardSum, 3 * betsSum, chainActive.Height(), params));
+    BOOST_CHECK_EQUAL(false, modulo::ver_2::isBetsPotentialRewardWithinLimit(4 * rewardSum, 4 * betsSum, chainActive.Height(), params));
+
+    // transactions other than bets have nothing to add
+    CAmount otherRewardSum = 0, otherBetsSum = 0;
+    BOOST_CHECK_EQUAL(true, modulo::ver_2::getBetsPotentialReward(otherRewardSum, otherBetsSum, CTransaction(CMutableTransaction())));
+    BOOST_CHECK_EQUAL(0, otherRewardSum);
+    BOOST_CHECK_EQUAL(0, otherBetsSum);
+}
+
+BOOST_AUTO_TEST_CASE(MakebetSimulationTest_PayoutDistribution)
+{
+    const std::vector<std::pair<std::string, CAmount>> bets{
+        {"24_red@100+straight_1@10", 110},
+        {"24_black@50", 50},
+        {"64_7@5", 5}
+    };
+
+    modulo::ver_2::BetSimulation simulation;
+    std::string error;
+    for (const auto& bet : bets)
+    {
+        CMutableTransaction txn;
+        prepareTransaction(txn);
+        txn.vout[0].nValue = bet.second;
+        txn.vout[0].scriptPubKey = CScript() << OP_RETURN << ParseHex(GAME_TAG + toHex(bet.first));
+        BOOST_CHECK_EQUAL(true, simulation.addBet(CTransaction(txn), error));
+    }
+
+    // a bet outside of the roulette table leaves the simulation unchanged
+    CMutableTransaction txn;
+    prepareTransaction(txn);
+    txn.vout[0].nValue = 15;
+    txn.vout[0].scriptPubKey = CScript() << OP_RETURN << ParseHex(GAME_TAG + toHex("24_red@10+split_99@5"));
+    BOOST_CHECK_EQUAL(false, simulation.addBet(CTransaction(txn), error));
+    BOOST_CHECK_EQUAL(3U, simulation.size());
+
+    const std::vector<modulo::ver_2::PayoutDistribution> distributions = simulation.getDistributions();
+    BOOST_REQUIRE_EQUAL(2U, distributions.size());
+
+    // every roulette outcome is red or black, the red 1 also pays the straight bet
+    const modulo::ver_2::PayoutDistribution& roulette = distributions[0];
+    BOOST_CHECK_EQUAL(36U, roulette.argument);
+    BOOST_CHECK_EQUAL(3U, roulette.bets);
+    BOOST_CHECK_EQUAL(160, roulette.betsSum);
+    BOOST_CHECK_EQUAL(36U, roulette.payouts.size());
+    BOOST_CHECK_EQUAL(560, roulette.getMaxPayout());
+    BOOST_CHECK_EQUAL((17 * 200 + 560 + 18 * 100) / 36, roulette.getExpectedPayout());
+    const std::map<CAmount, uint64_t> rouletteHistogram{{100, 18}, {200, 17}, {560, 1}};
+    BOOST_CHECK(rouletteHistogram == roulette.getHistogram());
+    for (const auto& payout : roulette.payouts)
+    {
+        const modulo::Leg red = modulo::parseBetLeg("red");
+        const CAmount expected = modulo::isBetWinning(red, 36, payout.first) ? 200 : 100;
+        BOOST_CHECK_EQUAL(payout.first == 1 ? 560 : expected, payout.second);
+    }
+
+    const modulo::ver_2::PayoutDistribution& lottery = distributions[1];
+    BOOST_CHECK_EQUAL(100U, lottery.argument);
+    BOOST_REQUIRE_EQUAL(1U, lottery.payouts.size());
+    BOOST_CHECK_EQUAL(7U, lottery.payouts[0].first);
+    BOOST_CHECK_EQUAL(500, lottery.payouts[0].second);
+    BOOST_CHECK_EQUAL(5, lottery.getExpectedPayout());
+    const std::map<CAmount, uint64_t> lotteryHistogram{{0, 99}, {500, 1}};
+    BOOST_CHECK(lotteryHistogram == lottery.getHistogram());
+}
+
+BOOST_AUTO_TEST_CASE(MakebetSimulationTest_SparseToDense)
+{
+    // payouts of an argument are kept per winning outcome until they cover half of its outcomes
+    modulo::ver_2::BetSimulation simulation;
+    std::string error;
+    for (const char* bet : {"4_1@1", "4_1@2", "4_3@3"})
+    {
+        CMutableTransaction txn;
+        prepareTransaction(txn);
+        txn.vout[0].scriptPubKey = CScript() << OP_RETURN << ParseHex(GAME_TAG + toHex(bet));
+        BOOST_CHECK_EQUAL(true, simulation.addBet(CTransaction(txn), error));
+    }
+    BOOST_CHECK_EQUAL(false, simulation.isFull());
+
+    const std::vector<modulo::ver_2::PayoutDistribution> distributions = simulation.getDistributions();
+    BOOST_REQUIRE_EQUAL(1U, distributions.size());
+    const std::vector<std::pair<unsigned int, CAmount>> payouts{{1, 12}, {3, 12}};
+    BOOST_CHECK(payouts == distributions[0].payouts);
+    const std::map<CAmount, uint64_t> histogram{{0, 2}, {12, 2}};
+    BOOST_CHECK(histogram == distributions[0].getHistogram());
+}
+
+BOOST_AUTO_TEST_CASE(MakebetParsedBetTest_RouletteTables)
+{
+    const struct {
+        std::string type;
+        const int* numbers;
+        int len;
+        int rows;
+    } tables[] = {
+        {"split_", &modulo::split[0][0], 2, 57},
+        {"street_", &modulo::street[0][0], 3, 12},
+        {"corner_", &modulo::corner[0][0], 4, 22},
+        {"line_", &modulo::line[0][0], 6, 11},
+        {"column_", &modulo::column[0][0], 12, 3},
+        {"dozen_", &modulo::dozen[0][0], 12, 3},
+        {"low", modulo::low, 18, 0},
+        {"HIGH", modulo::high, 18, 0},
+        {"even", modulo::even, 18, 0},
+        {"odd", modulo::odd, 18, 0},
+        {"RED", modulo::red, 18, 0},
+        {"black", modulo::black, 18, 0},
+    };
+
+    for (const auto& table : tables)
+    {
+        for (int row = 0; row < std::max(table.rows, 1); ++row)
+        {
+            const std::string type = table.rows ? table.type + std::to_string(row + 1) : table.type;
+            const int* numbers = table.numbers + row * table.len;
+            const modulo::Leg leg = modulo::parseBetLeg(type);
+            BOOST_CHECK_EQUAL(36 / table.len, modulo::getBetReward(leg, 36));
+            BOOST_CHECK_EQUAL(0, modulo::getBetReward(leg, 37));
+            for (unsigned int argument = 1; argument <= 36; ++argument)
+            {
+                const bool expected = std::find(numbers, numbers + table.len, (int)argument) != numbers + table.len;
+                BOOST_CHECK_EQUAL(expected, modulo::isBetWinning(leg, 36, argument));
+            }
+        }
+    }
+
+    const modulo::Leg straight = modulo::parseBetLeg("straight_7");
+    BOOST_CHECK_EQUAL(36, modulo::getBetReward(straight, 36));
+    BOOST_CHECK(modulo::isBetWinning(straight, 36, 7));
+    BOOST_CHECK(!modulo::isBetWinning(straight, 36, 8));
+    BOOST_CHECK_THROW(modulo::isBetWinning(modulo::parseBetLeg("split_58"), 36, 1), std::runtime_error);
+    BOOST_CHECK_THROW(modulo::isBetWinning(modulo::parseBetLeg("corner_x"), 36, 1), std::runtime_error);
+    BOOST_CHECK(!modulo::isBetWinning(modulo::parseBetLeg("dummy_4"), 36, 4));
+
+    const modulo::Leg lottery = modulo::parseBetLeg("16");
+    BOOST_CHECK_EQUAL(1000, modulo::getBetReward(lottery, 1000));
+    BOOST_CHECK(modulo::isBetWinning(lottery, 1000, 16));
+    BOOST_CHECK_THROW(modulo::isBetWinning(lottery, 10, 1), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(MakebetParsedBetTest_ParseAndCache)
+{
+    CMutableTransaction txn;
+    prepareTransaction(txn);
+
+    const std::string command = "24_straight_4@300000000+split_2@100+red@5";
+    txn.vout[0].nValue = 300000105;
+    txn.vout[0].scriptPubKey = CScript() << OP_RETURN << ParseHex(GAME_TAG + toHex(command));
+    const CTransaction tx(txn);
+
+    const modulo::ParsedBetRef bet = modulo::getParsedBet(tx);
+    BOOST_CHECK_EQUAL(bet->status, modulo::ParsedBet::OK);
+    BOOST_CHECK_EQUAL(bet->opReturnIdx, 0U);
+    BOOST_CHECK_EQUAL(bet->argument, 36U);
+    BOOST_REQUIRE_EQUAL(bet->legs.size(), 3U);
+    BOOST_CHECK(bet->legs[0].kind == modulo::BetKind::STRAIGHT);
+    BOOST_CHECK_EQUAL(bet->legs[0].index, 4);
+    BOOST_CHECK_EQUAL(bet->legs[0].amount, 300000000);
+    BOOST_CHECK(bet->legs[1].kind == modulo::BetKind::SPLIT);
+    BOOST_CHECK_EQUAL(bet->legs[1].index, 2);
+    BOOST_CHECK(bet->legs[2].kind == modulo::BetKind::RED);
+    BOOST_CHECK_EQUAL(bet->legs[2].amount, 5);
+    BOOST_CHECK_EQUAL(bet.get(), modulo::getParsedBet(tx).get());
+
+    txn.vout[0].scriptPubKey = CScript() << OP_RETURN << ParseHex(GAME_TAG + toHex("24_red@5+black"));
+    modulo::ParsedBet missingAt = modulo::parseBet(CTransaction(txn));
+    BOOST_CHECK_EQUAL(missingAt.status, modulo::ParsedBet::MISSING_AT);
+    BOOST_CHECK_EQUAL(missingAt.legs.size(), 1U);
+
+    txn.vout[0].scriptPubKey = CScript() << OP_RETURN << ParseHex(GAME_TAG + toHex("24_red@x"));
+    BOOST_CHECK_EQUAL(modulo::parseBet(CTransaction(txn)).status, modulo::ParsedBet::BAD_AMOUNT);
+
+    txn.vout[0].scriptPubKey = CScript() << OP_RETURN << ParseHex(GAME_TAG + toHex("red@5"));
+    BOOST_CHECK_EQUAL(modulo::parseBet(CTransaction(txn)).status, modulo::ParsedBet::BAD_ARGUMENT);
+
+    txn.vout[0].scriptPubKey = CScript() << ParseHex(GAME_TAG + toHex(command));
+    BOOST_CHECK_EQUAL(modulo::parseBet(CTransaction(txn)).status, modulo::ParsedBet::EMPTY_PAYLOAD);
+}
+
+BOOST_AUTO_TEST_CASE(MakebetParsedBetTest_BlockHashArgument)
+{
+    const uint256 hash = uint256S("00000000000003a2f4e0b8f8d6a27bb1b9a6f1c2d3e4f5a6b7c8d9e0f1a2b3c4");
+    BOOST_CHECK_EQUAL(blockHashStr2Int(hash.ToString()), blockHash2Int(hash));
+}
+
+BOOST_AUTO_TEST_CASE(MakebetWinningBetsIndexTest)
+{
+    CBlock block;
+    block.vtx.push_back(MakeTransactionRef(CMutableTransaction()));
+    for (const std::string command : {"2_1@100", "2_2@100"}) {
+        CMutableTransaction txn;
+        prepareTransaction(txn);
+        txn.vout[0].nValue = 100;
+        txn.vout[0].scriptPubKey = CScript() << OP_RETURN << ParseHex(GAME_TAG + toHex(command));
+        block.vtx.push_back(MakeTransactionRef(std::move(txn)));
+    }
+
+    // exactly one of the two lottery bets wins, whatever the block hash is
+    const uint256 hash = block.GetHash();
+    const unsigned int winningIdx = blockHash2Int(hash) % 2;
+    const modulo::ver_2::WinningBetsRef bets = modulo::ver_2::computeWinningBets(block, hash);
+    BOOST_REQUIRE_EQUAL(bets->size(), 1U);
+    BOOST_CHECK_EQUAL((*bets)[0].idx, winningIdx);
+    BOOST_CHECK((*bets)[0].hash == block.vtx[winningIdx + 1]->GetHash());
+    BOOST_CHECK_EQUAL((*bets)[0].payoff, 200);
+    BOOST_CHECK((*bets)[0].keyID == getTxKeyID(*block.vtx[winningIdx + 1]));
+
+    // results are reduced in block order, whatever order the checks ran in
+    std::vector<modulo::ver_2::MakeBetResult> results;
+    std::vector<modulo::ver_2::MakeBetCheck> checks = modulo::ver_2::makeBetChecks(block, hash, results);
+    BOOST_REQUIRE_EQUAL(checks.size(), 2U);
+    for (auto it = checks.rbegin(); it != checks.rend(); ++it) {
+        BOOST_CHECK((*it)());
+    }
+    const modulo::ver_2::WinningBetsRef reduced = modulo::ver_2::reduceWinningBets(block, results);
+    BOOST_REQUIRE_EQUAL(reduced->size(), 1U);
+    BOOST_CHECK((*reduced)[0].hash == (*bets)[0].hash);
+    BOOST_CHECK_EQUAL((*reduced)[0].idx, (*bets)[0].idx);
+    BOOST_CHECK_EQUAL((*reduced)[0].payoff, (*bets)[0].payoff);
+    BOOST_CHECK_THROW(modulo::ver_2::reduceWinningBets(block, std::vector<modulo::ver_2::MakeBetResult>(2)), std::runtime_error);
+
+    // a makebet that can not be evaluated does not win, and does not fail its check
+    CBlock badBlock;
+    badBlock.vtx.push_back(MakeTransactionRef(CMutableTransaction()));
+    {
+        CMutableTransaction txn;
+        prepareTransaction(txn);
+        txn.vout[0].nValue = 100;
+        txn.vout[0].scriptPubKey = CScript() << OP_RETURN << ParseHex(GAME_TAG + toHex("red@100"));
+        badBlock.vtx.push_back(MakeTransactionRef(std::move(txn)));
+    }
+    std::vector<modulo::ver_2::MakeBetResult> badResults;
+    std::vector<modulo::ver_2::MakeBetCheck> badChecks = modulo::ver_2::makeBetChecks(badBlock, hash, badResults);
+    BOOST_REQUIRE_EQUAL(badChecks.size(), 1U);
+    BOOST_CHECK(badChecks[0]());
+    BOOST_CHECK(badResults[0].evaluated);
+    BOOST_CHECK_EQUAL(badResults[0].payoff, 0);
+    BOOST_CHECK(modulo::ver_2::reduceWinningBets(badBlock, badResults)->empty());
+
+    CBlockIndex index;
+    index.phashBlock = &hash;
+    modulo::ver_2::WinningBetsIndex winningBets;
+
+    // a lookup by block evaluates a miss without adding it
+    const modulo::ver_2::WinningBetsRef missed = winningBets.getWinningBets(block, hash);
+    BOOST_REQUIRE_EQUAL(missed->size(), 1U);
+    BOOST_CHECK(winningBets.getWinningBets(block, hash).get() != missed.get());
+    BOOST_CHECK(winningBets.getWinningBets(&index, Params().GetConsensus()) == nullptr);
+
+    winningBets.connectBlock(block, hash, results);
+    const modulo::ver_2::WinningBetsRef cached = winningBets.getWinningBets(&index, Params().GetConsensus());
+    BOOST_REQUIRE(cached != nullptr);
+    BOOST_CHECK_EQUAL(cached->size(), 1U);
+    BOOST_CHECK_EQUAL(cached.get(), winningBets.getWinningBets(&index, Params().GetConsensus()).get());
+    BOOST_CHECK_EQUAL(cached.get(), winningBets.getWinningBets(block, hash).get());
+
+    // block is not on disk, so it can't be recovered after disconnecting
+    winningBets.disconnectBlock(hash);
+    BOOST_CHECK(winningBets.getWinningBets(&index, Params().GetConsensus()) == nullptr);
+    BOOST_CHECK(winningBets.getWinningBets(nullptr, Params().GetConsensus()) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(MakebetOpReturnDataTest)
+{
+    for (size_t size : {0, 1, 75, 76, 255, 256, 65535, 65536}) {
+        const std::vector<unsigned char> payload(size, 0x5a);
+        const CScript script = CScript() << OP_RETURN << payload;
+        Span<const unsigned char> data;
+        BOOST_CHECK(getOpReturnData(script, data));
+        BOOST_CHECK_EQUAL(data.size(), static_cast<std::ptrdiff_t>(size));
+        BOOST_CHECK(std::equal(payload.begin(), payload.end(), data.begin()));
+        // the payload is referenced in place
+        BOOST_CHECK(data.end() == script.data() + script.size());
+    }
+
+    Span<const unsigned char> data;
+    BOOST_CHECK(!getOpReturnData(CScript(), data));
+    BOOST_CHECK(!getOpReturnData(CScript() << OP_RETURN, data));
+    BOOST_CHECK(!getOpReturnData(CScript() << OP_RETURN << OP_1, data));
+    BOOST_CHECK(!getOpReturnData(CScript() << OP_RETURN << ParseHex("00") << ParseHex("00"), data));
+    BOOST_CHECK(!getOpReturnData(CScript() << ParseHex("00"), data));
+
+    CScript truncated = CScript() << OP_RETURN << std::vector<unsigned char>(10, 0);
+    truncated.pop_back();
+    BOOST_CHECK(!getOpReturnData(truncated, data));
+
+    CMutableTransaction txn;
+    prepareTransaction(txn);
+    txn.vout.resize(2);
+    txn.vout[0].scriptPubKey = CScript() << OP_TRUE;
+    txn.vout[1].scriptPubKey = CScript() << OP_RETURN << ParseHex(GAME_TAG + toHex("24_red@5"));
+    const CTransaction tx(txn);
+    size_t idx;
+    BOOST_CHECK(getOpReturnData(tx, data, idx));
+    BOOST_CHECK_EQUAL(idx, 1U);
+    BOOST_CHECK_EQUAL(getBetType(tx), std::string(data.begin(), data.end()));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
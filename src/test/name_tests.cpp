@@ -8,6 +8,7 @@
 #include <key_io.h>
 #include <names/encoding.h>
 #include <names/main.h>
+#include <names/snapshot.h>
 #include <policy/policy.h>
 #include <primitives/transaction.h>
 #include <script/names.h>
@@ -169,6 +170,49 @@ BOOST_AUTO_TEST_CASE (name_database)
   BOOST_CHECK (setRet == setExpected);
 }
 
+BOOST_AUTO_TEST_CASE (name_cache_memory)
+{
+  const CScript addr = getTestAddress ();
+  const valtype name = DecodeName ("memory-test-name", NameEncoding::ASCII);
+
+  CNameData small, big;
+  small.fromScript (100, COutPoint (uint256 (), 0),
+                    CNameScript (CNameScript::buildNameUpdate (
+                        addr, name, valtype (10, 'x'))));
+  big.fromScript (100, COutPoint (uint256 (), 0),
+                  CNameScript (CNameScript::buildNameUpdate (
+                      addr, name, valtype (1000, 'x'))));
+
+  CNameCache cache;
+  cache.set (name, small);
+  const size_t usageSmall = cache.DynamicMemoryUsage ();
+  BOOST_CHECK (usageSmall > 0);
+
+  /* Replacing values must account the difference only.  */
+  cache.set (name, big);
+  BOOST_CHECK (cache.DynamicMemoryUsage () >= usageSmall + 1000 - 10);
+  cache.set (name, small);
+  BOOST_CHECK_EQUAL (cache.DynamicMemoryUsage (), usageSmall);
+
+  const bool oldHistory = fNameHistory;
+  fNameHistory = true;
+  cache.writeHistoryEntry (name, 0, big);
+  const size_t usageHistory = cache.DynamicMemoryUsage ();
+  BOOST_CHECK (usageHistory >= usageSmall + 1000);
+  cache.writeHistoryEntry (name, 0, small);
+  BOOST_CHECK (cache.DynamicMemoryUsage () < usageHistory - 900);
+  cache.writeHistoryEntry (name, 0, big);
+  BOOST_CHECK_EQUAL (cache.DynamicMemoryUsage (), usageHistory);
+  fNameHistory = oldHistory;
+
+  const size_t usageNoExpire = cache.DynamicMemoryUsage ();
+  cache.addExpireIndex (name, 100);
+  const size_t usageExpire = cache.DynamicMemoryUsage ();
+  BOOST_CHECK (usageExpire > usageNoExpire);
+  cache.removeExpireIndex (name, 100);
+  BOOST_CHECK_EQUAL (cache.DynamicMemoryUsage (), usageExpire);
+}
+
 /* ************************************************************************** */
 
 /**
@@ -479,6 +523,69 @@ BOOST_AUTO_TEST_CASE (name_iteration)
   tester.update ("aa");
 }
 
+static std::vector<std::string>
+iteratePrefix (const CCoinsView& view, const std::string& prefix,
+               const std::string& start)
+{
+  CNamePrefixIterator iter(view.IterateNames (),
+                           DecodeName (prefix, NameEncoding::ASCII));
+  iter.seek (DecodeName (start, NameEncoding::ASCII));
+
+  std::vector<std::string> res;
+  valtype name;
+  CNameData data;
+  while (iter.next (name, data))
+    res.push_back (EncodeName (name, NameEncoding::ASCII));
+
+  return res;
+}
+
+BOOST_AUTO_TEST_CASE (name_prefix_iteration)
+{
+  const CScript addr = getTestAddress ();
+  const valtype value = DecodeName ("value", NameEncoding::ASCII);
+
+  CCoinsViewCache view(pcoinsTip.get ());
+  unsigned height = 100;
+  for (const std::string n : {"a", "b", "aa", "ab", "ba", "abc", "abz",
+                               "bab", "x/ab", "d/abc"})
+    {
+      const valtype name = DecodeName (n, NameEncoding::ASCII);
+      const CNameScript op(CNameScript::buildNameUpdate (addr, name, value));
+      CNameData data;
+      data.fromScript (height++, COutPoint (uint256 (), 0), op);
+      view.SetName (name, data, false);
+
+      /* Keep some of the names only in the cache.  */
+      if (n == "abc")
+        BOOST_CHECK (view.Flush ());
+    }
+
+  typedef std::vector<std::string> Names;
+  BOOST_CHECK (iteratePrefix (view, "a", "")
+                == Names ({"a", "aa", "ab", "abc", "abz"}));
+  BOOST_CHECK (iteratePrefix (view, "ab", "")
+                == Names ({"ab", "abc", "abz"}));
+  BOOST_CHECK (iteratePrefix (view, "ab", "abd") == Names ({"abz"}));
+  BOOST_CHECK (iteratePrefix (view, "a", "b") == Names ({"aa", "ab", "abc", "abz"}));
+  BOOST_CHECK (iteratePrefix (view, "b", "bb") == Names ({"bab"}));
+  BOOST_CHECK (iteratePrefix (view, "c", "").empty ());
+  BOOST_CHECK (iteratePrefix (view, "", "abz")
+                == Names ({"abz", "bab", "x/ab", "d/abc"}));
+
+  /* The names were updated at heights 100 to 109 in order, query a range
+     spanning both the flushed and the cached names.  */
+  std::set<CNameCache::ExpireEntry> entries;
+  BOOST_CHECK (view.GetNamesForHeights (104, 106, entries));
+  std::set<valtype> names;
+  for (const auto& entry : entries)
+    names.insert (entry.name);
+  BOOST_CHECK (names == std::set<valtype> ({
+      DecodeName ("ba", NameEncoding::ASCII),
+      DecodeName ("abc", NameEncoding::ASCII),
+      DecodeName ("abz", NameEncoding::ASCII)}));
+}
+
 /* ************************************************************************** */
 
 /**
@@ -770,6 +877,260 @@ BOOST_AUTO_TEST_CASE (name_updates_undo)
   BOOST_CHECK (undo.vnameundo.empty ());
 }
 
+BOOST_AUTO_TEST_CASE (name_history_depth)
+{
+  const bool oldHistory = fNameHistory;
+  fNameHistory = true;
+  nNameHistoryDepth = 2;
+
+  const valtype name = DecodeName ("history-depth-test", NameEncoding::ASCII);
+  const CScript addr = getTestAddress ();
+
+  std::vector<CNameData> updates;
+  for (unsigned i = 0; i < 5; ++i)
+    {
+      const valtype value(1, 'a' + i);
+      CNameData data;
+      data.fromScript (100 + i, COutPoint (uint256 (), i),
+                       CNameScript (CNameScript::buildNameUpdate (
+                           addr, name, value)));
+      updates.push_back (data);
+    }
+
+  /* Push the updates partly through to the database, so that the history
+     is read back from both the database and the cache.  */
+  CCoinsViewCache view(pcoinsdbview.get ());
+  uint256 dummyBlockHash;
+  *dummyBlockHash.begin () = 1;
+  view.SetBestBlock (dummyBlockHash);
+  for (unsigned i = 0; i < updates.size (); ++i)
+    {
+      view.SetName (name, updates[i], false);
+      if (i == 2)
+        BOOST_CHECK (view.Flush ());
+    }
+
+  /* Four entries were pushed, only the last two are kept.  */
+  CNameHistory history;
+  BOOST_CHECK (view.GetNameHistory (name, history));
+  BOOST_CHECK_EQUAL (history.getEnd (), 4);
+  BOOST_CHECK (history.getData ()
+                == std::vector<CNameData> ({updates[2], updates[3]}));
+  CNameData entry;
+  BOOST_CHECK (!view.GetNameHistoryEntry (name, 1, entry));
+  BOOST_CHECK (view.GetNameHistoryEntry (name, 3, entry));
+  BOOST_CHECK (entry == updates[3]);
+
+  BOOST_CHECK (view.Flush ());
+  BOOST_CHECK (pcoinsdbview->GetNameHistory (name, history));
+  BOOST_CHECK_EQUAL (history.getEnd (), 4);
+  BOOST_CHECK (history.getData ()
+                == std::vector<CNameData> ({updates[2], updates[3]}));
+
+  /* Undo all updates, also beyond the pruned entries.  */
+  for (unsigned i = updates.size () - 1; i > 0; --i)
+    view.SetName (name, updates[i - 1], true);
+  BOOST_CHECK (!view.GetNameHistory (name, history));
+  view.DeleteName (name);
+  BOOST_CHECK (view.Flush ());
+  BOOST_CHECK (!pcoinsdbview->GetNameHistory (name, history));
+
+  nNameHistoryDepth = DEFAULT_NAME_HISTORY_DEPTH;
+  fNameHistory = oldHistory;
+}
+
+/* ************************************************************************** */
+
+BOOST_AUTO_TEST_CASE (name_db_check)
+{
+  const valtype name = DecodeName ("checked-name", NameEncoding::ASCII);
+  const valtype value = DecodeName ("value", NameEncoding::ASCII);
+  const CScript scr
+    = CNameScript::buildNameUpdate (getTestAddress (), name, value);
+  const unsigned nHeight = 100;
+
+  CCoinsViewDB db(1 << 20, true);
+  CCoinsViewCache view(&db);
+
+  /* A name held by the coin at its update outpoint is consistent, both for
+     the per-name check and the full scan of the database.  */
+  const COutPoint outp = addTestCoin (scr, nHeight, view);
+  CNameData data;
+  data.fromScript (nHeight, outp, CNameScript (scr));
+  view.SetName (name, data, false);
+  BOOST_CHECK (CheckName (view, name, nHeight));
+  BOOST_CHECK (view.Flush ());
+  BOOST_CHECK (CheckName (db, name, nHeight));
+  {
+    std::unique_ptr<CDBIterator> cursor(db.SnapshotCursor ());
+    BOOST_CHECK (CCoinsViewDB::ValidateNameDB (*cursor, nHeight));
+  }
+
+  /* Spend the name coin without touching the name entry.  */
+  BOOST_CHECK (view.SpendCoin (outp));
+  BOOST_CHECK (!CheckName (view, name, nHeight));
+  BOOST_CHECK (view.Flush ());
+  BOOST_CHECK (!CheckName (db, name, nHeight));
+  {
+    std::unique_ptr<CDBIterator> cursor(db.SnapshotCursor ());
+    BOOST_CHECK (!CCoinsViewDB::ValidateNameDB (*cursor, nHeight));
+  }
+}
+
+/* ************************************************************************** */
+
+BOOST_AUTO_TEST_CASE (name_state_snapshot)
+{
+  const bool oldHistory = fNameHistory;
+  fNameHistory = true;
+
+  const valtype name1 = DecodeName ("snapshot-1", NameEncoding::ASCII);
+  const valtype name2 = DecodeName ("snapshot-2", NameEncoding::ASCII);
+  const CScript addr = getTestAddress ();
+
+  std::vector<CNameData> updates;
+  for (unsigned i = 0; i < 70; ++i)
+    {
+      const valtype value(1, 'a' + i % 26);
+      CNameData data;
+      data.fromScript (100 + i, COutPoint (uint256 (), i),
+                       CNameScript (CNameScript::buildNameUpdate (
+                           addr, name1, value)));
+      updates.push_back (data);
+    }
+
+  CCoinsViewDB db(1 << 20, true);
+  uint256 hash;
+  *hash.begin () = 1;
+  {
+    CCoinsViewCache view(&db);
+    view.SetBestBlock (hash);
+    view.SetName (name1, updates[0], false);
+    BOOST_CHECK (view.Flush ());
+  }
+
+  /* The database snapshot does not see later writes, the changes of a
+     block are seen only by the state published after it.  */
+  std::shared_ptr<const CCoinsView> base(db.Snapshot ());
+  BOOST_CHECK (base->GetBestBlock () == hash);
+  const auto first = std::make_shared<const CNameStateSnapshot> (base, hash, 1);
+
+  CNameStateSnapshotRef second;
+  {
+    CCoinsViewCache view(&db);
+    view.SetName (name1, updates[1], false);
+    view.SetName (name2, updates[2], false);
+    *hash.begin () = 2;
+    second = first->withChanges (view.GetNameChanges (), hash, 2);
+    view.SetBestBlock (hash);
+    BOOST_CHECK (view.Flush ());
+  }
+
+  CNameData data;
+  CNameHistory history;
+  BOOST_CHECK (first->getName (name1, data) && data == updates[0]);
+  BOOST_CHECK (!first->getName (name2, data));
+  BOOST_CHECK (!first->getNameHistory (name1, history));
+  BOOST_CHECK (second->getBlockHash () == hash);
+  BOOST_CHECK_EQUAL (second->getHeight (), 2);
+  BOOST_CHECK (second->getName (name1, data) && data == updates[1]);
+  BOOST_CHECK (second->getName (name2, data) && data == updates[2]);
+  BOOST_CHECK (second->getNameHistory (name1, history));
+  BOOST_CHECK (history.getData () == std::vector<CNameData> ({updates[0]}));
+
+  /* Publish many more blocks, so that their changes are merged into runs.
+     The result must match the database.  */
+  CNameStateSnapshotRef state = second;
+  for (unsigned i = 3; i < updates.size (); ++i)
+    {
+      CCoinsViewCache view(&db);
+      view.SetName (name1, updates[i], false);
+      if (i == 3)
+        view.DeleteName (name2);
+      *hash.begin () = i;
+      state = state->withChanges (view.GetNameChanges (), hash, i);
+      view.SetBestBlock (hash);
+      BOOST_CHECK (view.Flush ());
+    }
+
+  CNameHistory dbHistory;
+  BOOST_CHECK (!state->getName (name2, data));
+  BOOST_CHECK (second->getName (name2, data));
+  BOOST_CHECK (state->getName (name1, data) && data == updates.back ());
+  BOOST_CHECK (state->getNameHistory (name1, history));
+  BOOST_CHECK (db.GetNameHistory (name1, dbHistory));
+  BOOST_CHECK_EQUAL (history.getEnd (), updates.size () - 1);
+  BOOST_CHECK (history.getData () == dbHistory.getData ());
+  BOOST_CHECK (state->DynamicMemoryUsage () > second->DynamicMemoryUsage ());
+
+  /* Iterating a state sees its own names, not those written to the
+     database since its snapshot was taken.  */
+  {
+    valtype name;
+    std::unique_ptr<CNameIterator> iter(second->iterateNames ());
+    BOOST_CHECK (iter->next (name, data) && name == name1
+                  && data == updates[1]);
+    BOOST_CHECK (iter->next (name, data) && name == name2
+                  && data == updates[2]);
+    BOOST_CHECK (!iter->next (name, data));
+
+    iter.reset (state->iterateNames ());
+    BOOST_CHECK (iter->next (name, data) && name == name1
+                  && data == updates.back ());
+    BOOST_CHECK (!iter->next (name, data));
+  }
+
+  /* A state created at the tip sees the name changes not yet flushed to
+     the database, and is not merged with the changes of later blocks.  */
+  {
+    LOCK (cs_main);
+    pcoinsTip->SetName (name2, updates[2], false);
+    const CNameStateSnapshotRef created = CreateNameStateSnapshot ();
+    BOOST_CHECK (created != nullptr);
+    BOOST_CHECK (GetPublishedNameState () == created);
+    BOOST_CHECK (created->getBlockHash () == pcoinsTip->GetBestBlock ());
+    BOOST_CHECK (created->getName (name2, data) && data == updates[2]);
+    BOOST_CHECK (!pcoinsdbview->GetName (name2, data));
+
+    CNameCache blockChanges;
+    blockChanges.set (name1, updates[0]);
+    const auto next = created->withChanges (blockChanges, hash, 1);
+    BOOST_CHECK (next->getName (name1, data) && data == updates[0]);
+    BOOST_CHECK (next->getName (name2, data) && data == updates[2]);
+    BOOST_CHECK (next->DynamicMemoryUsage ()
+                  > created->DynamicMemoryUsage ());
+
+    /* The state is released after a while.  */
+    ExpireNameStateSnapshot (GetTimeMicros ());
+    BOOST_CHECK (GetPublishedNameState () == created);
+    ExpireNameStateSnapshot (GetTimeMicros ()
+                              + (NAME_STATE_SNAPSHOT_INTERVAL + 1) * 1000000);
+    BOOST_CHECK (GetPublishedNameState () == nullptr);
+  }
+
+  /* The published state is dropped if a block does not build on it.  */
+  {
+    LOCK (cs_main);
+    const CNameStateSnapshotRef published = CreateNameStateSnapshot ();
+    BOOST_CHECK (published != nullptr);
+    PublishNameChanges (CNameCache (), published->getBlockHash (), hash, 1,
+                        false);
+    BOOST_CHECK (GetPublishedNameState ()->getBlockHash () == hash);
+    PublishNameChanges (CNameCache (), published->getBlockHash (), hash, 2,
+                        false);
+    BOOST_CHECK (GetPublishedNameState () == nullptr);
+
+    /* Nothing is published during the initial block download.  */
+    CreateNameStateSnapshot ();
+    PublishNameChanges (CNameCache (), published->getBlockHash (), hash, 1,
+                        true);
+    BOOST_CHECK (GetPublishedNameState () == nullptr);
+    ResetNameStateSnapshot ();
+  }
+
+  fNameHistory = oldHistory;
+}
+
 /* ************************************************************************** */
 
 BOOST_AUTO_TEST_CASE (name_expire_utxo)
@@ -1067,6 +1428,21 @@ BOOST_AUTO_TEST_CASE (name_mempool)
   }
   BOOST_CHECK (!mempool.registersName (nameReg));
   BOOST_CHECK (mempool.mapTx.empty ());
+
+  /* Check removing all name conflicts of a block together.  */
+
+  mempool.addUnchecked (entryReg);
+  mempool.addUnchecked (entryUpd);
+  names.clear ();
+  names.insert (nameUpd);
+  {
+    CNameConflictTracker tracker(mempool);
+    mempool.removeForBlock ({MakeTransactionRef (txReg2)}, 1, names);
+    BOOST_CHECK (tracker.GetNameConflicts ()->size () == 2);
+  }
+  BOOST_CHECK (!mempool.registersName (nameReg));
+  BOOST_CHECK (!mempool.updatesName (nameUpd));
+  BOOST_CHECK (mempool.mapTx.empty ());
 }
 
 /* ************************************************************************** */
@@ -9,6 +9,7 @@
 #include <consensus/validation.h>
 #include <crypto/sha256.h>
 #include <miner.h>
+#include <names/snapshot.h>
 #include <net_processing.h>
 #include <pow.h>
 #include <rpc/register.h>
@@ -107,6 +108,9 @@ TestingSetup::TestingSetup(const std::string& chainName) : BasicTestingSetup(cha
         nScriptCheckThreads = 3;
         for (int i=0; i < nScriptCheckThreads-1; i++)
             threadGroup.create_thread(&ThreadScriptCheck);
+        nMakeBetCheckThreads = 2;
+        for (int i=0; i < nMakeBetCheckThreads-1; i++)
+            threadGroup.create_thread(&ThreadMakeBetCheck);
         g_connman = std::unique_ptr<CConnman>(new CConnman(0x1337, 0x1337)); // Deterministic randomness for tests.
         connman = g_connman.get();
         peerLogic.reset(new PeerLogicValidation(connman, scheduler, /*enable_bip61=*/true));
@@ -122,6 +126,10 @@ TestingSetup::~TestingSetup()
         peerLogic.reset();
         UnloadBlockIndex();
         pcoinsTip.reset();
+        {
+            LOCK(cs_main);
+            ResetNameStateSnapshot();
+        }
         pcoinsdbview.reset();
         pblocktree.reset();
 }
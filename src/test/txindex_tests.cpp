@@ -2,6 +2,11 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <data/documentproof.h>
+#include <games/gamesutils.h>
+#include <hash.h>
+#include <index/bettxindex.h>
+#include <index/dataindex.h>
 #include <index/txindex.h>
 #include <script/standard.h>
 #include <test/test_bitcoin.h>
@@ -65,4 +70,151 @@ BOOST_FIXTURE_TEST_CASE(txindex_initial_sync, TestChain100Setup)
     txindex.Stop(); // Stop thread before calling destructor
 }
 
+BOOST_FIXTURE_TEST_CASE(bettxindex_game_txs_only, TestChain100Setup)
+{
+    CMutableTransaction mtx;
+    mtx.vin.resize(1);
+    mtx.vin[0].prevout = COutPoint(m_coinbase_txns[0]->GetHash(), 0);
+    mtx.vout.resize(1);
+    mtx.vout[0].scriptPubKey = GetScriptForDestination(coinbaseKey.GetPubKey().GetID());
+    BOOST_CHECK(!BetTxIndex::IsIndexed(CTransaction(mtx)));
+
+    mtx.nVersion = MAKE_MODULO_NEW_GAME_INDICATOR | CTransaction::CURRENT_VERSION;
+    BOOST_CHECK(BetTxIndex::IsIndexed(CTransaction(mtx)));
+    mtx.nVersion = GET_MODULO_NEW_GAME_INDICATOR | CTransaction::CURRENT_VERSION;
+    BOOST_CHECK(BetTxIndex::IsIndexed(CTransaction(mtx)));
+
+    // data transactions are not bets
+    mtx.nVersion = CTransaction::CURRENT_VERSION;
+    mtx.vout.emplace_back(0, CScript() << OP_RETURN << std::vector<unsigned char>(32, 0xab));
+    BOOST_CHECK(!BetTxIndex::IsIndexed(CTransaction(mtx)));
+
+    // A block with a data transaction and a plain payment spending its output.
+    CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    auto sign = [&](CMutableTransaction& tx) {
+        std::vector<unsigned char> vchSig;
+        uint256 hash = SignatureHash(scriptPubKey, tx, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+        BOOST_CHECK(coinbaseKey.Sign(hash, vchSig));
+        vchSig.push_back((unsigned char)SIGHASH_ALL);
+        tx.vin[0].scriptSig = CScript() << vchSig;
+    };
+
+    CMutableTransaction data_tx;
+    data_tx.vin.resize(1);
+    data_tx.vin[0].prevout = COutPoint(m_coinbase_txns[0]->GetHash(), 0);
+    data_tx.vout.emplace_back(11 * CENT, scriptPubKey);
+    data_tx.vout.emplace_back(0, CScript() << OP_RETURN << std::vector<unsigned char>(32, 0xab));
+    sign(data_tx);
+
+    CMutableTransaction plain_tx;
+    plain_tx.vin.resize(1);
+    plain_tx.vin[0].prevout = COutPoint(data_tx.GetHash(), 0);
+    plain_tx.vout.emplace_back(10 * CENT, scriptPubKey);
+    sign(plain_tx);
+    BOOST_CHECK(!BetTxIndex::IsIndexed(CTransaction(plain_tx)));
+
+    const CBlock block = CreateAndProcessBlock({data_tx, plain_tx}, scriptPubKey);
+    BOOST_REQUIRE(chainActive.Tip()->GetBlockHash() == block.GetHash());
+
+    // The consensus lookup reads the block at the given height only, without any index.
+    const int height = chainActive.Height();
+    BOOST_CHECK_EQUAL(findTxInBlock(data_tx.GetHash(), height)["blockhash"].get_str(), block.GetHash().GetHex());
+    BOOST_CHECK_THROW(findTxInBlock(data_tx.GetHash(), height - 1), std::runtime_error);
+    BOOST_CHECK_THROW(findTxInBlock(data_tx.GetHash(), height + 1), std::runtime_error);
+
+    BetTxIndex bettxindex(1 << 20, true);
+    bettxindex.Start();
+
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!bettxindex.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+
+    // Coinbases are left out even though they carry an OP_RETURN commitment.
+    CTransactionRef tx_disk;
+    uint256 block_hash;
+    for (const auto& txn : m_coinbase_txns) {
+        BOOST_CHECK(!bettxindex.FindTx(txn->GetHash(), block_hash, tx_disk));
+    }
+
+    // Neither the data transaction nor the plain payment is indexed.
+    BOOST_CHECK(!bettxindex.FindTx(data_tx.GetHash(), block_hash, tx_disk));
+    BOOST_CHECK(!bettxindex.FindTx(plain_tx.GetHash(), block_hash, tx_disk));
+
+    bettxindex.Stop(); // Stop thread before calling destructor
+}
+
+BOOST_FIXTURE_TEST_CASE(dataindex_finds_stored_data, TestChain100Setup)
+{
+    CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    const std::vector<unsigned char> payload(32, 0xab);
+
+    CMutableTransaction mtx;
+    mtx.vin.resize(1);
+    mtx.vin[0].prevout = COutPoint(m_coinbase_txns[0]->GetHash(), 0);
+    mtx.vout.resize(1);
+    mtx.vout[0].nValue = 11 * CENT;
+    mtx.vout[0].scriptPubKey = scriptPubKey;
+    mtx.vout.emplace_back(0, CScript() << OP_RETURN << payload);
+
+    std::vector<unsigned char> vchSig;
+    uint256 hash = SignatureHash(scriptPubKey, mtx, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+    BOOST_CHECK(coinbaseKey.Sign(hash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    mtx.vin[0].scriptSig << vchSig;
+
+    const CBlock block = CreateAndProcessBlock({mtx}, scriptPubKey);
+    BOOST_REQUIRE(chainActive.Tip()->GetBlockHash() == block.GetHash());
+
+    DataIndex dataindex(1 << 20, true);
+    dataindex.Start();
+
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!dataindex.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+
+    // The payload is found by its double SHA256, the hash the data RPCs print,
+    // and, being a 32-byte digest, by itself.
+    uint256 payload_hash;
+    CHash256().Write(payload.data(), payload.size()).Finalize(payload_hash.begin());
+    std::vector<DataCommitment> commitments;
+    for (const uint256& data_hash : {payload_hash, uint256(payload)}) {
+        BOOST_CHECK(dataindex.FindData(data_hash, commitments));
+        BOOST_REQUIRE_EQUAL(commitments.size(), 1U);
+        BOOST_CHECK(commitments[0].txid == mtx.GetHash());
+        BOOST_CHECK_EQUAL(commitments[0].height, chainActive.Height());
+        BOOST_CHECK(commitments[0].block_hash == block.GetHash());
+    }
+
+    // A documents commitment is found by its Merkle root.
+    const uint256 root = computeDocumentsRoot({payload_hash, uint256(payload)});
+    CMutableTransaction commitment_tx;
+    commitment_tx.vin.resize(1);
+    commitment_tx.vin[0].prevout = COutPoint(mtx.GetHash(), 0);
+    commitment_tx.vout.emplace_back(10 * CENT, scriptPubKey);
+    commitment_tx.vout.emplace_back(0, CScript() << OP_RETURN << serializeDocumentsCommitment(root, 2));
+    hash = SignatureHash(scriptPubKey, commitment_tx, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+    vchSig.clear();
+    BOOST_CHECK(coinbaseKey.Sign(hash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    commitment_tx.vin[0].scriptSig << vchSig;
+
+    const CBlock commitment_block = CreateAndProcessBlock({commitment_tx}, scriptPubKey);
+    BOOST_CHECK(dataindex.BlockUntilSyncedToCurrentChain());
+    BOOST_CHECK(dataindex.FindData(root, commitments));
+    BOOST_REQUIRE_EQUAL(commitments.size(), 1U);
+    BOOST_CHECK(commitments[0].txid == commitment_tx.GetHash());
+    BOOST_CHECK(commitments[0].block_hash == commitment_block.GetHash());
+
+    BOOST_CHECK(dataindex.FindData(uint256(), commitments));
+    BOOST_CHECK(commitments.empty());
+
+    dataindex.Stop(); // Stop thread before calling destructor
+}
+
 BOOST_AUTO_TEST_SUITE_END()
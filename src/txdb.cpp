@@ -28,6 +28,7 @@ static const char DB_BLOCK_INDEX = 'b';
 
 static const char DB_NAME = 'n';
 static const char DB_NAME_HISTORY = 'h';
+static const char DB_NAME_HISTORY_INFO = 'i';
 static const char DB_NAME_EXPIRY = 'x';
 
 static const char DB_BEST_BLOCK = 'B';
@@ -91,9 +92,52 @@ bool CCoinsViewDB::GetName(const valtype &name, CNameData& data) const {
     return db.Read(std::make_pair(DB_NAME, name), data);
 }
 
+namespace {
+
+/* Database key of a name history entry.  The index is stored big-endian,
+   so that the entries of a name are ordered by index.  */
+std::pair<char, std::pair<valtype, uint32_t>>
+NameHistoryKey(const valtype& name, uint32_t idx)
+{
+    return std::make_pair(DB_NAME_HISTORY, std::make_pair(name, htobe32(idx)));
+}
+
+} // anonymous namespace
+
 bool CCoinsViewDB::GetNameHistory(const valtype &name, CNameHistory& data) const {
+    CNameHistoryInfo info;
+    if (!GetNameHistoryInfo(name, info))
+        return false;
+
+    /* The stored entries are one contiguous range of the database.  */
+    std::unique_ptr<CDBIterator> pcursor(const_cast<CDBWrapper*>(&db)->NewIterator());
+    pcursor->Seek(NameHistoryKey(name, info.first()));
+
+    std::vector<CNameData> entries;
+    entries.reserve(info.nStored);
+    for (uint32_t idx = info.first(); idx < info.nEnd; ++idx, pcursor->Next())
+    {
+        std::pair<char, std::pair<valtype, uint32_t>> key;
+        CNameData entry;
+        if (!pcursor->Valid() || !pcursor->GetKey(key)
+              || key != NameHistoryKey(name, idx) || !pcursor->GetValue(entry))
+            return error("%s : history entry %u of name %s missing",
+                         __func__, idx, EncodeNameForMessage(name));
+        entries.push_back(entry);
+    }
+
+    data = CNameHistory(info.nEnd, std::move(entries));
+    return true;
+}
+
+bool CCoinsViewDB::GetNameHistoryInfo(const valtype &name, CNameHistoryInfo& info) const {
     assert (fNameHistory);
-    return db.Read(std::make_pair(DB_NAME_HISTORY, name), data);
+    return db.Read(std::make_pair(DB_NAME_HISTORY_INFO, name), info);
+}
+
+bool CCoinsViewDB::GetNameHistoryEntry(const valtype &name, uint32_t idx, CNameData& data) const {
+    assert (fNameHistory);
+    return db.Read(NameHistoryKey(name, idx), data);
 }
 
 bool CCoinsViewDB::GetNamesForHeight(unsigned nHeight, std::set<valtype>& names) const {
@@ -128,6 +172,34 @@ bool CCoinsViewDB::GetNamesForHeight(unsigned nHeight, std::set<valtype>& names)
     return true;
 }
 
+/** Read the expire index entries for a range of heights from a cursor.  */
+static void ReadNamesForHeights(CDBIterator* cursor, unsigned nFromHeight, unsigned nToHeight, std::set<CNameCache::ExpireEntry>& entries) {
+    entries.clear();
+
+    std::unique_ptr<CDBIterator> pcursor(cursor);
+
+    const CNameCache::ExpireEntry seekEntry(nFromHeight, valtype ());
+    pcursor->Seek(std::make_pair(DB_NAME_EXPIRY, seekEntry));
+
+    for (; pcursor->Valid(); pcursor->Next())
+    {
+        std::pair<char, CNameCache::ExpireEntry> key;
+        if (!pcursor->GetKey(key) || key.first != DB_NAME_EXPIRY)
+            break;
+
+        assert (key.second.nHeight >= nFromHeight);
+        if (key.second.nHeight > nToHeight)
+            break;
+
+        entries.insert(key.second);
+    }
+}
+
+bool CCoinsViewDB::GetNamesForHeights(unsigned nFromHeight, unsigned nToHeight, std::set<CNameCache::ExpireEntry>& entries) const {
+    ReadNamesForHeights(const_cast<CDBWrapper*>(&db)->NewIterator(), nFromHeight, nToHeight, entries);
+    return true;
+}
+
 class CDbNameIterator : public CNameIterator
 {
 
@@ -140,9 +212,9 @@ public:
 
     /**
      * Construct a new name iterator for the database.
-     * @param db The database to create the iterator for.
+     * @param it The database cursor to read from, taking ownership of it.
      */
-    CDbNameIterator(const CDBWrapper& db);
+    explicit CDbNameIterator(CDBIterator* it);
 
     /* Implement iterator methods.  */
     void seek (const valtype& start);
@@ -150,8 +222,8 @@ public:
 
 };
 
-CDbNameIterator::CDbNameIterator(const CDBWrapper& db)
-    : iter(const_cast<CDBWrapper*>(&db)->NewIterator())
+CDbNameIterator::CDbNameIterator(CDBIterator* it)
+    : iter(it)
 {
     seek(valtype());
 }
@@ -177,7 +249,7 @@ bool CDbNameIterator::next(valtype& name, CNameData& data) {
 }
 
 CNameIterator* CCoinsViewDB::IterateNames() const {
-    return new CDbNameIterator(db);
+    return new CDbNameIterator(const_cast<CDBWrapper*>(&db)->NewIterator());
 }
 
 bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, const CNameCache &names) {
@@ -336,6 +408,50 @@ bool CBlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockF
     return WriteBatch(batch, true);
 }
 
+CDBIterator* CCoinsViewDB::SnapshotCursor() const
+{
+    /* It seems that there are no "const iterators" for LevelDB.  Since we
+       only need read operations on it, use a const-cast to get around
+       that restriction.  LevelDB iterators read from an implicit snapshot,
+       so later writes are not seen by the cursor.  */
+    return const_cast<CDBWrapper*>(&db)->NewIterator();
+}
+
+CCoinsViewDBSnapshot* CCoinsViewDB::Snapshot() const
+{
+    return new CCoinsViewDBSnapshot(db);
+}
+
+uint256 CCoinsViewDBSnapshot::GetBestBlock() const {
+    uint256 hashBestChain;
+    if (!snapshot.Read(DB_BEST_BLOCK, hashBestChain))
+        return uint256();
+    return hashBestChain;
+}
+
+bool CCoinsViewDBSnapshot::GetName(const valtype &name, CNameData& data) const {
+    return snapshot.Read(std::make_pair(DB_NAME, name), data);
+}
+
+bool CCoinsViewDBSnapshot::GetNameHistoryInfo(const valtype &name, CNameHistoryInfo& info) const {
+    assert (fNameHistory);
+    return snapshot.Read(std::make_pair(DB_NAME_HISTORY_INFO, name), info);
+}
+
+bool CCoinsViewDBSnapshot::GetNameHistoryEntry(const valtype &name, uint32_t idx, CNameData& data) const {
+    assert (fNameHistory);
+    return snapshot.Read(NameHistoryKey(name, idx), data);
+}
+
+bool CCoinsViewDBSnapshot::GetNamesForHeights(unsigned nFromHeight, unsigned nToHeight, std::set<CNameCache::ExpireEntry>& entries) const {
+    ReadNamesForHeights(snapshot.NewIterator(), nFromHeight, nToHeight, entries);
+    return true;
+}
+
+CNameIterator* CCoinsViewDBSnapshot::IterateNames() const {
+    return new CDbNameIterator(snapshot.NewIterator());
+}
+
 bool CCoinsViewDB::ValidateNameDB() const
 {
     const uint256 blockHash = GetBestBlock();
@@ -345,11 +461,13 @@ bool CCoinsViewDB::ValidateNameDB() const
     else
         nHeight = mapBlockIndex.find(blockHash)->second->nHeight;
 
-    /* It seems that there are no "const iterators" for LevelDB.  Since we
-       only need read operations on it, use a const-cast to get around
-       that restriction.  */
-    std::unique_ptr<CDBIterator> pcursor(const_cast<CDBWrapper*>(&db)->NewIterator());
-    pcursor->SeekToFirst();
+    std::unique_ptr<CDBIterator> pcursor(SnapshotCursor());
+    return ValidateNameDB(*pcursor, nHeight);
+}
+
+bool CCoinsViewDB::ValidateNameDB(CDBIterator& cursor, unsigned nHeight)
+{
+    cursor.SeekToFirst();
 
     /* Loop over the total database and read interesting
        things to memory.  We later use that to check
@@ -360,12 +478,15 @@ bool CCoinsViewDB::ValidateNameDB() const
     std::set<valtype> namesInDB;
     std::set<valtype> namesInUTXO;
     std::set<valtype> namesWithHistory;
+    std::set<valtype> namesWithHistoryEntries;
+    uint64_t historyEntries = 0;
+    uint64_t historyEntriesExpected = 0;
 
-    for (; pcursor->Valid(); pcursor->Next())
+    for (; cursor.Valid(); cursor.Next())
     {
         boost::this_thread::interruption_point();
         char chType;
-        if (!pcursor->GetKey(chType))
+        if (!cursor.GetKey(chType))
             continue;
 
         switch (chType)
@@ -373,7 +494,7 @@ bool CCoinsViewDB::ValidateNameDB() const
         case DB_COIN:
         {
             Coin coin;
-            if (!pcursor->GetValue(coin))
+            if (!cursor.GetValue(coin))
                 return error("%s : failed to read coin", __func__);
 
             if (!coin.out.IsNull())
@@ -394,12 +515,12 @@ bool CCoinsViewDB::ValidateNameDB() const
         case DB_NAME:
         {
             std::pair<char, valtype> key;
-            if (!pcursor->GetKey(key) || key.first != DB_NAME)
+            if (!cursor.GetKey(key) || key.first != DB_NAME)
                 return error("%s : failed to read DB_NAME key", __func__);
             const valtype& name = key.second;
 
             CNameData data;
-            if (!pcursor->GetValue(data))
+            if (!cursor.GetValue(data))
                 return error("%s : failed to read name value", __func__);
 
             if (nameHeightsData.count(name) > 0)
@@ -415,25 +536,42 @@ bool CCoinsViewDB::ValidateNameDB() const
             break;
         }
 
-        case DB_NAME_HISTORY:
+        case DB_NAME_HISTORY_INFO:
         {
             std::pair<char, valtype> key;
-            if (!pcursor->GetKey(key) || key.first != DB_NAME_HISTORY)
-                return error("%s : failed to read DB_NAME_HISTORY key",
+            if (!cursor.GetKey(key) || key.first != DB_NAME_HISTORY_INFO)
+                return error("%s : failed to read DB_NAME_HISTORY_INFO key",
                              __func__);
             const valtype& name = key.second;
 
+            CNameHistoryInfo info;
+            if (!cursor.GetValue(info) || info.nStored > info.nEnd)
+                return error("%s : bad history info for name %s",
+                             __func__, EncodeNameForMessage(name));
+
             if (namesWithHistory.count(name) > 0)
                 return error("%s : name %s has duplicate history",
                              __func__, EncodeNameForMessage(name));
             namesWithHistory.insert(name);
+            historyEntriesExpected += info.nStored;
+            break;
+        }
+
+        case DB_NAME_HISTORY:
+        {
+            std::pair<char, std::pair<valtype, uint32_t>> key;
+            if (!cursor.GetKey(key) || key.first != DB_NAME_HISTORY)
+                return error("%s : failed to read DB_NAME_HISTORY key",
+                             __func__);
+            namesWithHistoryEntries.insert(key.second.first);
+            ++historyEntries;
             break;
         }
 
         case DB_NAME_EXPIRY:
         {
             std::pair<char, CNameCache::ExpireEntry> key;
-            if (!pcursor->GetKey(key) || key.first != DB_NAME_EXPIRY)
+            if (!cursor.GetKey(key) || key.first != DB_NAME_EXPIRY)
                 return error("%s : failed to read DB_NAME_EXPIRY key",
                              __func__);
             const CNameCache::ExpireEntry& entry = key.second;
@@ -474,7 +612,14 @@ bool CCoinsViewDB::ValidateNameDB() const
             if (nameHeightsData.count(name) == 0)
                 return error("%s : history entry for name '%s' not in main DB",
                              __func__, EncodeNameForMessage(name));
-    } else if (!namesWithHistory.empty ())
+        for (const auto& name : namesWithHistoryEntries)
+            if (namesWithHistory.count(name) == 0)
+                return error("%s : history entries for name '%s' without info",
+                             __func__, EncodeNameForMessage(name));
+        if (historyEntries != historyEntriesExpected)
+            return error("%s : %u name history entries, expected %u",
+                         __func__, historyEntries, historyEntriesExpected);
+    } else if (!namesWithHistory.empty () || historyEntries > 0)
         return error("%s : name_history entries in DB, but"
                      " -namehistory not set", __func__);
 
@@ -492,17 +637,22 @@ CNameCache::writeBatch (CDBBatch& batch) const
        i != entries.end (); ++i)
     batch.Write (std::make_pair (DB_NAME, i->first), i->second);
 
-  for (std::set<valtype>::const_iterator i = deleted.begin ();
-       i != deleted.end (); ++i)
-    batch.Erase (std::make_pair (DB_NAME, *i));
+  for (const auto& name : deleted)
+    batch.Erase (std::make_pair (DB_NAME, name));
 
-  assert (fNameHistory || history.empty ());
-  for (std::map<valtype, CNameHistory>::const_iterator i = history.begin ();
-       i != history.end (); ++i)
-    if (i->second.empty ())
-      batch.Erase (std::make_pair (DB_NAME_HISTORY, i->first));
+  assert (fNameHistory || (historyInfo.empty () && historyEntries.empty ()
+                            && historyErased.empty ()));
+  for (const auto& entry : historyInfo)
+    if (entry.second.empty ())
+      batch.Erase (std::make_pair (DB_NAME_HISTORY_INFO, entry.first));
     else
-      batch.Write (std::make_pair (DB_NAME_HISTORY, i->first), i->second);
+      batch.Write (std::make_pair (DB_NAME_HISTORY_INFO, entry.first),
+                   entry.second);
+  for (const auto& entry : historyEntries)
+    batch.Write (NameHistoryKey (entry.first.first, entry.first.second),
+                 entry.second);
+  for (const auto& key : historyErased)
+    batch.Erase (NameHistoryKey (key.first, key.second));
 
   for (std::map<ExpireEntry, bool>::const_iterator i = expireIndex.begin ();
        i != expireIndex.end (); ++i)
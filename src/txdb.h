@@ -19,6 +19,7 @@
 
 class CBlockIndex;
 class CCoinsViewDBCursor;
+class CCoinsViewDBSnapshot;
 class uint256;
 
 //! No need to periodic flush if at least this much space still available.
@@ -37,6 +38,12 @@ static const int64_t nMaxBlockDBCache = 2;
 // Unlike for the UTXO database, for the txindex scenario the leveldb cache make
 // a meaningful difference: https://github.com/bitcoin/bitcoin/pull/8273#issuecomment-229601991
 static const int64_t nMaxTxIndexCache = 1024;
+//! Max memory allocated to game/data transaction index DB specific cache (MiB)
+static const int64_t nMaxBetTxIndexCache = 32;
+//! Max memory allocated to data commitment index DB specific cache (MiB)
+static const int64_t nMaxDataIndexCache = 32;
+//! Max memory allocated to bet settlement DB specific cache (MiB)
+static const int64_t nMaxBetTrackerCache = 8;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
 
@@ -54,12 +61,26 @@ public:
     std::vector<uint256> GetHeadBlocks() const override;
     bool GetName(const valtype &name, CNameData &data) const override;
     bool GetNameHistory(const valtype &name, CNameHistory &data) const override;
+    bool GetNameHistoryInfo(const valtype &name, CNameHistoryInfo &info) const override;
+    bool GetNameHistoryEntry(const valtype &name, uint32_t idx, CNameData &data) const override;
     bool GetNamesForHeight(unsigned nHeight, std::set<valtype>& data) const override;
+    bool GetNamesForHeights(unsigned nFromHeight, unsigned nToHeight, std::set<CNameCache::ExpireEntry>& entries) const override;
     CNameIterator* IterateNames() const override;
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, const CNameCache &names) override;
     CCoinsViewCursor *Cursor() const override;
     bool ValidateNameDB() const override;
 
+    /**
+     * Cursor over a snapshot of the database, taken when it is created.
+     * Together with the height of the best block at that time, it allows
+     * validating the name DB without holding cs_main.
+     */
+    CDBIterator* SnapshotCursor() const;
+    static bool ValidateNameDB(CDBIterator& cursor, unsigned nHeight);
+
+    //! Name database as of now, readable without cs_main. Must not outlive this view.
+    CCoinsViewDBSnapshot* Snapshot() const;
+
     //! Attempt to update from an older database format. Returns whether an error occurred.
     bool Upgrade();
     size_t EstimateSize() const override;
@@ -87,6 +108,28 @@ private:
     friend class CCoinsViewDB;
 };
 
+/**
+ * Read-only view of the names in a snapshot of the coin database. Only
+ * the best block, lookups of names and their history, the expire index
+ * and name iteration are supported; everything else behaves like an empty
+ * CCoinsView.
+ */
+class CCoinsViewDBSnapshot final : public CCoinsView
+{
+private:
+    CDBSnapshot snapshot;
+
+public:
+    explicit CCoinsViewDBSnapshot(const CDBWrapper &db) : snapshot(db) {}
+
+    uint256 GetBestBlock() const override;
+    bool GetName(const valtype &name, CNameData &data) const override;
+    bool GetNameHistoryInfo(const valtype &name, CNameHistoryInfo &info) const override;
+    bool GetNameHistoryEntry(const valtype &name, uint32_t idx, CNameData &data) const override;
+    bool GetNamesForHeights(unsigned nFromHeight, unsigned nToHeight, std::set<CNameCache::ExpireEntry>& entries) const override;
+    CNameIterator* IterateNames() const override;
+};
+
 /** Access to the block database (blocks/index/) */
 class CBlockTreeDB : public CDBWrapper
 {
@@ -21,9 +21,10 @@
 
 CTxMemPoolEntry::CTxMemPoolEntry(const CTransactionRef& _tx, const CAmount& _nFee,
                                  int64_t _nTime, unsigned int _entryHeight,
-                                 bool _spendsCoinbase, int64_t _sigOpsCost, LockPoints lp)
+                                 bool _spendsCoinbase, int64_t _sigOpsCost, LockPoints lp,
+                                 CAmount betSum, CAmount betPotentialReward)
     : tx(_tx), nFee(_nFee), nTxWeight(GetTransactionWeight(*tx)), nUsageSize(RecursiveDynamicUsage(tx)), nTime(_nTime), entryHeight(_entryHeight),
-    spendsCoinbase(_spendsCoinbase), sigOpCost(_sigOpsCost), lockPoints(lp),
+    spendsCoinbase(_spendsCoinbase), sigOpCost(_sigOpsCost), nBetSum(betSum), nBetPotentialReward(betPotentialReward), lockPoints(lp),
     nameOp()
 {
     nCountWithDescendants = 1;
@@ -416,7 +417,7 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, setEntries &setAnces
     nTransactionsUpdated++;
     totalTxSize += entry.GetTxSize();
     if (minerPolicyEstimator) {minerPolicyEstimator->processTransaction(entry, validFeeEstimate);}
-    names.addUnchecked (entry);
+    names.addUnchecked (*newit);
 
     vTxHashes.emplace_back(tx.GetWitnessHash(), newit);
     newit->vTxHashesIdx = vTxHashes.size() - 1;
@@ -548,6 +549,14 @@ void CTxMemPool::removeForReorg(const CCoinsViewCache *pcoins, unsigned int nMem
 }
 
 void CTxMemPool::removeConflicts(const CTransaction &tx)
+{
+    removeInputConflicts(tx);
+
+    /* Remove conflicting name registrations.  */
+    names.removeConflicts (tx);
+}
+
+void CTxMemPool::removeInputConflicts(const CTransaction &tx)
 {
     // Remove transactions which depend on inputs of tx, recursively
     AssertLockHeld(cs);
@@ -562,15 +571,22 @@ void CTxMemPool::removeConflicts(const CTransaction &tx)
             }
         }
     }
+}
 
-    /* Remove conflicting name registrations.  */
-    names.removeConflicts (tx);
+void CTxMemPool::removeNameConflicts(const std::vector<const CTxMemPoolEntry*>& conflicts)
+{
+    AssertLockHeld(cs);
+    setEntries stage;
+    for (const CTxMemPoolEntry* entry : conflicts) {
+        CalculateDescendants(mapTx.iterator_to(*entry), stage);
+    }
+    RemoveStaged(stage, false, MemPoolRemovalReason::NAME_CONFLICT);
 }
 
 /**
  * Called when a block is connected. Removes from mempool and updates the miner fee estimator.
  */
-void CTxMemPool::removeForBlock(const std::vector<CTransactionRef>& vtx, unsigned int nBlockHeight)
+void CTxMemPool::removeForBlock(const std::vector<CTransactionRef>& vtx, unsigned int nBlockHeight, const std::set<valtype>& expiredNames)
 {
     LOCK(cs);
     std::vector<const CTxMemPoolEntry*> entries;
@@ -592,9 +608,16 @@ void CTxMemPool::removeForBlock(const std::vector<CTransactionRef>& vtx, unsigne
             stage.insert(it);
             RemoveStaged(stage, true, MemPoolRemovalReason::BLOCK);
         }
-        removeConflicts(*tx);
+        removeInputConflicts(*tx);
         ClearPrioritisation(tx->GetHash());
     }
+    // Name conflicts of the whole block are looked up once the block's own
+    // transactions are gone, and removed in a single pass.
+    std::vector<const CTxMemPoolEntry*> nameConflicts;
+    for (const auto& tx : vtx)
+        names.getConflicts(*tx, nameConflicts);
+    names.getExpireConflicts(expiredNames, nameConflicts);
+    removeNameConflicts(nameConflicts);
     lastRollingFeeUpdate = GetTime();
     blockSinceLastRollingFeeBump = true;
 }
@@ -75,6 +75,8 @@ private:
     const unsigned int entryHeight; //!< Chain height when entering the mempool
     const bool spendsCoinbase;      //!< keep track of transactions that spend a coinbase
     const int64_t sigOpCost;        //!< Total sigop cost
+    const CAmount nBetSum;          //!< Sum of the bets of a makebet
+    const CAmount nBetPotentialReward; //!< ... and their potential reward, both counting towards the limits of a block
     int64_t feeDelta;          //!< Used for determining the priority of the transaction for mining in a block
     LockPoints lockPoints;     //!< Track the height and time at which tx was final
 
@@ -98,7 +100,8 @@ public:
     CTxMemPoolEntry(const CTransactionRef& _tx, const CAmount& _nFee,
                     int64_t _nTime, unsigned int _entryHeight,
                     bool spendsCoinbase,
-                    int64_t nSigOpsCost, LockPoints lp);
+                    int64_t nSigOpsCost, LockPoints lp,
+                    CAmount betSum = 0, CAmount betPotentialReward = 0);
 
     const CTransaction& GetTx() const { return *this->tx; }
     CTransactionRef GetSharedTx() const { return this->tx; }
@@ -108,6 +111,8 @@ public:
     int64_t GetTime() const { return nTime; }
     unsigned int GetHeight() const { return entryHeight; }
     int64_t GetSigOpCost() const { return sigOpCost; }
+    CAmount GetBetSum() const { return nBetSum; }
+    CAmount GetBetPotentialReward() const { return nBetPotentialReward; }
     int64_t GetModifiedFee() const { return nFee + feeDelta; }
     size_t DynamicMemoryUsage() const { return nUsageSize; }
     const LockPoints& GetLockPoints() const { return lockPoints; }
@@ -583,7 +588,10 @@ public:
     void removeRecursive(const CTransaction &tx, MemPoolRemovalReason reason = MemPoolRemovalReason::UNKNOWN);
     void removeForReorg(const CCoinsViewCache *pcoins, unsigned int nMemPoolHeight, int flags) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     void removeConflicts(const CTransaction &tx) EXCLUSIVE_LOCKS_REQUIRED(cs);
-    void removeForBlock(const std::vector<CTransactionRef>& vtx, unsigned int nBlockHeight);
+    /** Remove the block's transactions and their conflicts, including the name updates invalidated by expiredNames. */
+    void removeForBlock(const std::vector<CTransactionRef>& vtx, unsigned int nBlockHeight, const std::set<valtype>& expiredNames = std::set<valtype>());
+    /** Remove the given entries, found by CNameMemPool, and their descendants in one pass. */
+    void removeNameConflicts(const std::vector<const CTxMemPoolEntry*>& conflicts) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
     void clear();
     void _clear() EXCLUSIVE_LOCKS_REQUIRED(cs); //lock free
@@ -783,6 +791,8 @@ private:
      *  removal.
      */
     void removeUnchecked(txiter entry, MemPoolRemovalReason reason = MemPoolRemovalReason::UNKNOWN) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Remove transactions spending the same outputs as tx, recursively. */
+    void removeInputConflicts(const CTransaction &tx) EXCLUSIVE_LOCKS_REQUIRED(cs);
 };
 
 /**
@@ -17,6 +17,7 @@
 #include <cuckoocache.h>
 #include <hash.h>
 #include <index/txindex.h>
+#include <names/snapshot.h>
 #include <policy/fees.h>
 #include <policy/policy.h>
 #include <policy/rbf.h>
@@ -49,6 +50,7 @@
 #include <boost/thread.hpp>
 
 #include <games/modulo/moduloverify.h>
+#include <games/modulo/modulobetindex.h>
 
 #if defined(NDEBUG)
 # error "Blockstamp cannot be compiled without assertions."
@@ -219,6 +221,7 @@ Mutex g_best_block_mutex;
 std::condition_variable g_best_block_cv;
 uint256 g_best_block;
 int nScriptCheckThreads = 0;
+int nMakeBetCheckThreads = 0;
 std::atomic_bool fImporting(false);
 std::atomic_bool fReindex(false);
 bool fHavePruned = false;
@@ -729,8 +732,16 @@ static bool AcceptToMemoryPoolWorker(const CChainParams& chainparams, CTxMemPool
             }
         }
 
+        // The bets and their potential reward are limited per block, cache
+        // them so that the block assembler does not parse every bet again.
+        // Bets which can not be parsed are kept out of blocks by a potential
+        // reward over any limit.
+        CAmount nBetPotentialReward = 0, nBetSum = 0;
+        if (!modulo::ver_2::getBetsPotentialReward(nBetPotentialReward, nBetSum, tx))
+            nBetPotentialReward = MAX_MONEY;
+
         CTxMemPoolEntry entry(ptx, nFees, nAcceptTime, chainActive.Height(),
-                              fSpendsCoinbase, nSigOpsCost, lp);
+                              fSpendsCoinbase, nSigOpsCost, lp, nBetSum, nBetPotentialReward);
         unsigned int nSize = entry.GetTxSize();
 
         // Check that the transaction doesn't have an excessive number of
@@ -1663,6 +1674,8 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
          nameUndoIter != blockUndo.vnameundo.rend (); ++nameUndoIter)
       nameUndoIter->apply (view);
 
+    modulo::ver_2::g_winningBets.disconnectBlock(pindex->GetBlockHash());
+
     // move best block pointer to prevout block
     view.SetBestBlock(pindex->pprev->GetBlockHash());
 
@@ -1725,6 +1738,13 @@ void ThreadScriptCheck() {
     scriptcheckqueue.Thread();
 }
 
+static CCheckQueue<modulo::ver_2::MakeBetCheck> makebetcheckqueue(16);
+
+void ThreadMakeBetCheck() {
+    RenameThread("bst-makebetch");
+    makebetcheckqueue.Thread();
+}
+
 // Protected by cs_main
 VersionBitsCache versionbitscache;
 
@@ -2026,6 +2046,20 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
 
     CCheckQueueControl<CScriptCheck> control(fScriptChecks && nScriptCheckThreads ? &scriptcheckqueue : nullptr);
 
+    // Evaluate the makebets of the block on their own pool (-parmakebet) while its scripts are verified.
+    // The checks write into makeBetResults, so it is declared before the control,
+    // whose destructor waits for the checks still running on an early return.
+    std::vector<modulo::ver_2::MakeBetResult> makeBetResults;
+    std::vector<modulo::ver_2::MakeBetCheck> makeBetChecks;
+    CCheckQueueControl<modulo::ver_2::MakeBetCheck> makeBetControl(!fJustCheck && nMakeBetCheckThreads ? &makebetcheckqueue : nullptr);
+    if (!fJustCheck) {
+        makeBetChecks = modulo::ver_2::makeBetChecks(block, pindex->GetBlockHash(), makeBetResults);
+        if (nMakeBetCheckThreads) {
+            makeBetControl.Add(makeBetChecks);
+            makeBetChecks.clear();
+        }
+    }
+
     std::vector<int> prevheights;
     CAmount nFees = 0;
     int nInputs = 0;
@@ -2138,6 +2172,12 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
         setDirtyBlockIndex.insert(pindex);
     }
 
+    // remember winning makebets, the getbet of the next block pays them
+    for (modulo::ver_2::MakeBetCheck& check : makeBetChecks)
+        check();
+    makeBetControl.Wait();
+    modulo::ver_2::g_winningBets.connectBlock(block, pindex->GetBlockHash(), makeBetResults);
+
     assert(pindex->phashBlock);
     // add this block to the view's block chain
     view.SetBestBlock(pindex->GetBlockHash());
@@ -2196,7 +2236,9 @@ bool static FlushStateToDisk(const CChainParams& chainparams, CValidationState &
             nLastFlush = nNow;
         }
         int64_t nMempoolSizeMax = gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
-        int64_t cacheSize = pcoinsTip->DynamicMemoryUsage();
+        // The published name state holds copies of name changes which are not flushed yet.
+        const CNameStateSnapshotRef nameState = GetPublishedNameState();
+        int64_t cacheSize = pcoinsTip->DynamicMemoryUsage() + (nameState ? nameState->DynamicMemoryUsage() : 0);
         int64_t nTotalSpace = nCoinCacheUsage + std::max<int64_t>(nMempoolSizeMax - nMempoolUsage, 0);
         // The cache is large and we're within 10% and 10 MiB of the limit, but we have time now (not in the middle of a block processing).
         bool fCacheLarge = mode == FlushStateMode::PERIODIC && cacheSize > std::max((9 * nTotalSpace) / 10, nTotalSpace - MAX_BLOCK_COINSDB_USAGE * 1024 * 1024);
@@ -2250,9 +2292,15 @@ bool static FlushStateToDisk(const CChainParams& chainparams, CValidationState &
             // Flush the chainstate (which may refer to block index entries).
             if (!pcoinsTip->Flush())
                 return AbortNode(state, "Failed to write to coin database");
+            // The next name state is created on top of the flushed database.
+            ResetNameStateSnapshot();
             nLastFlush = nNow;
             full_flush_completed = true;
         }
+        // Do not pin an old snapshot of the database between full flushes.
+        if (mode == FlushStateMode::PERIODIC) {
+            ExpireNameStateSnapshot(nNow);
+        }
     }
     if (full_flush_completed) {
         // Update best block in wallet (so we can detect restored wallets).
@@ -2368,7 +2416,6 @@ bool CChainState::DisconnectTip(CValidationState& state, const CChainParams& cha
 {
     CBlockIndex *pindexDelete = chainActive.Tip();
     assert(pindexDelete);
-    CheckNameDB (true);
     // Read block from disk.
     std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
     CBlock& block = *pblock;
@@ -2376,12 +2423,15 @@ bool CChainState::DisconnectTip(CValidationState& state, const CChainParams& cha
         return AbortNode(state, "Failed to read block");
     // Apply the block atomically to the chain state.
     std::set<valtype> unexpiredNames;
+    CNameCache nameChanges;
     int64_t nStart = GetTimeMicros();
     {
         CCoinsViewCache view(pcoinsTip.get());
         assert(view.GetBestBlock() == pindexDelete->GetBlockHash());
         if (DisconnectBlock(block, pindexDelete, view, unexpiredNames) != DISCONNECT_OK)
             return error("DisconnectTip(): DisconnectBlock %s failed", pindexDelete->GetBlockHash().ToString());
+        // Published once the block is disconnected from the tip.
+        nameChanges = view.GetNameChanges();
         bool flushed = view.Flush();
         assert(flushed);
     }
@@ -2412,7 +2462,10 @@ bool CChainState::DisconnectTip(CValidationState& state, const CChainParams& cha
     chainActive.SetTip(pindexDelete->pprev);
 
     UpdateTip(pindexDelete->pprev, chainparams);
-    CheckNameDB (true);
+    PublishNameChanges(nameChanges, pindexDelete->GetBlockHash(),
+                       pindexDelete->pprev->GetBlockHash(), pindexDelete->nHeight - 1,
+                       IsInitialBlockDownload());
+    CheckNameDB (block, unexpiredNames, true);
     // Let wallets know transactions went from 1-confirmed to
     // 0-confirmed or conflicted:
     GetMainSignals().BlockDisconnected(pblock, pindexDelete,
@@ -2510,7 +2563,6 @@ public:
 bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainparams, CBlockIndex* pindexNew, const std::shared_ptr<const CBlock>& pblock, ConnectTrace& connectTrace, DisconnectedBlockTransactions &disconnectpool)
 {
     assert(pindexNew->pprev == chainActive.Tip());
-    CheckNameDB (true);
     // Read block from disk.
     int64_t nTime1 = GetTimeMicros();
     std::shared_ptr<const CBlock> pthisBlock;
@@ -2525,6 +2577,7 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
     const CBlock& blockConnecting = *pthisBlock;
     // Apply the block atomically to the chain state.
     std::set<valtype> expiredNames;
+    CNameCache nameChanges;
     int64_t nTime2 = GetTimeMicros(); nTimeReadFromDisk += nTime2 - nTime1;
     int64_t nTime3;
     LogPrint(BCLog::BENCH, "  - Load block from disk: %.2fms [%.2fs]\n", (nTime2 - nTime1) * MILLI, nTimeReadFromDisk * MICRO);
@@ -2539,6 +2592,8 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
         }
         nTime3 = GetTimeMicros(); nTimeConnectTotal += nTime3 - nTime2;
         LogPrint(BCLog::BENCH, "  - Connect total: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime3 - nTime2) * MILLI, nTimeConnectTotal * MICRO, nTimeConnectTotal * MILLI / nBlocksTotal);
+        // Published once the block is connected as the tip.
+        nameChanges = view.GetNameChanges();
         bool flushed = view.Flush();
         assert(flushed);
     }
@@ -2550,13 +2605,14 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
     int64_t nTime5 = GetTimeMicros(); nTimeChainState += nTime5 - nTime4;
     LogPrint(BCLog::BENCH, "  - Writing chainstate: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime5 - nTime4) * MILLI, nTimeChainState * MICRO, nTimeChainState * MILLI / nBlocksTotal);
     // Remove conflicting transactions from the mempool.;
-    mempool.removeForBlock(blockConnecting.vtx, pindexNew->nHeight);
-    mempool.removeExpireConflicts(expiredNames);
+    mempool.removeForBlock(blockConnecting.vtx, pindexNew->nHeight, expiredNames);
     disconnectpool.removeForBlock(blockConnecting.vtx);
     // Update chainActive & related variables.
     chainActive.SetTip(pindexNew);
     UpdateTip(pindexNew, chainparams);
-    CheckNameDB (false);
+    PublishNameChanges(nameChanges, pindexNew->pprev ? pindexNew->pprev->GetBlockHash() : uint256(),
+                       pindexNew->GetBlockHash(), pindexNew->nHeight, IsInitialBlockDownload());
+    CheckNameDB (blockConnecting, expiredNames, false);
 
     int64_t nTime6 = GetTimeMicros(); nTimePostConnect += nTime6 - nTime5; nTimeTotal += nTime6 - nTime1;
     LogPrint(BCLog::BENCH, "  - Connect postprocess: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime6 - nTime5) * MILLI, nTimePostConnect * MICRO, nTimePostConnect * MILLI / nBlocksTotal);
@@ -4504,6 +4560,7 @@ bool LoadBlockIndex(const CChainParams& chainparams)
         LogPrintf("Initializing databases...\n");
         fNameHistory = gArgs.GetBoolArg("-namehistory", false);
         pblocktree->WriteFlag("namehistory", fNameHistory);
+        pblocktree->WriteFlag("namehistoryentries", true);
     }
     return true;
 }
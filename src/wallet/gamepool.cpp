@@ -0,0 +1,360 @@
+// Copyright (c) 2018 Slawek Mozdzonek
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <wallet/gamepool.h>
+
+#include <consensus/validation.h>
+#include <net.h>
+#include <outputtype.h>
+#include <policy/policy.h>
+#include <policy/rbf.h>
+#include <scheduler.h>
+#include <script/standard.h>
+#include <util.h>
+#include <utilmoneystr.h>
+#include <validation.h>
+#include <wallet/coincontrol.h>
+#include <wallet/fees.h>
+#include <wallet/wallet.h>
+
+const char* const GAME_POOL_LABEL = "gamepool";
+
+static CCriticalSection cs_game_pool;
+static std::shared_ptr<CGamePool> g_game_pool GUARDED_BY(cs_game_pool);
+
+CGamePool::CGamePool(std::shared_ptr<CWallet> wallet, const std::vector<CAmount>& denominations, unsigned int size) :
+    m_wallet(std::move(wallet)), m_size(size)
+{
+    for (const CAmount denomination : denominations) {
+        m_available[denomination];
+    }
+}
+
+bool CGamePool::CreateTransaction(const std::vector<CRecipient>& vecSend, int32_t nVersion, CTransactionRef& tx,
+                                  CReserveKey& reservekey, const CCoinControl& coin_control, std::string& strFailReason)
+{
+    CAmount nValue = 0;
+    for (const CRecipient& recipient : vecSend) {
+        if (recipient.fSubtractFeeFromAmount) {
+            strFailReason = "Pool transactions can not subtract the fee from an amount";
+            return false;
+        }
+        nValue += recipient.nAmount;
+    }
+
+    LOCK2(cs_main, m_wallet->cs_wallet);
+    LOCK(m_cs);
+
+    // Outputs confirmed since the last refill can be used right away
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        const CWalletTx* wtx = m_wallet->GetWalletTx(it->first.hash);
+        if (wtx != nullptr && wtx->GetDepthInMainChain() >= 1) {
+            m_available[it->second].push_back(it->first);
+            it = m_pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    CMutableTransaction txNew;
+    txNew.nVersion = nVersion;
+    txNew.nLockTime = chainActive.Height();
+    for (const CRecipient& recipient : vecSend) {
+        txNew.vout.emplace_back(recipient.nAmount, recipient.scriptPubKey);
+    }
+
+    CPubKey changeKey;
+    if (!reservekey.GetReservedKey(changeKey, true)) {
+        strFailReason = "Keypool ran out, please call keypoolrefill first";
+        return false;
+    }
+    const OutputType change_type = m_wallet->TransactionChangeType(coin_control.m_change_type ? *coin_control.m_change_type : m_wallet->m_default_change_type, vecSend);
+    m_wallet->LearnRelatedScripts(changeKey, change_type);
+    txNew.vout.emplace_back(0, GetScriptForDestination(GetDestinationForKey(changeKey, change_type)));
+
+    const uint32_t nSequence = coin_control.m_signal_bip125_rbf.get_value_or(m_wallet->m_signal_rbf) ? MAX_BIP125_RBF_SEQUENCE : (CTxIn::SEQUENCE_FINAL - 1);
+    txNew.vin.emplace_back(COutPoint(), CScript(), nSequence);
+
+    const CFeeRate feeRate = GetMinimumFeeRate(*m_wallet, coin_control, ::mempool, ::feeEstimator, nullptr);
+
+    // Denominations are ordered, so the first one covering the amounts is the smallest
+    for (auto& entry : m_available) {
+        std::deque<COutPoint>& outputs = entry.second;
+        while (!outputs.empty() && m_wallet->IsSpent(outputs.front().hash, outputs.front().n)) {
+            m_wallet->UnlockCoin(outputs.front());
+            outputs.pop_front();
+        }
+        if (outputs.empty()) {
+            continue;
+        }
+
+        txNew.vin[0].prevout = outputs.front();
+        const int64_t nBytes = CalculateMaximumSignedTxSize(CTransaction(txNew), m_wallet.get());
+        if (nBytes < 0) {
+            continue;
+        }
+        const CAmount nChange = entry.first - nValue - feeRate.GetFee(nBytes);
+        if (nChange < 0) {
+            continue;
+        }
+
+        // Dust change goes to the fee
+        txNew.vout.back().nValue = nChange;
+        if (IsDust(txNew.vout.back(), ::dustRelayFee)) {
+            txNew.vout.pop_back();
+        }
+
+        if (!m_wallet->SignTransaction(txNew)) {
+            strFailReason = "Signing transaction failed";
+            return false;
+        }
+
+        m_wallet->UnlockCoin(outputs.front());
+        outputs.pop_front();
+        tx = MakeTransactionRef(std::move(txNew));
+        return true;
+    }
+
+    strFailReason = "No pool output covers the amount";
+    return false;
+}
+
+void CGamePool::ReturnTransaction(const CTransaction& tx)
+{
+    LOCK2(cs_main, m_wallet->cs_wallet);
+    LOCK(m_cs);
+
+    for (const CTxIn& txin : tx.vin) {
+        const CWalletTx* wtx = m_wallet->GetWalletTx(txin.prevout.hash);
+        if (wtx == nullptr || txin.prevout.n >= wtx->tx->vout.size()) {
+            continue;
+        }
+        const auto it = m_available.find(wtx->tx->vout[txin.prevout.n].nValue);
+        if (it != m_available.end()) {
+            m_wallet->LockCoin(txin.prevout);
+            it->second.push_front(txin.prevout);
+        }
+    }
+}
+
+void CGamePool::Scan()
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(m_wallet->cs_wallet);
+
+    // Drop the outputs spent since the last scan, and move those of
+    // transactions that got confirmed or reorged out
+    std::map<COutPoint, CAmount> pending;
+    for (auto& entry : m_available) {
+        std::deque<COutPoint> confirmed;
+        for (const COutPoint& output : entry.second) {
+            const CWalletTx* wtx = m_wallet->GetWalletTx(output.hash);
+            if (wtx == nullptr || m_wallet->IsSpent(output.hash, output.n)) {
+                m_wallet->UnlockCoin(output);
+            } else if (wtx->GetDepthInMainChain() < 1) {
+                pending.emplace(output, entry.first);
+            } else {
+                confirmed.push_back(output);
+            }
+        }
+        entry.second.swap(confirmed);
+    }
+    for (const auto& entry : m_pending) {
+        const CWalletTx* wtx = m_wallet->GetWalletTx(entry.first.hash);
+        const int nDepth = wtx == nullptr ? -1 : wtx->GetDepthInMainChain();
+        if (nDepth < 0 || m_wallet->IsSpent(entry.first.hash, entry.first.n)) {
+            m_wallet->UnlockCoin(entry.first);
+        } else if (nDepth == 0) {
+            pending.insert(entry);
+        } else {
+            m_available[entry.second].push_back(entry.first);
+        }
+    }
+    m_pending.swap(pending);
+}
+
+void CGamePool::LoadOutputs()
+{
+    LOCK2(cs_main, m_wallet->cs_wallet);
+    LOCK(m_cs);
+
+    std::vector<COutput> outputs;
+    m_wallet->AvailableCoins(outputs, true, nullptr, 1, MAX_MONEY, MAX_MONEY, 0, 0);
+    for (const COutput& out : outputs) {
+        const CTxOut& txout = out.tx->tx->vout[out.i];
+        const auto it = m_available.find(txout.nValue);
+        if (it == m_available.end()) {
+            continue;
+        }
+
+        CTxDestination dest;
+        if (!ExtractDestination(txout.scriptPubKey, dest)) {
+            continue;
+        }
+        const auto label = m_wallet->mapAddressBook.find(dest);
+        if (label == m_wallet->mapAddressBook.end() || label->second.name != GAME_POOL_LABEL) {
+            continue;
+        }
+
+        const COutPoint output(out.tx->GetHash(), out.i);
+        m_wallet->LockCoin(output);
+        if (out.nDepth < 1) {
+            m_pending.emplace(output, txout.nValue);
+        } else {
+            it->second.push_back(output);
+        }
+    }
+}
+
+bool CGamePool::CreateSplitTransaction(const std::vector<CAmount>& values, std::string& strFailReason)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(m_wallet->cs_wallet);
+
+    m_wallet->TopUpKeyPool();
+
+    std::vector<CRecipient> vecSend;
+    for (const CAmount value : values) {
+        CPubKey key;
+        if (!m_wallet->GetKeyFromPool(key)) {
+            strFailReason = "Keypool ran out, please call keypoolrefill first";
+            return false;
+        }
+        m_wallet->LearnRelatedScripts(key, m_wallet->m_default_address_type);
+        const CTxDestination dest = GetDestinationForKey(key, m_wallet->m_default_address_type);
+        m_wallet->SetAddressBook(dest, GAME_POOL_LABEL, "receive");
+        vecSend.push_back({GetScriptForDestination(dest), value, false});
+    }
+
+    CCoinControl coin_control;
+    CReserveKey reservekey(m_wallet.get());
+    CAmount nFeeRequired;
+    int nChangePosInOut = -1;
+    CTransactionRef tx;
+    if (!m_wallet->CreateTransaction(vecSend, nullptr, tx, reservekey, nFeeRequired, nChangePosInOut, strFailReason, coin_control)) {
+        return false;
+    }
+
+    CValidationState state;
+    if (!m_wallet->CommitTransaction(tx, {}, {}, reservekey, g_connman.get(), state)) {
+        strFailReason = FormatStateMessage(state);
+        return false;
+    }
+
+    // Lock the new outputs right away, before ordinary coin selection can use them
+    for (size_t i = 0; i < tx->vout.size(); ++i) {
+        if (static_cast<int>(i) == nChangePosInOut) {
+            continue;
+        }
+        const COutPoint output(tx->GetHash(), i);
+        m_wallet->LockCoin(output);
+        m_pending.emplace(output, tx->vout[i].nValue);
+    }
+
+    LogPrintf("%s: created %u pool outputs in %s\n", __func__, values.size(), tx->GetHash().ToString());
+    return true;
+}
+
+void CGamePool::Refill()
+{
+    LOCK2(cs_main, m_wallet->cs_wallet);
+    LOCK(m_cs);
+
+    Scan();
+
+    std::map<CAmount, size_t> counts;
+    for (const auto& entry : m_available) {
+        counts[entry.first] = entry.second.size();
+    }
+    for (const auto& entry : m_pending) {
+        ++counts[entry.second];
+    }
+
+    std::vector<CAmount> values;
+    for (const auto& entry : counts) {
+        for (size_t i = entry.second; i < m_size && values.size() < MAX_GAME_POOL_SPLIT_OUTPUTS; ++i) {
+            values.push_back(entry.first);
+        }
+    }
+    if (values.empty()) {
+        return;
+    }
+
+    if (m_wallet->IsLocked()) {
+        LogPrintf("%s: wallet is locked, can not create %u pool outputs\n", __func__, values.size());
+        return;
+    }
+
+    std::string strFailReason;
+    if (!CreateSplitTransaction(values, strFailReason)) {
+        LogPrintf("%s: could not create %u pool outputs: %s\n", __func__, values.size(), strFailReason);
+    }
+}
+
+std::map<CAmount, size_t> CGamePool::GetAvailable() const
+{
+    LOCK(m_cs);
+
+    std::map<CAmount, size_t> res;
+    for (const auto& entry : m_available) {
+        res[entry.first] = entry.second.size();
+    }
+    return res;
+}
+
+std::shared_ptr<CGamePool> GetGamePool(const CWallet* wallet)
+{
+    LOCK(cs_game_pool);
+    if (g_game_pool && g_game_pool->GetWallet() == wallet) {
+        return g_game_pool;
+    }
+    return nullptr;
+}
+
+void StartGamePool(CScheduler& scheduler)
+{
+    const int64_t size = gArgs.GetArg("-gamepool", DEFAULT_GAME_POOL_SIZE);
+    const std::vector<std::shared_ptr<CWallet>> wallets = GetWallets();
+    if (size <= 0 || wallets.empty()) {
+        return;
+    }
+
+    std::vector<CAmount> denominations;
+    for (const std::string& str : gArgs.GetArgs("-gamepooldenom")) {
+        CAmount denomination;
+        if (!ParseMoney(str, denomination) || denomination <= 0) {
+            LogPrintf("%s: ignoring invalid -gamepooldenom=%s\n", __func__, str);
+            continue;
+        }
+        denominations.push_back(denomination);
+    }
+    if (denominations.empty()) {
+        denominations.push_back(DEFAULT_GAME_POOL_DENOMINATION);
+    }
+
+    std::shared_ptr<CGamePool> pool = std::make_shared<CGamePool>(wallets[0], denominations, size);
+    pool->LoadOutputs();
+    {
+        LOCK(cs_game_pool);
+        g_game_pool = pool;
+    }
+    scheduler.scheduleEvery([] {
+        std::shared_ptr<CGamePool> pool;
+        {
+            LOCK(cs_game_pool);
+            pool = g_game_pool;
+        }
+        if (pool) {
+            pool->Refill();
+        }
+    }, GAME_POOL_REFILL_INTERVAL);
+}
+
+void StopGamePool(const CWallet* wallet)
+{
+    LOCK(cs_game_pool);
+    if (g_game_pool && (wallet == nullptr || g_game_pool->GetWallet() == wallet)) {
+        g_game_pool.reset();
+    }
+}
@@ -0,0 +1,104 @@
+// Copyright (c) 2018 Slawek Mozdzonek
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_WALLET_GAMEPOOL_H
+#define BITCOIN_WALLET_GAMEPOOL_H
+
+#include <amount.h>
+#include <primitives/transaction.h>
+#include <sync.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+class CCoinControl;
+class CReserveKey;
+class CScheduler;
+class CWallet;
+struct CRecipient;
+
+//! Default for -gamepool, the number of pool outputs kept per denomination (0 disables the pool)
+static const unsigned int DEFAULT_GAME_POOL_SIZE = 0;
+//! Default denomination of the pool outputs if no -gamepooldenom is given
+static const CAmount DEFAULT_GAME_POOL_DENOMINATION = COIN;
+//! Interval in milliseconds at which the pool is refilled
+static const int64_t GAME_POOL_REFILL_INTERVAL = 10000;
+//! Maximum number of pool outputs created by one split transaction
+static const size_t MAX_GAME_POOL_SPLIT_OUTPUTS = 100;
+//! Label of the wallet addresses holding the pool outputs
+extern const char* const GAME_POOL_LABEL;
+
+/**
+ * Pool of confirmed wallet outputs of fixed denominations, reserved for
+ * makebet and storedata transactions. Such a transaction spends a single
+ * pool output and pays the rest back as change, so it is created without
+ * running coin selection over the whole wallet.
+ *
+ * The pool outputs are sent to wallet addresses labelled GAME_POOL_LABEL and
+ * locked, so that ordinary coin selection leaves them alone. Coin locks are
+ * not persistent; after a restart the labelled outputs are picked up again.
+ */
+class CGamePool
+{
+public:
+    CGamePool(std::shared_ptr<CWallet> wallet, const std::vector<CAmount>& denominations, unsigned int size);
+
+    const CWallet* GetWallet() const { return m_wallet.get(); }
+
+    /**
+     * Create and sign a transaction paying vecSend from the smallest pool
+     * output covering its amounts and fee, with the rest as change in the
+     * second output. Returns false, leaving the pool unchanged, if there is
+     * no such output. The output is returned to the pool by
+     * ReturnTransaction if the transaction can not be committed.
+     */
+    bool CreateTransaction(const std::vector<CRecipient>& vecSend, int32_t nVersion, CTransactionRef& tx,
+                           CReserveKey& reservekey, const CCoinControl& coin_control, std::string& strFailReason);
+    void ReturnTransaction(const CTransaction& tx);
+
+    /**
+     * Lock the labelled pool outputs of the wallet, e.g. after a restart.
+     * This runs over all wallet outputs, so it is done once when the pool
+     * is started; later outputs are tracked from the split transactions.
+     */
+    void LoadOutputs();
+
+    /**
+     * Pick up new pool outputs as they confirm, drop the spent ones and send
+     * a split transaction creating outputs for all missing ones.
+     */
+    void Refill();
+
+    //! Number of confirmed pool outputs of each denomination
+    std::map<CAmount, size_t> GetAvailable() const;
+
+private:
+    //! Sort the tracked pool outputs into available and pending, dropping the spent ones
+    void Scan() EXCLUSIVE_LOCKS_REQUIRED(m_cs);
+    bool CreateSplitTransaction(const std::vector<CAmount>& values, std::string& strFailReason) EXCLUSIVE_LOCKS_REQUIRED(m_cs);
+
+    //! Shared, so that an unloaded wallet stays alive while the pool is still in use
+    const std::shared_ptr<CWallet> m_wallet;
+    const unsigned int m_size;
+
+    mutable CCriticalSection m_cs;
+    //! Confirmed pool outputs by denomination, oldest first
+    std::map<CAmount, std::deque<COutPoint>> m_available GUARDED_BY(m_cs);
+    //! Unconfirmed pool outputs with their denomination
+    std::map<COutPoint, CAmount> m_pending GUARDED_BY(m_cs);
+};
+
+//! The pool of a wallet, null if -gamepool is not set or the pool belongs to another wallet
+std::shared_ptr<CGamePool> GetGamePool(const CWallet* wallet);
+
+//! Start the pool of the default wallet if -gamepool is set
+void StartGamePool(CScheduler& scheduler);
+//! Stop the pool, only if it belongs to the given wallet unless that is null
+void StopGamePool(const CWallet* wallet = nullptr);
+
+#endif // BITCOIN_WALLET_GAMEPOOL_H
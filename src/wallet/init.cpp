@@ -12,6 +12,7 @@
 #include <utilmoneystr.h>
 #include <validation.h>
 #include <walletinitinterface.h>
+#include <wallet/gamepool.h>
 #include <wallet/rpcwallet.h>
 #include <wallet/wallet.h>
 #include <wallet/walletutil.h>
@@ -65,6 +66,8 @@ void WalletInit::AddWalletOptions() const
                                                               CURRENCY_UNIT, FormatMoney(DEFAULT_DISCARD_FEE)), false, OptionsCategory::WALLET);
     gArgs.AddArg("-fallbackfee=<amt>", strprintf("A fee rate (in %s/kB) that will be used when fee estimation has insufficient data (default: %s)",
                                                                CURRENCY_UNIT, FormatMoney(DEFAULT_FALLBACK_FEE)), false, OptionsCategory::WALLET);
+    gArgs.AddArg("-gamepool=<n>", strprintf("Keep <n> confirmed outputs of each -gamepooldenom in the wallet, reserved for makebet and storedata (default: %u)", DEFAULT_GAME_POOL_SIZE), false, OptionsCategory::WALLET);
+    gArgs.AddArg("-gamepooldenom=<amt>", strprintf("Denomination (in %s) of -gamepool outputs. Can be specified multiple times (default: %s)", CURRENCY_UNIT, FormatMoney(DEFAULT_GAME_POOL_DENOMINATION)), false, OptionsCategory::WALLET);
     gArgs.AddArg("-keypool=<n>", strprintf("Set key pool size to <n> (default: %u)", DEFAULT_KEYPOOL_SIZE), false, OptionsCategory::WALLET);
     gArgs.AddArg("-mintxfee=<amt>", strprintf("Fees (in %s/kB) smaller than this are considered zero fee for transaction creation (default: %s)",
                                                             CURRENCY_UNIT, FormatMoney(DEFAULT_TRANSACTION_MINFEE)), false, OptionsCategory::WALLET);
@@ -249,6 +252,8 @@ void WalletInit::Start(CScheduler& scheduler) const
 
     // Run a thread to flush wallet periodically
     scheduler.scheduleEvery(MaybeCompactWalletDB, 500);
+
+    StartGamePool(scheduler);
 }
 
 void WalletInit::Flush() const
@@ -267,6 +272,7 @@ void WalletInit::Stop() const
 
 void WalletInit::Close() const
 {
+    StopGamePool();
     for (const std::shared_ptr<CWallet>& pwallet : GetWallets()) {
         RemoveWallet(pwallet);
     }
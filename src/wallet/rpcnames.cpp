@@ -280,56 +280,69 @@ name_list (const JSONRPCRequest& request)
   {
   LOCK2 (cs_main, pwallet->cs_wallet);
   const int tipHeight = chainActive.Height ();
-  for (const auto& item : pwallet->mapWallet)
-    {
-      const CWalletTx& tx = item.second;
-      if (!tx.tx->IsNamecoin ())
-        continue;
-
-      CNameScript nameOp;
-      int nOut = -1;
-      for (unsigned i = 0; i < tx.tx->vout.size (); ++i)
-        {
-          const CNameScript cur(tx.tx->vout[i].scriptPubKey);
-          if (cur.isNameOp ())
-            {
-              if (nOut != -1)
-                LogPrintf ("ERROR: wallet contains tx with multiple"
-                           " name outputs");
-              else
-                {
-                  nameOp = cur;
-                  nOut = i;
-                }
-            }
-        }
-
-      if (nOut == -1 || !nameOp.isAnyUpdate ())
-        continue;
-
-      const valtype& name = nameOp.getOpName ();
-      if (!nameFilter.empty () && nameFilter != name)
-        continue;
 
-      const int depth = tx.GetDepthInMainChain ();
-      if (depth <= 0)
-        continue;
-      const int height = tipHeight - depth + 1;
-
-      const auto mit = mapHeights.find (name);
-      if (mit != mapHeights.end () && mit->second > height)
-        continue;
-
-      UniValue obj
-        = getNameInfo (name, nameOp.getOpValue (),
-                       COutPoint (tx.GetHash (), nOut),
-                       nameOp.getAddress ());
-      addOwnershipInfo (nameOp.getAddress (), pwallet, obj);
-      addExpirationInfo (height, obj);
-
-      mapHeights[name] = height;
-      mapObjects[name] = obj;
+  /* Only the transactions indexed for a name can update it, so there is
+     no need to look at the rest of the wallet.  */
+  auto begin = pwallet->mapNameTxs.begin ();
+  auto end = pwallet->mapNameTxs.end ();
+  if (!nameFilter.empty ())
+    {
+      begin = pwallet->mapNameTxs.find (nameFilter);
+      if (begin != end)
+        end = std::next (begin);
     }
+
+  for (auto nit = begin; nit != end; ++nit)
+    for (const uint256& txid : nit->second)
+      {
+        const auto wit = pwallet->mapWallet.find (txid);
+        assert (wit != pwallet->mapWallet.end ());
+        const CWalletTx& tx = wit->second;
+
+        CNameScript nameOp;
+        int nOut = -1;
+        for (unsigned i = 0; i < tx.tx->vout.size (); ++i)
+          {
+            const CNameScript cur(tx.tx->vout[i].scriptPubKey);
+            if (cur.isNameOp ())
+              {
+                if (nOut != -1)
+                  LogPrintf ("ERROR: wallet contains tx with multiple"
+                             " name outputs");
+                else
+                  {
+                    nameOp = cur;
+                    nOut = i;
+                  }
+              }
+          }
+
+        if (nOut == -1 || !nameOp.isAnyUpdate ())
+          continue;
+
+        const valtype& name = nameOp.getOpName ();
+        if (name != nit->first)
+          continue;
+
+        const int depth = tx.GetDepthInMainChain ();
+        if (depth <= 0)
+          continue;
+        const int height = tipHeight - depth + 1;
+
+        const auto mit = mapHeights.find (name);
+        if (mit != mapHeights.end () && mit->second > height)
+          continue;
+
+        UniValue obj
+          = getNameInfo (name, nameOp.getOpValue (),
+                         COutPoint (tx.GetHash (), nOut),
+                         nameOp.getAddress ());
+        addOwnershipInfo (nameOp.getAddress (), pwallet, obj);
+        addExpirationInfo (height, obj);
+
+        mapHeights[name] = height;
+        mapObjects[name] = obj;
+      }
   }
 
   UniValue res(UniValue::VARR);
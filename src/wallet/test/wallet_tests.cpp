@@ -11,6 +11,10 @@
 #include <vector>
 
 #include <consensus/validation.h>
+#include <data/datautils.h>
+#include <data/processunspent.h>
+#include <key_io.h>
+#include <names/encoding.h>
 #include <rpc/server.h>
 #include <test/test_bitcoin.h>
 #include <validation.h>
@@ -375,6 +379,114 @@ BOOST_FIXTURE_TEST_CASE(ListCoins, ListCoinsTestingSetup)
     BOOST_CHECK_EQUAL(list.begin()->second.size(), 2U);
 }
 
+BOOST_FIXTURE_TEST_CASE(ProcessUnspentSelection, ListCoinsTestingSetup)
+{
+    const CScript script = GetScriptForRawPubKey(coinbaseKey.GetPubKey());
+    AddTx(CRecipient{script, 1 * COIN, false /* subtract fee */});
+    AddTx(CRecipient{script, 1 * COIN, false /* subtract fee */});
+
+    ProcessUnspent unspent(wallet.get(), {});
+    const std::vector<COutput>& outputs = unspent.getOutputs();
+    BOOST_REQUIRE(outputs.size() >= 3);
+    for (size_t i = 1; i < outputs.size(); ++i) {
+        BOOST_CHECK(outputs[i - 1].nDepth >= outputs[i].nDepth);
+    }
+
+    // The oldest output covers a small amount, every further input adds to
+    // the fee.
+    const CFeeRate feeRate(1000);
+    const CAmount first = outputs[0].tx->tx->vout[outputs[0].i].nValue;
+    const CAmount second = outputs[1].tx->tx->vout[outputs[1].i].nValue;
+    std::vector<COutput> selected;
+    CAmount fee;
+    BOOST_CHECK(unspent.getUtxForAmount(selected, feeRate, 200, 1, fee));
+    BOOST_CHECK_EQUAL(selected.size(), 1U);
+    BOOST_CHECK_EQUAL(fee, feeRate.GetFee(200));
+    BOOST_CHECK(unspent.getUtxForAmount(selected, feeRate, 200, first, fee));
+    BOOST_REQUIRE_EQUAL(selected.size(), 2U);
+    BOOST_CHECK(selected[1].tx == outputs[1].tx && selected[1].i == outputs[1].i);
+    BOOST_CHECK_EQUAL(fee, feeRate.GetFee(200 + 145));
+    BOOST_CHECK(!unspent.getUtxForAmount(selected, feeRate, 200, MAX_MONEY, fee));
+    BOOST_CHECK(selected.empty());
+
+    // The listunspent-style entries of the same outputs give the change.
+    UniValue utx(UniValue::VARR);
+    BOOST_CHECK(unspent.getUtxForAmount(utx, feeRate, 200, first, fee));
+    BOOST_CHECK_EQUAL(utx.size(), 2U);
+    BOOST_CHECK_EQUAL(computeChange(utx, fee), first + second - fee);
+}
+
+static std::set<COutPoint> AvailableOutPoints(CWallet& wallet)
+{
+    LOCK2(cs_main, wallet.cs_wallet);
+    std::vector<COutput> available;
+    wallet.AvailableCoins(available, false, nullptr, 0);
+    std::set<COutPoint> outpoints;
+    for (const COutput& out : available) {
+        outpoints.emplace(out.tx->GetHash(), out.i);
+    }
+    return outpoints;
+}
+
+static COutPoint EntryOutPoint(const UniValue& entry)
+{
+    return COutPoint(uint256S(find_value(entry, "txid").get_str()), find_value(entry, "vout").get_int());
+}
+
+BOOST_FIXTURE_TEST_CASE(ProcessUnspentPaging, ListCoinsTestingSetup)
+{
+    const CScript script = GetScriptForRawPubKey(coinbaseKey.GetPubKey());
+    AddTx(CRecipient{script, 1 * COIN, false /* subtract fee */});
+    AddTx(CRecipient{script, 1 * COIN, false /* subtract fee */});
+    const std::set<COutPoint> before = AvailableOutPoints(*wallet);
+    BOOST_REQUIRE(before.size() >= 4);
+
+    // Pages list every output once, in (txid, vout) order.
+    std::vector<COutPoint> listed;
+    COutPoint last;
+    UniValue page = getUnspentPage(wallet.get(), {}, 0, 9999999, nullptr, 2, last);
+    BOOST_REQUIRE_EQUAL(page.size(), 2U);
+    for (const UniValue& entry : page.getValues()) {
+        listed.push_back(EntryOutPoint(entry));
+    }
+    BOOST_CHECK(last == listed.back());
+
+    // Spending and confirming outputs between the calls moves nothing: the
+    // outputs left unspent are listed exactly once, without gaps.
+    AddTx(CRecipient{script, 1 * COIN, false /* subtract fee */});
+    const std::set<COutPoint> after = AvailableOutPoints(*wallet);
+    BOOST_REQUIRE(after != before);
+    do {
+        const COutPoint cursor = last;
+        page = getUnspentPage(wallet.get(), {}, 0, 9999999, &cursor, 2, last);
+        for (const UniValue& entry : page.getValues()) {
+            listed.push_back(EntryOutPoint(entry));
+        }
+    } while (page.size() == 2);
+
+    BOOST_CHECK(std::is_sorted(listed.begin(), listed.end()));
+    BOOST_CHECK(std::adjacent_find(listed.begin(), listed.end()) == listed.end());
+    const std::set<COutPoint> listedSet(listed.begin(), listed.end());
+    for (const COutPoint& outpoint : before) {
+        if (after.count(outpoint)) {
+            BOOST_CHECK(listedSet.count(outpoint));
+        }
+    }
+    for (const COutPoint& outpoint : listed) {
+        BOOST_CHECK(before.count(outpoint) || after.count(outpoint));
+    }
+
+    // Outputs can be restricted to some addresses, the change goes elsewhere.
+    const std::string address = EncodeDestination(coinbaseKey.GetPubKey().GetID());
+    page = getUnspentPage(wallet.get(), {address}, 0, 9999999, nullptr, after.size(), last);
+    BOOST_CHECK(page.size() > 0);
+    BOOST_CHECK(page.size() < after.size());
+    for (const UniValue& entry : page.getValues()) {
+        BOOST_CHECK_EQUAL(find_value(entry, "address").get_str(), address);
+    }
+    BOOST_CHECK_THROW(getUnspentPage(wallet.get(), {address, address}, 0, 9999999, nullptr, 1, last), std::runtime_error);
+}
+
 BOOST_FIXTURE_TEST_CASE(wallet_disableprivkeys, TestChain100Setup)
 {
     std::shared_ptr<CWallet> wallet = std::make_shared<CWallet>("dummy", WalletDatabase::CreateDummy());
@@ -384,4 +496,29 @@ BOOST_FIXTURE_TEST_CASE(wallet_disableprivkeys, TestChain100Setup)
     BOOST_CHECK(!wallet->GetKeyFromPool(pubkey, false));
 }
 
+BOOST_AUTO_TEST_CASE(name_index)
+{
+    const valtype name = DecodeName("d/test", NameEncoding::ASCII);
+    const valtype value = DecodeName("value", NameEncoding::ASCII);
+    const CScript addr = GetScriptForDestination(CKeyID());
+
+    CMutableTransaction nameTx;
+    nameTx.SetNamecoin();
+    nameTx.vout.emplace_back(COIN, CNameScript::buildNameUpdate(addr, name, value));
+    nameTx.vout.emplace_back(COIN, addr);
+
+    CMutableTransaction plainTx;
+    plainTx.vout.emplace_back(COIN, addr);
+
+    LOCK2(cs_main, m_wallet.cs_wallet);
+    m_wallet.AddToWallet(CWalletTx(&m_wallet, MakeTransactionRef(plainTx)));
+    BOOST_CHECK(m_wallet.mapNameTxs.empty());
+
+    const CWalletTx wtx(&m_wallet, MakeTransactionRef(nameTx));
+    m_wallet.AddToWallet(wtx);
+    m_wallet.AddToWallet(wtx);
+    BOOST_CHECK_EQUAL(m_wallet.mapNameTxs.size(), 1U);
+    BOOST_CHECK(m_wallet.mapNameTxs[name] == std::set<uint256>({wtx.GetHash()}));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
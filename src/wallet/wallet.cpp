@@ -841,6 +841,37 @@ bool CWallet::MarkReplaced(const uint256& originalHash, const uint256& newHash)
     return success;
 }
 
+void CWallet::AddToNameIndex(const CWalletTx& wtx)
+{
+    if (!wtx.tx->IsNamecoin())
+        return;
+
+    for (const CTxOut& txout : wtx.tx->vout) {
+        const CNameScript nameOp(txout.scriptPubKey);
+        if (nameOp.isNameOp() && nameOp.isAnyUpdate())
+            mapNameTxs[nameOp.getOpName()].insert(wtx.GetHash());
+    }
+}
+
+void CWallet::RemoveFromNameIndex(const CWalletTx& wtx)
+{
+    if (!wtx.tx->IsNamecoin())
+        return;
+
+    for (const CTxOut& txout : wtx.tx->vout) {
+        const CNameScript nameOp(txout.scriptPubKey);
+        if (!nameOp.isNameOp() || !nameOp.isAnyUpdate())
+            continue;
+
+        auto it = mapNameTxs.find(nameOp.getOpName());
+        if (it == mapNameTxs.end())
+            continue;
+        it->second.erase(wtx.GetHash());
+        if (it->second.empty())
+            mapNameTxs.erase(it);
+    }
+}
+
 bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
 {
     LOCK(cs_wallet);
@@ -860,6 +891,7 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
         wtx.m_it_wtxOrdered = wtxOrdered.insert(std::make_pair(wtx.nOrderPos, &wtx));
         wtx.nTimeSmart = ComputeTimeSmart(wtx);
         AddToSpends(hash);
+        AddToNameIndex(wtx);
     }
 
     bool fUpdated = false;
@@ -933,6 +965,7 @@ void CWallet::LoadToWallet(const CWalletTx& wtxIn)
     wtx.BindWallet(this);
     if (/* insertion took place */ ins.second) {
         wtx.m_it_wtxOrdered = wtxOrdered.insert(std::make_pair(wtx.nOrderPos, &wtx));
+        AddToNameIndex(wtx);
     }
     AddToSpends(hash);
     for (const CTxIn& txin : wtx.tx->vin) {
@@ -2190,7 +2223,7 @@ CAmount CWallet::GetAvailableBalance(const CCoinControl* coinControl) const
     return balance;
 }
 
-void CWallet::AvailableCoins(std::vector<COutput> &vCoins, bool fOnlySafe, const CCoinControl *coinControl, const CAmount &nMinimumAmount, const CAmount &nMaximumAmount, const CAmount &nMinimumSumAmount, const uint64_t nMaximumCount, const int nMinDepth, const int nMaxDepth) const
+void CWallet::AvailableCoins(std::vector<COutput> &vCoins, bool fOnlySafe, const CCoinControl *coinControl, const CAmount &nMinimumAmount, const CAmount &nMaximumAmount, const CAmount &nMinimumSumAmount, const uint64_t nMaximumCount, const int nMinDepth, const int nMaxDepth, const COutPoint* after) const
 {
     AssertLockHeld(cs_main);
     AssertLockHeld(cs_wallet);
@@ -2198,8 +2231,9 @@ void CWallet::AvailableCoins(std::vector<COutput> &vCoins, bool fOnlySafe, const
     vCoins.clear();
     CAmount nTotal = 0;
 
-    for (const auto& entry : mapWallet)
+    for (auto it = after ? mapWallet.lower_bound(after->hash) : mapWallet.begin(); it != mapWallet.end(); ++it)
     {
+        const auto& entry = *it;
         const uint256& wtxid = entry.first;
         const CWalletTx* pcoin = &entry.second;
 
@@ -2259,6 +2293,9 @@ void CWallet::AvailableCoins(std::vector<COutput> &vCoins, bool fOnlySafe, const
             continue;
 
         for (unsigned int i = 0; i < pcoin->tx->vout.size(); i++) {
+            if (after && wtxid == after->hash && i <= after->n)
+                continue;
+
             if (pcoin->tx->vout[i].nValue < nMinimumAmount || pcoin->tx->vout[i].nValue > nMaximumAmount)
                 continue;
 
@@ -3144,6 +3181,7 @@ DBErrors CWallet::ZapSelectTx(std::vector<uint256>& vHashIn, std::vector<uint256
     for (uint256 hash : vHashOut) {
         const auto& it = mapWallet.find(hash);
         wtxOrdered.erase(it->second.m_it_wtxOrdered);
+        RemoveFromNameIndex(it->second);
         mapWallet.erase(it);
     }
 
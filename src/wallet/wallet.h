@@ -619,6 +619,9 @@ private:
     void AddToSpends(const COutPoint& outpoint, const uint256& wtxid);
     void AddToSpends(const uint256& wtxid);
 
+    void AddToNameIndex(const CWalletTx& wtx);
+    void RemoveFromNameIndex(const CWalletTx& wtx);
+
     /**
      * Add a transaction to the wallet, or update it.  pIndex and posInBlock should
      * be set when the transaction was known to be included in a block.  When
@@ -750,6 +753,12 @@ public:
 
     std::map<uint256, CWalletTx> mapWallet;
 
+    /**
+     * Wallet transactions with a name update output, keyed by the name.
+     * name_list only has to look at these instead of the whole wallet.
+     */
+    std::map<valtype, std::set<uint256>> mapNameTxs;
+
     typedef std::multimap<int64_t, CWalletTx*> TxItems;
     TxItems wtxOrdered;
 
@@ -767,8 +776,10 @@ public:
 
     /**
      * populate vCoins with vector of available COutputs.
+     * Outputs are listed in (txid, vout) order, starting after the given one
+     * if any, so that the wallet can be walked a few outputs at a time.
      */
-    void AvailableCoins(std::vector<COutput>& vCoins, bool fOnlySafe=true, const CCoinControl *coinControl = nullptr, const CAmount& nMinimumAmount = 1, const CAmount& nMaximumAmount = MAX_MONEY, const CAmount& nMinimumSumAmount = MAX_MONEY, const uint64_t nMaximumCount = 0, const int nMinDepth = 0, const int nMaxDepth = 9999999) const EXCLUSIVE_LOCKS_REQUIRED(cs_main, cs_wallet);
+    void AvailableCoins(std::vector<COutput>& vCoins, bool fOnlySafe=true, const CCoinControl *coinControl = nullptr, const CAmount& nMinimumAmount = 1, const CAmount& nMaximumAmount = MAX_MONEY, const CAmount& nMinimumSumAmount = MAX_MONEY, const uint64_t nMaximumCount = 0, const int nMinDepth = 0, const int nMaxDepth = 9999999, const COutPoint* after = nullptr) const EXCLUSIVE_LOCKS_REQUIRED(cs_main, cs_wallet);
 
     /**
      * Return list of available coins and locked coins grouped by non-change output address.
@@ -20,3 +20,8 @@ bool CZMQAbstractNotifier::NotifyTransaction(const CTransaction &/*transaction*/
 {
     return true;
 }
+
+bool CZMQAbstractNotifier::NotifyBetStatus(const uint256 &/*makeBetHash*/, const modulo::ver_2::BetStatus &/*status*/)
+{
+    return true;
+}
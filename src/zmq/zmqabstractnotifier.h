@@ -9,6 +9,8 @@
 
 class CBlockIndex;
 class CZMQAbstractNotifier;
+class uint256;
+namespace modulo { namespace ver_2 { struct BetStatus; } }
 
 typedef CZMQAbstractNotifier* (*CZMQNotifierFactory)();
 
@@ -34,6 +36,7 @@ public:
 
     virtual bool NotifyBlock(const CBlockIndex *pindex);
     virtual bool NotifyTransaction(const CTransaction &transaction);
+    virtual bool NotifyBetStatus(const uint256 &makeBetHash, const modulo::ver_2::BetStatus &status);
 
 protected:
     void *psocket;
@@ -5,6 +5,8 @@
 #include <zmq/zmqnotificationinterface.h>
 #include <zmq/zmqpublishnotifier.h>
 
+#include <games/modulo/modulobettracker.h>
+
 #include <version.h>
 #include <validation.h>
 #include <streams.h>
@@ -48,6 +50,7 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
     factories["pubhashtx"] = CZMQAbstractNotifier::Create<CZMQPublishHashTransactionNotifier>;
     factories["pubrawblock"] = CZMQAbstractNotifier::Create<CZMQPublishRawBlockNotifier>;
     factories["pubrawtx"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
+    factories["pubbetstatus"] = CZMQAbstractNotifier::Create<CZMQPublishBetStatusNotifier>;
 
     for (const auto& entry : factories)
     {
@@ -112,6 +115,8 @@ bool CZMQNotificationInterface::Initialize()
         return false;
     }
 
+    modulo::ver_2::BetTracker::NotifyBetStatus.connect(boost::bind(&CZMQNotificationInterface::BetStatusChanged, this, _1, _2));
+
     return true;
 }
 
@@ -121,6 +126,7 @@ void CZMQNotificationInterface::Shutdown()
     LogPrint(BCLog::ZMQ, "zmq: Shutdown notification interface\n");
     if (pcontext)
     {
+        modulo::ver_2::BetTracker::NotifyBetStatus.disconnect(boost::bind(&CZMQNotificationInterface::BetStatusChanged, this, _1, _2));
         for (std::list<CZMQAbstractNotifier*>::iterator i=notifiers.begin(); i!=notifiers.end(); ++i)
         {
             CZMQAbstractNotifier *notifier = *i;
@@ -174,6 +180,23 @@ void CZMQNotificationInterface::TransactionAddedToMempool(const CTransactionRef&
     }
 }
 
+void CZMQNotificationInterface::BetStatusChanged(const uint256& makeBetHash, const modulo::ver_2::BetStatus& status)
+{
+    for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
+    {
+        CZMQAbstractNotifier *notifier = *i;
+        if (notifier->NotifyBetStatus(makeBetHash, status))
+        {
+            i++;
+        }
+        else
+        {
+            notifier->Shutdown();
+            i = notifiers.erase(i);
+        }
+    }
+}
+
 void CZMQNotificationInterface::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexConnected, const std::vector<CTransactionRef>& vtxConflicted, const std::vector<CTransactionRef>& vNameConflicts)
 {
     for (const CTransactionRef& ptx : pblock->vtx) {
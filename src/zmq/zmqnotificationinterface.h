@@ -12,6 +12,7 @@
 
 class CBlockIndex;
 class CZMQAbstractNotifier;
+namespace modulo { namespace ver_2 { struct BetStatus; } }
 
 class CZMQNotificationInterface final : public CValidationInterface
 {
@@ -35,6 +36,9 @@ protected:
 private:
     CZMQNotificationInterface();
 
+    // Connected to the bet settlement tracker
+    void BetStatusChanged(const uint256& makeBetHash, const modulo::ver_2::BetStatus& status);
+
     void *pcontext;
     std::list<CZMQAbstractNotifier*> notifiers;
 };
@@ -4,6 +4,7 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <games/modulo/modulobettracker.h>
 #include <streams.h>
 #include <zmq/zmqpublishnotifier.h>
 #include <validation.h>
@@ -16,6 +17,7 @@ static const char *MSG_HASHBLOCK = "hashblock";
 static const char *MSG_HASHTX    = "hashtx";
 static const char *MSG_RAWBLOCK  = "rawblock";
 static const char *MSG_RAWTX     = "rawtx";
+static const char *MSG_BETSTATUS = "betstatus";
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -195,3 +197,15 @@ bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &tr
     ss << transaction;
     return SendMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
 }
+
+bool CZMQPublishBetStatusNotifier::NotifyBetStatus(const uint256 &makeBetHash, const modulo::ver_2::BetStatus &status)
+{
+    LogPrint(BCLog::ZMQ, "zmq: Publish betstatus %s %s\n", makeBetHash.GetHex(), status.getStateName());
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << status;
+    std::vector<char> data(32);
+    for (unsigned int i = 0; i < 32; i++)
+        data[31 - i] = makeBetHash.begin()[i];
+    data.insert(data.end(), ss.begin(), ss.end());
+    return SendMessage(MSG_BETSTATUS, data.data(), data.size());
+}
@@ -52,4 +52,10 @@ public:
     bool NotifyTransaction(const CTransaction &transaction) override;
 };
 
+class CZMQPublishBetStatusNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyBetStatus(const uint256 &makeBetHash, const modulo::ver_2::BetStatus &status) override;
+};
+
 #endif // BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H
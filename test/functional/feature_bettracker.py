@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test makebet settlement tracking (-bettracker).
+
+A player's makebets go from pending to lost or won when their block is
+connected and from won to paid with the getbet of the next block. This is
+checked through getbetstatus, listbets paging and, if available, the ZMQ
+betstatus notification. Bets mined while the node ran without -bettracker
+are picked up when the tracker catches up on restart.
+"""
+import struct
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.authproxy import JSONRPCException
+from test_framework.util import assert_equal, assert_raises_rpc_error, wait_until
+
+LOST, WON, PAID = 0, 1, 2
+ZMQ_ADDRESS = "tcp://127.0.0.1:28334"
+
+
+class BetTrackerTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.setup_clean_chain = False
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def setup_nodes(self):
+        self.zmq_context = None
+        args = ["-bettracker"]
+        try:
+            import zmq
+            if self.is_zmq_compiled():
+                self.zmq_context = zmq.Context()
+                self.socket = self.zmq_context.socket(zmq.SUB)
+                self.socket.set(zmq.RCVTIMEO, 60000)
+                self.socket.connect(ZMQ_ADDRESS)
+                self.socket.setsockopt(zmq.SUBSCRIBE, b"betstatus")
+                args.append("-zmqpubbetstatus=%s" % ZMQ_ADDRESS)
+        except ImportError:
+            pass
+        self.add_nodes(self.num_nodes, [args])
+        self.start_nodes()
+
+    def receive_bet_statuses(self, n):
+        """Return the state of the next n betstatus notifications by makebet txid."""
+        states = {}
+        for _ in range(n):
+            topic, body, seq = self.socket.recv_multipart()
+            assert_equal(topic, b"betstatus")
+            txid = body[:32].hex()
+            # the record starts with its state
+            states[txid] = struct.unpack("<B", body[32:33])[0]
+        return states
+
+    def wait_for_tracker(self):
+        """Wait until the tracker caught up with the chain."""
+        def synced():
+            try:
+                self.nodes[0].listbets("", 1)
+                return True
+            except JSONRPCException as e:
+                assert_equal(e.error["code"], -28)
+                return False
+        wait_until(synced, timeout=60)
+
+    def run_test(self):
+        try:
+            self._bettracker_test()
+            self._catch_up_test()
+        finally:
+            if self.zmq_context is not None:
+                self.zmq_context.destroy(linger=None)
+
+    def _bettracker_test(self):
+        node = self.nodes[0]
+        self.wait_for_tracker()
+
+        player = node.getnewaddress("", "legacy")
+        node.sendtoaddress(player, 10)
+        node.generate(1)
+
+        # exactly one of the lottery bets and always the red-or-black bet win
+        bets = [{"type_of_bet": "1@1", "range": 2, "address": player},
+                {"type_of_bet": "2@1", "range": 2, "address": player},
+                {"type_of_bet": "red@1+black@1", "address": player}]
+        txids = [r["txid"] for r in node.makebets(bets)]
+        for txid in txids:
+            assert_equal(node.getbetstatus(txid), {"txid": txid, "status": "pending"})
+        assert_raises_rpc_error(-5, "No makebet", node.getbetstatus, "00" * 32)
+
+        blockhash = node.generate(1)[0]
+        height = node.getblockcount()
+        statuses = [node.getbetstatus(txid) for txid in txids]
+        for status in statuses:
+            assert_equal(status["blockhash"], blockhash)
+            assert_equal(status["height"], height)
+            assert_equal(status["address"], player)
+            assert "getbet" not in status
+        assert_equal(sorted(s["status"] for s in statuses[:2]), ["lost", "won"])
+        assert_equal(statuses[2]["status"], "won")
+        assert_equal(statuses[2]["amount"], 2)
+        assert_equal(statuses[2]["payoff"], 2)
+        won = [s["txid"] for s in statuses if s["status"] == "won"]
+        if self.zmq_context is not None:
+            states = self.receive_bet_statuses(3)
+            assert_equal(states, {s["txid"]: WON if s["status"] == "won" else LOST for s in statuses})
+
+        # the getbet of the next block pays the winning bets
+        getbet_block = node.getblock(node.generate(1)[0])
+        for txid in won:
+            status = node.getbetstatus(txid)
+            assert_equal(status["status"], "paid")
+            assert status["getbet"] in getbet_block["tx"]
+        if self.zmq_context is not None:
+            assert_equal(self.receive_bet_statuses(2), {txid: PAID for txid in won})
+
+        # pages of the player's bets list each bet once
+        first = node.listbets(player, 2, 0)
+        second = node.listbets(player, 2, 2)
+        assert_equal(len(first), 2)
+        assert_equal(len(second), 1)
+        assert_equal(sorted(b["txid"] for b in first + second), sorted(txids))
+        assert_equal(node.listbets(player, 2, 3), [])
+        assert_equal(len(node.listbets(player)), 3)
+        assert set(txids) <= set(b["txid"] for b in node.listbets("", 100))
+        assert_raises_rpc_error(-8, "Negative", node.listbets, player, -1)
+
+    def _catch_up_test(self):
+        node = self.nodes[0]
+        tracked = node.listbets("", 100)
+
+        # bets settled and paid while the tracker is off
+        self.restart_node(0, extra_args=[])
+        assert_raises_rpc_error(-1, "requires -bettracker", node.getbetstatus, "00" * 32)
+        player = node.getnewaddress("", "legacy")
+        node.sendtoaddress(player, 10)
+        node.generate(1)
+        bets = [{"type_of_bet": "red@1+black@1", "address": player},
+                {"type_of_bet": "1@1", "range": 2, "address": player}]
+        txids = [r["txid"] for r in node.makebets(bets)]
+        blockhash = node.generate(1)[0]
+        getbet_block = node.getblock(node.generate(1)[0])
+
+        # the tracker replays the blocks it missed
+        self.restart_node(0, extra_args=["-bettracker"])
+        self.wait_for_tracker()
+        paid = node.getbetstatus(txids[0])
+        assert_equal(paid["status"], "paid")
+        assert_equal(paid["blockhash"], blockhash)
+        assert paid["getbet"] in getbet_block["tx"]
+        assert node.getbetstatus(txids[1])["status"] in ("lost", "paid")
+        assert_equal(sorted(b["txid"] for b in node.listbets(player)), sorted(txids))
+        assert_equal(len(node.listbets("", 100)), len(tracked) + 2)
+
+
+if __name__ == '__main__':
+    BetTrackerTest().main()
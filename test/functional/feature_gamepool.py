@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+
+"""
+Test the -gamepool of pre-split outputs used by makebet
+"""
+
+import time
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal, wait_until
+
+
+class GamePoolTest(BitcoinTestFramework):
+
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.extra_args = [["-gamepool=2", "-gamepooldenom=5", "-gamepooldenom=20"]]
+
+    def run_test(self):
+        node = self.nodes[0]
+        node.generate(101)
+
+        # The pool creates two outputs of each denomination and locks them
+        wait_until(lambda: len(node.listlockunspent()) == 4, timeout=30)
+        node.generate(1)
+        pool = [(u["txid"], u["vout"]) for u in node.listlockunspent()]
+
+        # A bet spends the smallest pool output covering it, without other inputs
+        txid = node.makebet(type_of_bet="red@1")
+        tx = node.getrawtransaction(txid, True)
+        assert_equal(len(tx["vin"]), 1)
+        prevout = (tx["vin"][0]["txid"], tx["vin"][0]["vout"])
+        assert prevout in pool
+        prev = node.getrawtransaction(prevout[0], True)
+        assert_equal(prev["vout"][prevout[1]]["value"], 5)
+
+        # Bets larger than every denomination fall back to coin selection
+        txid = node.makebet(type_of_bet="red@30")
+        tx = node.getrawtransaction(txid, True)
+        assert all((i["txid"], i["vout"]) not in pool for i in tx["vin"])
+
+        # The spent output is replaced
+        wait_until(lambda: len(node.listlockunspent()) == 4, timeout=30)
+
+        # Unloading the wallet stops its pool, the next refill finds none
+        node.unloadwallet("")
+        time.sleep(11)
+        assert_equal(node.getblockcount(), 102)
+
+if __name__ == '__main__':
+    GamePoolTest().main()
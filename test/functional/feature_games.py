@@ -7,6 +7,7 @@ Test game functionalities (makebet and automatic getbet)
 import math
 from decimal import Decimal
 from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_raises_rpc_error
 
 
 def assert_equal(a, b):
@@ -187,6 +188,102 @@ class MakeBetTest(BitcoinTestFramework):
         self.generate_block()
         self.generate_block()
 
+    def batch_must_succeed(self):
+        # all bets are validated before any of them is created
+        assert_raises_rpc_error(-8, "Bet 1", self.nodeA.makebets,
+                                [{"type_of_bet": "red@1"}, {"type_of_bet": "blue@1"}])
+        assert_equal(self.nodeA.getmempoolinfo()["size"], 0)
+
+        player = self.nodeA.getnewaddress()
+        self.nodeA.sendtoaddress(player, 10)
+        self.generate_block()
+
+        bets = [{"type_of_bet": "%d@1" % n, "range": 4} for n in range(1, 4)]
+        bets.append({"type_of_bet": "4@1", "range": 4, "address": player})
+        res = self.nodeA.makebets(bets)
+        assert_equal(len(res), 4)
+        txids = [r["txid"] for r in res]
+        assert_equal(sorted(txids), sorted(self.nodeA.getrawmempool()))
+
+        # the player's bet is funded by the player address only
+        tx = self.nodeA.getrawtransaction(txids[3], True)
+        for txin in tx["vin"]:
+            prev = self.nodeA.getrawtransaction(txin["txid"], True)
+            assert_equal(prev["vout"][txin["vout"]]["scriptPubKey"]["addresses"], [player])
+
+        self.generate_block()
+        # coinbase + 4 makebets
+        self.assert_number_of_txs_current_block(1+4)
+
+        self.generate_block()
+        # coinbase + getbet
+        self.assert_number_of_txs_current_block(1+1)
+
+        # further bets of a player spend the change of the previous one
+        player = self.nodeA.getnewaddress()
+        self.nodeA.sendtoaddress(player, 10)
+        self.generate_block()
+
+        # the chain of a player's bets is bounded by the mempool ancestor limit
+        assert_raises_rpc_error(-8, "Bet 25: more than 25 bets of player address", self.nodeA.makebets,
+                                [{"type_of_bet": "1@0.1", "range": 2, "address": player}] * 26)
+        assert_equal(self.nodeA.getmempoolinfo()["size"], 0)
+
+        res = self.nodeA.makebets([{"type_of_bet": "1@1", "range": 2, "address": player},
+                                   {"type_of_bet": "2@1", "range": 2, "address": player}])
+        # the change is far above the dust limit
+        assert "dust_change" not in res[0]
+        txids = [r["txid"] for r in res]
+        assert_equal(sorted(txids), sorted(self.nodeA.getrawmempool()))
+        tx = self.nodeA.getrawtransaction(txids[1], True)
+        assert_equal([txin["txid"] for txin in tx["vin"]], [txids[0]])
+        for txin in tx["vin"]:
+            prev = self.nodeA.getrawtransaction(txin["txid"], True)
+            assert_equal(prev["vout"][txin["vout"]]["scriptPubKey"]["addresses"], [player])
+
+        self.generate_block()
+        # coinbase + 2 makebets
+        self.assert_number_of_txs_current_block(1+2)
+
+        self.generate_block()
+        # coinbase + getbet
+        self.assert_number_of_txs_current_block(1+1)
+
+    def simulation_must_succeed(self):
+        self.nodeA.makebet(type_of_bet="red@1+black@1")
+        txid = self.nodeA.makebet(type_of_bet="2@1", range=4)
+
+        # every roulette outcome pays 2, one of the four lottery outcomes pays 4
+        res = self.nodeA.simulatebets()
+        assert_equal(res["bets"], 2)
+        assert_equal(res["skipped"], 0)
+        assert_equal(res["truncated"], 0)
+        assert_equal(res["betsum"], 3)
+        assert_equal(res["maxpayout"], 6)
+        assert_equal(res["expectedpayout"], 3)
+        lottery, roulette = res["arguments"]
+        assert_equal(roulette["argument"], 36)
+        assert_equal(roulette["distribution"], [{"payout": 2, "outcomes": 36}])
+        assert_equal(lottery["argument"], 4)
+        assert_equal(lottery["winningoutcomes"], 1)
+        assert_equal(lottery["distribution"], [{"payout": 0, "outcomes": 3}, {"payout": 4, "outcomes": 1}])
+
+        raw = self.nodeA.getrawtransaction(txid)
+        self.generate_block()
+        assert_equal(self.nodeA.simulatebets()["bets"], 0)
+        blockhash = self.nodeA.getbestblockhash()
+        assert_equal(self.nodeA.simulatebets(blockhash)["arguments"], res["arguments"])
+
+        res = self.nodeA.simulatebets("", [raw], True)
+        assert_equal(res["arguments"][0]["payouts"], {"2": 4})
+
+        coinbase = self.nodeA.getblock(blockhash)["tx"][0]
+        assert_raises_rpc_error(-8, "Transaction 1", self.nodeA.simulatebets,
+                                "", [raw, self.nodeA.gettransaction(coinbase)["hex"]])
+        assert_raises_rpc_error(-8, "either", self.nodeA.simulatebets, blockhash, [raw])
+
+        self.generate_block()
+
     def run_test(self):
         self.nodeA = self.nodes[0]
         self.nodeB = self.nodes[1]
@@ -198,6 +295,8 @@ class MakeBetTest(BitcoinTestFramework):
         self.roulette_three_games_one_after_another()
         self.bet_sum_exceeds_block_subsidy()
         self.potential_bets_reward_exceeds_limit()
+        self.batch_must_succeed()
+        self.simulation_must_succeed()
 
 
 if __name__ == '__main__':
@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+# Copyright (c) 2018 Daniel Kraft
+# Distributed under the MIT/X11 software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+# RPC test for name_checkdb, the background check of the name database.
+
+from test_framework.names import NameTestFramework
+from test_framework.util import *
+
+class NameCheckDBTest (NameTestFramework):
+
+  def set_test_params (self):
+    self.setup_name_test ([[]] * 1)
+
+  def waitForCheck (self):
+    """
+    Wait until the running check has finished and return its result.
+    """
+
+    res = {}
+    def finished ():
+      res.update (self.node.name_checkdb ())
+      return not res["running"]
+    wait_until (finished, timeout=60)
+
+    return res
+
+  def run_test (self):
+    self.node = self.nodes[0]
+
+    # Register two names and update one of them, so that the database
+    # has some content to check.
+    newA = self.node.name_new ("a")
+    newB = self.node.name_new ("b")
+    self.node.generate (15)
+    self.firstupdateName (0, "a", newA, "value a")
+    self.firstupdateName (0, "b", newB, "value b")
+    self.node.generate (1)
+    self.node.name_update ("a", "updated a")
+    self.node.generate (1)
+
+    # The first call starts the check at the current height.
+    height = self.node.getblockcount ()
+    res = self.node.name_checkdb ()
+    assert_equal (res["height"], height)
+    if res["running"]:
+      assert "valid" not in res
+    res = self.waitForCheck ()
+    assert_equal (res, {"running": False, "height": height, "valid": True})
+
+    # Without restart, the result of the last check is reported again.
+    self.node.generate (1)
+    assert_equal (self.node.name_checkdb (), res)
+    assert_equal (self.node.name_checkdb (False), res)
+
+    # A restart checks the state at the new height, by which the names
+    # have expired.
+    self.node.generate (30)
+    height = self.node.getblockcount ()
+    self.node.name_checkdb (True)
+    res = self.waitForCheck ()
+    assert_equal (res, {"running": False, "height": height, "valid": True})
+
+if __name__ == '__main__':
+  NameCheckDBTest ().main ()
@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+# Copyright (c) 2018 Daniel Kraft
+# Distributed under the MIT/X11 software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+# Test the name lookups of the REST interface, in particular the batched
+# /rest/names endpoint.
+
+from test_framework.names import NameTestFramework
+from test_framework.messages import ser_string_vector
+from test_framework.util import *
+
+import binascii
+import http.client
+import json
+import struct
+import urllib.parse
+
+class NameRestTest (NameTestFramework):
+
+  def set_test_params (self):
+    self.setup_name_test ([["-rest"], []])
+
+  def restRequest (self, uri, body = None, status = 200):
+    url = urllib.parse.urlparse (self.nodes[0].url)
+    conn = http.client.HTTPConnection (url.hostname, url.port)
+    if body is None:
+      conn.request ('GET', '/rest' + uri)
+    else:
+      conn.request ('POST', '/rest' + uri, body)
+    resp = conn.getresponse ()
+    assert_equal (resp.status, status)
+    return resp.read ()
+
+  def run_test (self):
+    new = self.nodes[0].name_new ("d/rest")
+    self.generate (0, 12)
+    self.firstupdateName (0, "d/rest", new, "value")
+    self.generate (0, 1)
+
+    # Single name lookup.
+    res = json.loads (self.restRequest ("/name/d%2Frest.json").decode ())
+    self.checkNameData (res, "d/rest", "value", 30, False)
+    self.restRequest ("/name/d%2Fmissing.json", status=404)
+
+    # Batched lookup in JSON, before and after the name is updated (which
+    # must not be served from the cache of the previous tip).
+    body = json.dumps (["d/rest", "d/missing", "d/rest"])
+    for value in ["value", "updated"]:
+      if value == "updated":
+        self.nodes[0].name_update ("d/rest", value)
+        self.generate (0, 1)
+      res = json.loads (self.restRequest ("/names.json", body).decode ())
+      assert_equal (res['chainHeight'], self.nodes[0].getblockcount ())
+      assert_equal (res['chaintipHash'], self.nodes[0].getbestblockhash ())
+      assert_equal (len (res['names']), 3)
+      self.checkNameData (res['names'][0], "d/rest", value, 30, False)
+      assert res['names'][1] is None
+      assert_equal (res['names'][0], res['names'][2])
+
+    # Batched lookup in binary.  The reply holds the height, the tip hash
+    # and a bitmap of the names found, followed by their data.
+    names = [b"d/missing", b"d/rest"]
+    res = self.restRequest ("/names.bin", ser_string_vector (names))
+    height, = struct.unpack ("<i", res[:4])
+    assert_equal (height, self.nodes[0].getblockcount ())
+    assert_equal (res[36], 1)
+    assert_equal (res[37], 0b10)
+    assert_equal (res[38], 1)
+    hexBody = binascii.hexlify (ser_string_vector (names))
+    resHex = self.restRequest ("/names.hex", hexBody)
+    assert_equal (resHex.decode ().strip (), binascii.hexlify (res).decode ())
+
+    # Invalid requests.
+    self.restRequest ("/names.json", "", status=400)
+    self.restRequest ("/names.json", "[]", status=400)
+    self.restRequest ("/names.json", "{}", status=400)
+    self.restRequest ("/names.json", "[42]", status=400)
+    self.restRequest ("/names.bin", b"\xff", status=400)
+    tooMany = json.dumps (["d/rest"] * 1001)
+    self.restRequest ("/names.json", tooMany, status=400)
+
+if __name__ == '__main__':
+  NameRestTest ().main ()
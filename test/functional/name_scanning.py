@@ -87,6 +87,19 @@ class NameScanningTest (NameTestFramework):
     assert_raises_rpc_error (-8, "must be the literal string 'stat'",
                              self.node.name_filter, "", 0, 0, 0, "string")
 
+    # Prefix scans and paging with a cursor.
+    self.checkList (self.node.name_scan ("", 10, "a"), ["a", "aa"])
+    self.checkList (self.node.name_scan ("b", 10, "a"), ["aa"])
+    self.checkList (self.node.name_filter ("^a", 0), ["a", "aa"])
+    self.checkList (self.node.name_filter ("^a", 30), ["a"])
+    page = self.node.name_filter ("", 0, 0, 2, "", "")
+    self.checkList (page["names"], ["a", "b"])
+    page = self.node.name_filter ("", 0, 0, 2, "", page["cursor"])
+    self.checkList (page["names"], ["c", "aa"])
+    assert "cursor" not in page
+    assert_raises_rpc_error (-8, "cannot be combined with 'cursor'",
+                             self.node.name_filter, "", 0, 1, 0, "", "")
+
     # Include a name with invalid UTF-8 to make sure it doesn't break
     # name_filter's regexp check.
     self.restart_node (0, extra_args=["-nameencoding=hex"])
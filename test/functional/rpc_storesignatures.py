@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+"""Test storesignatures and checksignatureproof, including forged proofs."""
+
+import os
+
+from test_framework.messages import hash256
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal, assert_raises_rpc_error
+
+def leaf_hash(document):
+    return hash256(b"\x00" + document)
+
+def node_hash(left, right):
+    return hash256(b"\x01" + left + right)
+
+class StoreSignaturesTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def write_file(self, name, content):
+        path = os.path.join(self.options.tmpdir, name)
+        with open(path, 'wb') as f:
+            f.write(content)
+        return path
+
+    def run_test(self):
+        node = self.nodes[0]
+        node.generate(101)
+
+        documents = [self.write_file("doc%d" % i, b"document %d" % i) for i in range(3)]
+        res = node.storesignatures(documents)
+        txid = res["txid"]
+        assert_equal(res["count"], 3)
+        node.generate(1)
+
+        # every proof passes, at its own index only
+        for i, proof in enumerate(res["proofs"]):
+            assert_equal(proof["index"], i)
+            assert_equal(node.checksignatureproof(txid, documents[i], i, proof["branch"]), "PASS")
+            assert_equal(node.checksignatureproof(txid, documents[i], (i + 1) % 3, proof["branch"]), "FAIL")
+
+        # the tree is built from tagged leaves and nodes, the odd leaf moves up
+        leaves = [leaf_hash(bytes.fromhex(p["hash"])) for p in res["proofs"]]
+        assert_equal(bytes.fromhex(res["root"]), node_hash(node_hash(leaves[0], leaves[1]), leaves[2]))
+        assert_equal(res["proofs"][2]["branch"], [node_hash(leaves[0], leaves[1]).hex()])
+
+        # an index beyond the leaf count does not pass, even where the
+        # branch would lead to the same root
+        proof = res["proofs"][2]
+        assert_equal(node.checksignatureproof(txid, documents[2], 3, proof["branch"]), "FAIL")
+        assert_equal(node.checksignatureproof(txid, documents[2], 6, proof["branch"]), "FAIL")
+
+        # a 64-byte document made of two child hashes is not an inner node
+        forged = self.write_file("forged", leaves[0] + leaves[1])
+        assert_equal(node.checksignatureproof(txid, forged, 0, [leaves[2].hex()]), "FAIL")
+        assert_equal(node.checksignatureproof(txid, forged, 0, []), "FAIL")
+
+        # a digest is hashed as a tagged leaf, so an inner node given as a
+        # digest does not pass for the subtree below it
+        digest = node_hash(leaves[0], leaves[1]).hex()
+        assert_equal(node.checksignatureproof(txid, digest, 0, [leaves[2].hex()], True), "FAIL")
+
+        # without the digest flag, 64 hex characters are a file name like any other
+        assert_raises_rpc_error(-1, "Couldn't open the file", node.checksignatureproof, txid, digest, 0, [leaves[2].hex()])
+        assert_raises_rpc_error(-1, "Couldn't open the file", node.storesignatures, [digest])
+        assert_raises_rpc_error(-1, "digest must be a hex-encoded 32-byte hash", node.storesignatures, [{"document": documents[0], "digest": True}])
+
+        # files and digests mix in one commitment, a digest standing for its file
+        digests = [hash256(b"digest %d" % i) for i in range(2)]
+        mixed = [documents[0], {"document": digests[0].hex(), "digest": True},
+                 {"document": documents[1], "digest": False}, {"document": digests[1].hex(), "digest": True}]
+        mixed_res = node.storesignatures(mixed)
+        node.generate(1)
+        assert_equal(mixed_res["count"], 4)
+        assert_equal([p["document"] for p in mixed_res["proofs"]], [documents[0], digests[0].hex(), documents[1], digests[1].hex()])
+        mixed_hashes = [hash256(b"document 0"), digests[0], hash256(b"document 1"), digests[1]]
+        assert_equal([bytes.fromhex(p["hash"]) for p in mixed_res["proofs"]], mixed_hashes)
+        mixed_leaves = [leaf_hash(h) for h in mixed_hashes]
+        assert_equal(bytes.fromhex(mixed_res["root"]), node_hash(node_hash(mixed_leaves[0], mixed_leaves[1]), node_hash(mixed_leaves[2], mixed_leaves[3])))
+        for i, proof in enumerate(mixed_res["proofs"]):
+            assert_equal(node.checksignatureproof(mixed_res["txid"], proof["document"], i, proof["branch"], i % 2 == 1), "PASS")
+        # a file and the digest of its contents are the same document
+        assert_equal(node.checksignatureproof(mixed_res["txid"], hash256(b"document 0").hex(), 0, mixed_res["proofs"][0]["branch"], True), "PASS")
+
+        # a branch longer than the tree is deep does not pass
+        proof = res["proofs"][0]
+        assert_equal(node.checksignatureproof(txid, documents[0], 0, proof["branch"] + [leaves[2].hex()]), "FAIL")
+
+if __name__ == '__main__':
+    StoreSignaturesTest().main()
@@ -1,5 +1,8 @@
 #!/bin/sh
 
+echo "\nName database check..."
+./name_checkdb.py
+
 echo "\nName and value encodings..."
 ./name_encodings.py
 
@@ -33,6 +36,9 @@ echo "\nName registration..."
 echo "\nName reorgs..."
 ./name_reorg.py
 
+echo "\nName REST interface..."
+./name_rest.py
+
 echo "\nName scanning..."
 ./name_scanning.py
 
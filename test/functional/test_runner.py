@@ -138,6 +138,7 @@ BASE_SCRIPTS = [
     'wallet_importprunedfunds.py',
     'rpc_zmq.py',
     'rpc_signmessage.py',
+    'rpc_storesignatures.py',
     'feature_nulldummy.py',
     'mempool_accept.py',
     'wallet_import_rescan.py',
@@ -152,6 +153,7 @@ BASE_SCRIPTS = [
     'wallet_encryption.py',
     'feature_dersig.py',
     'feature_cltv.py',
+    'name_checkdb.py',
     'name_encodings.py',
     'name_expiration.py',
     'name_immature_inputs.py',
@@ -163,11 +165,14 @@ BASE_SCRIPTS = [
     'name_rawtx.py',
     'name_registration.py',
     'name_reorg.py',
+    'name_rest.py',
     'name_scanning.py',
     'name_sendcoins.py',
     'name_utxo.py',
     'name_wallet.py',
     'feature_games.py',
+    'feature_gamepool.py',
+    'feature_bettracker.py',
     'rpc_uptime.py',
     'wallet_resendwallettransactions.py',
     'wallet_fallbackfee.py',